@@ -0,0 +1,329 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#include "FakePool.h"
+#include "rapidjson/document.h"
+
+
+const char *FakePool::kBlob = "07074420823cfde6f1c26b30f90ec7dd01e4887534a20f0b0d04c36ed80e71e0fd77b07670eb94000000000bd5335f973daad8619b91ffc911f57cced458bbbf2ce03753c9bdfa0ff0169dc9";
+
+
+struct WriteReq
+{
+    std::string data;
+    uv_write_t req;
+};
+
+
+FakePool::FakePool() :
+    m_listening(false),
+    m_readRate(0),
+    m_bytes(0),
+    m_invalid(0),
+    m_jobs(0),
+    m_logins(0),
+    m_reads(0),
+    m_submits(0)
+{
+}
+
+
+int FakePool::listen(int port)
+{
+    if (m_listening) {
+        return -1;
+    }
+
+    sockaddr_in addr;
+    uv_ip4_addr("127.0.0.1", port, &addr);
+
+    uv_tcp_init(uv_default_loop(), &m_server);
+    m_server.data = this;
+
+    m_listening = true;
+
+    if (uv_tcp_bind(&m_server, reinterpret_cast<const sockaddr *>(&addr), 0) < 0 ||
+        uv_listen(reinterpret_cast<uv_stream_t *>(&m_server), 16, FakePool::onConnection) < 0) {
+        kill();
+        return -1;
+    }
+
+    int size = sizeof(addr);
+    uv_tcp_getsockname(&m_server, reinterpret_cast<sockaddr *>(&addr), &size);
+
+    return ntohs(addr.sin_port);
+}
+
+
+// Stops listening and drops every connection, listen() may be called again once the loop has run
+void FakePool::kill()
+{
+    if (!m_listening) {
+        return;
+    }
+
+    if (!uv_is_closing(reinterpret_cast<uv_handle_t *>(&m_server))) {
+        uv_close(reinterpret_cast<uv_handle_t *>(&m_server), FakePool::onKilled);
+    }
+
+    for (Peer *peer : m_peers) {
+        close(peer);
+    }
+}
+
+
+// Sends the next job to every connected miner
+void FakePool::notify()
+{
+    char buffer[512];
+    m_jobs++;
+
+    snprintf(buffer, sizeof(buffer),
+             "{\"jsonrpc\":\"2.0\",\"method\":\"job\",\"params\":{\"blob\":\"%s\",\"job_id\":\"%" PRIu64 "\",\"target\":\"b88d0600\",\"height\":%" PRIu64 "}}\n",
+             kBlob, m_jobs, m_jobs);
+
+    for (Peer *peer : m_peers) {
+        std::string data(buffer);
+        write(peer, data);
+    }
+}
+
+
+// Appends the response to one request line, returns false if the line is not a valid call
+bool FakePool::reply(Peer *peer, const char *line, size_t size, std::string &out)
+{
+    rapidjson::Document doc;
+    doc.Parse(line, size);
+
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("id") || !doc["id"].IsInt64() ||
+        !doc.HasMember("method") || !doc["method"].IsString()) {
+        return false;
+    }
+
+    const int64_t id = doc["id"].GetInt64();
+    char buffer[512];
+
+    if (strcmp(doc["method"].GetString(), "login") == 0) {
+        m_logins++;
+        m_jobs++;
+
+        // Client drops a login that repeats the job it already has, as a pool that lost its state would
+        snprintf(buffer, sizeof(buffer),
+                 "{\"id\":%" PRId64 ",\"jsonrpc\":\"2.0\",\"error\":null,\"result\":{\"id\":\"bench\",\"job\":"
+                 "{\"blob\":\"%s\",\"job_id\":\"%" PRIu64 "\",\"target\":\"b88d0600\"},\"status\":\"OK\"}}\n", id, kBlob, m_jobs);
+
+        out += buffer;
+        return true;
+    }
+
+    snprintf(buffer, sizeof(buffer), "{\"id\":%" PRId64 ",\"jsonrpc\":\"2.0\",\"error\":null,\"result\":{\"status\":\"OK\"}}\n", id);
+    out += buffer;
+
+    if (strcmp(doc["method"].GetString(), "submit") != 0) {
+        return true;
+    }
+
+    m_submits++;
+
+    if (!doc.HasMember("params") || !doc["params"].IsObject()) {
+        return false;
+    }
+
+    const rapidjson::Value &params = doc["params"];
+    const bool valid = params.HasMember("job_id") && params["job_id"].IsString() &&
+                       params.HasMember("nonce")  && params["nonce"].IsString()  && params["nonce"].GetStringLength() == 8 &&
+                       params.HasMember("result") && params["result"].IsString() && params["result"].GetStringLength() == 64;
+
+    // Client numbers its calls from one global sequence, a lower id means the write queue reordered lines
+    const bool ordered = id > peer->lastId;
+    peer->lastId = id;
+
+    return valid && ordered;
+}
+
+
+void FakePool::close(Peer *peer)
+{
+    if (uv_is_closing(reinterpret_cast<uv_handle_t *>(&peer->tcp))) {
+        return;
+    }
+
+    uv_close(reinterpret_cast<uv_handle_t *>(&peer->tcp), FakePool::onClose);
+    uv_close(reinterpret_cast<uv_handle_t *>(&peer->timer), FakePool::onClose);
+}
+
+
+void FakePool::receive(Peer *peer, const char *data, size_t size)
+{
+    m_bytes += size;
+    m_reads++;
+
+    peer->line.append(data, size);
+
+    std::string out;
+    size_t start = 0;
+
+    for (size_t end = peer->line.find('\n'); end != std::string::npos; end = peer->line.find('\n', start)) {
+        if (!reply(peer, peer->line.c_str() + start, end - start, out)) {
+            if (m_invalid++ == 0) {
+                fprintf(stderr, "fake pool: invalid line \"%.*s\"\n", static_cast<int>(std::min<size_t>(end - start, 120)), peer->line.c_str() + start);
+            }
+        }
+
+        start = end + 1;
+    }
+
+    peer->line.erase(0, start);
+
+    if (out.empty()) {
+        return;
+    }
+
+    write(peer, out);
+}
+
+
+// A throttled pool hands out small buffers and pauses after each read for as long as the rate allows
+void FakePool::onAlloc(uv_handle_t *handle, size_t, uv_buf_t *buf)
+{
+    Peer *peer = static_cast<Peer *>(handle->data);
+
+    buf->base = peer->recv;
+    buf->len  = sizeof(peer->recv);
+
+    if (peer->pool->m_readRate > 0) {
+        buf->len = std::max<size_t>(std::min<size_t>(peer->pool->m_readRate / 50, sizeof(peer->recv)), 1);
+    }
+}
+
+
+void FakePool::onClose(uv_handle_t *handle)
+{
+    Peer *peer = static_cast<Peer *>(handle->data);
+    if (--peer->handles > 0) {
+        return;
+    }
+
+    std::vector<Peer *> &peers = peer->pool->m_peers;
+    peers.erase(std::remove(peers.begin(), peers.end(), peer), peers.end());
+
+    delete peer;
+}
+
+
+void FakePool::onConnection(uv_stream_t *server, int status)
+{
+    FakePool *pool = static_cast<FakePool *>(server->data);
+    if (status < 0) {
+        return;
+    }
+
+    Peer *peer    = new Peer();
+    peer->pool    = pool;
+    peer->handles = 2;
+    peer->lastId  = 0;
+
+    uv_tcp_init(uv_default_loop(), &peer->tcp);
+    uv_timer_init(uv_default_loop(), &peer->timer);
+    peer->tcp.data   = peer;
+    peer->timer.data = peer;
+
+    pool->m_peers.push_back(peer);
+
+    if (uv_accept(server, reinterpret_cast<uv_stream_t *>(&peer->tcp)) < 0) {
+        return pool->close(peer);
+    }
+
+    // Cap the receive window of a slow pool, so the backlog stays with the sender
+    if (pool->m_readRate > 0) {
+        int size = 65536;
+        uv_recv_buffer_size(reinterpret_cast<uv_handle_t *>(&peer->tcp), &size);
+    }
+
+    uv_read_start(reinterpret_cast<uv_stream_t *>(&peer->tcp), FakePool::onAlloc, FakePool::onRead);
+}
+
+
+void FakePool::onKilled(uv_handle_t *handle)
+{
+    static_cast<FakePool *>(handle->data)->m_listening = false;
+}
+
+
+void FakePool::onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    Peer *peer     = static_cast<Peer *>(stream->data);
+    FakePool *pool = peer->pool;
+
+    if (nread < 0) {
+        return pool->close(peer);
+    }
+
+    if (nread == 0) {
+        return;
+    }
+
+    pool->receive(peer, buf->base, static_cast<size_t>(nread));
+
+    if (pool->m_readRate > 0) {
+        uv_read_stop(stream);
+        uv_timer_start(&peer->timer, FakePool::onResume, std::max<uint64_t>(static_cast<uint64_t>(nread) * 1000 / pool->m_readRate, 1), 0);
+    }
+}
+
+
+void FakePool::onResume(uv_timer_t *handle)
+{
+    Peer *peer = static_cast<Peer *>(handle->data);
+
+    uv_read_start(reinterpret_cast<uv_stream_t *>(&peer->tcp), FakePool::onAlloc, FakePool::onRead);
+}
+
+
+void FakePool::onWrite(uv_write_t *req, int)
+{
+    delete static_cast<WriteReq *>(req->data);
+}
+
+
+void FakePool::write(Peer *peer, std::string &data)
+{
+    if (uv_is_closing(reinterpret_cast<uv_handle_t *>(&peer->tcp))) {
+        return;
+    }
+
+    WriteReq *req = new WriteReq();
+    req->data.swap(data);
+    req->req.data = req;
+
+    uv_buf_t buf = uv_buf_init(&req->data[0], static_cast<unsigned int>(req->data.size()));
+    uv_write(&req->req, reinterpret_cast<uv_stream_t *>(&peer->tcp), &buf, 1, FakePool::onWrite);
+}
@@ -0,0 +1,98 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_FAKEPOOL_H
+#define XMRIG_FAKEPOOL_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <uv.h>
+#include <vector>
+
+
+/* Stratum pool on a loopback port for the harnesses: answers login with a job and every other call with OK, new jobs are sent on demand.
+ * Submits are checked to be well formed and sent in order, reads can be throttled to play a slow pool, and the pool can be killed
+ * and started again on the same port to play a failing one. */
+class FakePool
+{
+public:
+    FakePool();
+
+    int listen(int port = 0);
+    void kill();
+    void notify();
+
+    inline bool isListening() const     { return m_listening; }
+    inline bool isValid() const         { return m_invalid == 0; }
+    inline size_t connections() const   { return m_peers.size(); }
+    inline uint64_t bytes() const       { return m_bytes; }
+    inline uint64_t logins() const      { return m_logins; }
+    inline uint64_t reads() const       { return m_reads; }
+    inline uint64_t submits() const     { return m_submits; }
+    inline void setReadRate(size_t rate) { m_readRate = rate; }
+
+    static const char *kBlob;
+
+private:
+    struct Peer
+    {
+        char recv[65536];
+        FakePool *pool;
+        int handles;
+        int64_t lastId;
+        std::string line;
+        uv_tcp_t tcp;
+        uv_timer_t timer;
+    };
+
+    bool reply(Peer *peer, const char *line, size_t size, std::string &out);
+    void close(Peer *peer);
+    void receive(Peer *peer, const char *data, size_t size);
+
+    static void onAlloc(uv_handle_t *handle, size_t suggested, uv_buf_t *buf);
+    static void onClose(uv_handle_t *handle);
+    static void onConnection(uv_stream_t *server, int status);
+    static void onKilled(uv_handle_t *handle);
+    static void onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
+    static void onResume(uv_timer_t *handle);
+    static void onWrite(uv_write_t *req, int status);
+
+    static void write(Peer *peer, std::string &data);
+
+    bool m_listening;
+    size_t m_readRate;
+    std::vector<Peer *> m_peers;
+    uint64_t m_bytes;
+    uint64_t m_invalid;
+    uint64_t m_jobs;
+    uint64_t m_logins;
+    uint64_t m_reads;
+    uint64_t m_submits;
+    uv_tcp_t m_server;
+};
+
+
+#endif /* XMRIG_FAKEPOOL_H */
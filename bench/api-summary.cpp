@@ -0,0 +1,317 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Hammers GET /1/summary of a running miner over keep-alive connections and checks that every body is valid JSON
+ *
+ * usage: bench-api <host> <port> [requests=10000] [connections=4] [access-token]
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <uv.h>
+#include <vector>
+
+
+#include "rapidjson/document.h"
+
+
+#ifdef _MSC_VER
+#   define strncasecmp(x,y,z) _strnicmp(x,y,z)
+#endif
+
+
+struct Connection
+{
+    inline Connection() : busy(false), sent(0) {}
+
+    bool busy;
+    std::string response;
+    uint64_t sent;
+    uv_connect_t connect;
+    uv_tcp_t tcp;
+    uv_write_t write;
+};
+
+
+static bool failed          = false;
+static size_t completed     = 0;
+static size_t invalid       = 0;
+static size_t reconnects    = 0;
+static size_t requests      = 10000;
+static size_t started       = 0;
+static sockaddr_in address;
+static std::string request;
+static std::vector<uint64_t> latencies;
+static uint64_t bodyBytes   = 0;
+
+
+static void connectTo(Connection *connection);
+static void sendRequest(Connection *connection);
+
+
+static void onAlloc(uv_handle_t *, size_t suggested, uv_buf_t *buf)
+{
+    buf->base = new char[suggested];
+    buf->len  = suggested;
+}
+
+
+static void onClose(uv_handle_t *handle)
+{
+    Connection *connection = static_cast<Connection *>(handle->data);
+
+    // the server may close a keep-alive connection at any time, a request in flight is sent again
+    if (connection->busy) {
+        started--;
+    }
+
+    delete connection;
+
+    if (!failed && reconnects == requests) {
+        fprintf(stderr, "server keeps closing connections without a response\n");
+        failed = true;
+    }
+
+    if (!failed && started < requests) {
+        reconnects++;
+        connectTo(new Connection());
+    }
+}
+
+
+static void closeConnection(Connection *connection)
+{
+    if (!uv_is_closing(reinterpret_cast<uv_handle_t *>(&connection->tcp))) {
+        uv_close(reinterpret_cast<uv_handle_t *>(&connection->tcp), onClose);
+    }
+}
+
+
+static void check(const char *body, size_t size, int status)
+{
+    bodyBytes += size;
+
+    if (status != 200) {
+        if (invalid++ == 0) {
+            fprintf(stderr, "HTTP status %d\n", status);
+        }
+
+        return;
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(body, size);
+
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("hashrate") || !doc["hashrate"].IsObject()) {
+        if (invalid++ == 0) {
+            const size_t offset = doc.HasParseError() ? doc.GetErrorOffset() : 0;
+            fprintf(stderr, "invalid summary at offset %zu: %.*s\n", offset, static_cast<int>(std::min<size_t>(size - offset, 80)), body + offset);
+        }
+    }
+}
+
+
+// Returns true once a complete response is buffered, responses without Content-Length are not supported
+static bool parse(Connection *connection, bool &keepAlive)
+{
+    const std::string &response = connection->response;
+    const size_t end = response.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return false;
+    }
+
+    int status    = 0;
+    size_t length = 0;
+    keepAlive     = true;
+
+    sscanf(response.c_str(), "HTTP/%*d.%*d %d", &status);
+
+    for (size_t pos = response.find("\r\n"); pos < end; pos = response.find("\r\n", pos + 2)) {
+        const char *line = response.c_str() + pos + 2;
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            length = strtoul(line + 15, nullptr, 10);
+        }
+        else if (strncasecmp(line, "Connection: close", 17) == 0) {
+            keepAlive = false;
+        }
+    }
+
+    if (response.size() < end + 4 + length) {
+        return false;
+    }
+
+    check(response.c_str() + end + 4, length, status);
+
+    return true;
+}
+
+
+static void onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    Connection *connection = static_cast<Connection *>(stream->data);
+
+    if (nread < 0) {
+        delete [] buf->base;
+
+        return closeConnection(connection);
+    }
+
+    connection->response.append(buf->base, static_cast<size_t>(nread));
+    delete [] buf->base;
+
+    bool keepAlive = true;
+    if (!connection->busy || !parse(connection, keepAlive)) {
+        return;
+    }
+
+    latencies.push_back(uv_hrtime() - connection->sent);
+    connection->busy = false;
+    completed++;
+
+    if (!keepAlive) {
+        return closeConnection(connection);
+    }
+
+    sendRequest(connection);
+}
+
+
+static void onWrite(uv_write_t *req, int status)
+{
+    if (status < 0) {
+        closeConnection(static_cast<Connection *>(req->data));
+    }
+}
+
+
+static void sendRequest(Connection *connection)
+{
+    if (started == requests) {
+        return closeConnection(connection);
+    }
+
+    started++;
+
+    connection->busy = true;
+    connection->sent = uv_hrtime();
+    connection->response.clear();
+    connection->write.data = connection;
+
+    uv_buf_t buf = uv_buf_init(const_cast<char *>(request.data()), static_cast<unsigned int>(request.size()));
+    uv_write(&connection->write, reinterpret_cast<uv_stream_t *>(&connection->tcp), &buf, 1, onWrite);
+}
+
+
+static void onConnect(uv_connect_t *req, int status)
+{
+    Connection *connection = static_cast<Connection *>(req->data);
+
+    if (status < 0) {
+        if (!failed) {
+            fprintf(stderr, "connect failed: %s\n", uv_strerror(status));
+            failed = true;
+        }
+
+        return closeConnection(connection);
+    }
+
+    uv_read_start(reinterpret_cast<uv_stream_t *>(&connection->tcp), onAlloc, onRead);
+    sendRequest(connection);
+}
+
+
+static void connectTo(Connection *connection)
+{
+    uv_tcp_init(uv_default_loop(), &connection->tcp);
+    uv_tcp_nodelay(&connection->tcp, 1);
+
+    connection->tcp.data     = connection;
+    connection->connect.data = connection;
+
+    uv_tcp_connect(&connection->connect, &connection->tcp, reinterpret_cast<const sockaddr *>(&address), onConnect);
+}
+
+
+static double percentile(double p)
+{
+    const size_t i = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+
+    return latencies[i] / 1e6;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <host> <port> [requests=10000] [connections=4] [access-token]\n", argv[0]);
+        return 1;
+    }
+
+    if (uv_ip4_addr(argv[1], atoi(argv[2]), &address) < 0) {
+        fprintf(stderr, "invalid address %s:%s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    requests                 = argc > 3 ? strtoul(argv[3], nullptr, 10) : requests;
+    const size_t connections = argc > 4 ? strtoul(argv[4], nullptr, 10) : 4;
+
+    request = "GET /1/summary HTTP/1.1\r\nHost: ";
+    request += argv[1];
+    request += "\r\n";
+
+    if (argc > 5) {
+        request += "Authorization: Bearer ";
+        request += argv[5];
+        request += "\r\n";
+    }
+
+    request += "\r\n";
+    latencies.reserve(requests);
+
+    for (size_t i = 0; i < std::max<size_t>(connections, 1); ++i) {
+        connectTo(new Connection());
+    }
+
+    const uint64_t start = uv_hrtime();
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    const double elapsed = (uv_hrtime() - start) / 1e9;
+
+    if (completed == 0) {
+        fprintf(stderr, "no responses\n");
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%zu requests in %.2f s, %.0f req/s, %zu reconnects\n", completed, elapsed, completed / elapsed, reconnects);
+    printf("latency ms: p50 %.3f, p99 %.3f, max %.3f\n", percentile(0.5), percentile(0.99), latencies.back() / 1e6);
+    printf("body %" PRIu64 " bytes avg, %zu invalid\n", bodyBytes / completed, invalid);
+
+    return (failed || invalid > 0) ? 1 : 0;
+}
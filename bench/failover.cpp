@@ -0,0 +1,297 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* FailoverStrategy against fake pools that are killed on demand: how long the GPUs idle when the active pool dies,
+ * with and without hot standby
+ *
+ * usage: check-failover
+ *
+ * Three pools, retries 2 and a retry pause of 1 s. Without standby the primary is killed once. With one standby the
+ * primary is killed, started again, and then killed together with the standby, so the cold third pool has to take over.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <uv.h>
+#include <vector>
+
+
+#include "FakePool.h"
+#include "base/net/Pool.h"
+#include "common/interfaces/IStrategyListener.h"
+#include "common/net/Client.h"
+#include "common/net/strategies/FailoverStrategy.h"
+#include "common/Platform.h"
+
+
+using namespace xmrig;
+
+
+static const int kPools      = 3;
+static const int kRetries    = 2;
+static const int kRetryPause = 1;
+static const uint64_t kLimit = 15 * 1000;
+
+
+class Check : public IStrategyListener
+{
+public:
+    inline Check(int standby) :
+        m_failed(false),
+        m_standby(standby),
+        m_step(0),
+        m_active(-1),
+        m_jobFrom(-1),
+        m_pauses(0),
+        m_idle(0),
+        m_idleSince(0),
+        m_jobTime(0),
+        m_stepTime(0),
+        m_strategy(nullptr)
+    {}
+
+
+    bool run()
+    {
+        std::vector<Pool> pools;
+
+        for (int i = 0; i < kPools; ++i) {
+            m_pools[i] = new FakePool();
+            m_ports[i] = m_pools[i]->listen();
+
+            if (m_ports[i] < 0) {
+                fprintf(stderr, "fake pool failed to listen\n");
+                return false;
+            }
+
+            pools.push_back(Pool("127.0.0.1", static_cast<uint16_t>(m_ports[i]), "check", "x"));
+            pools.back().adjust(Algorithm(CRYPTONIGHT, VARIANT_2));
+        }
+
+        m_strategy = new FailoverStrategy(pools, kRetryPause, kRetries, this, true, m_standby);
+
+        uv_timer_init(uv_default_loop(), &m_timer);
+        m_timer.data = this;
+        uv_timer_start(&m_timer, Check::onTimer, 10, 10);
+
+        m_stepTime = now();
+        m_strategy->connect();
+
+        uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+        return !m_failed;
+    }
+
+protected:
+    void onActive(IStrategy *, Client *client) override
+    {
+        m_active = client->id();
+    }
+
+
+    void onJob(IStrategy *, Client *client, const Job &) override
+    {
+        m_jobFrom = client->id();
+        m_jobTime = now();
+
+        if (m_idleSince) {
+            m_idle     += m_jobTime - m_idleSince;
+            m_idleSince = 0;
+        }
+    }
+
+
+    void onPause(IStrategy *) override
+    {
+        m_pauses++;
+
+        if (!m_idleSince) {
+            m_idleSince = now();
+        }
+    }
+
+
+    void onResultAccepted(IStrategy *, Client *, const SubmitResult &, const char *) override {}
+
+private:
+    // microseconds
+    static inline uint64_t now() { return uv_hrtime() / 1000; }
+
+
+    static void onTimer(uv_timer_t *handle)
+    {
+        Check *check = static_cast<Check *>(handle->data);
+
+        check->m_strategy->tick(uv_now(uv_default_loop()));
+        check->poll();
+    }
+
+
+    bool expect(bool condition, const char *message)
+    {
+        if (!condition) {
+            fprintf(stderr, "standby %d: %s\n", m_standby, message);
+            m_failed = true;
+        }
+
+        return condition;
+    }
+
+
+    void kill(int index)
+    {
+        m_pools[index]->kill();
+    }
+
+
+    void next()
+    {
+        m_step++;
+        m_pauses   = 0;
+        m_idle     = 0;
+        m_stepTime = now();
+    }
+
+
+    // Every step waits for a state, checks it and triggers the next failure
+    void poll()
+    {
+        if (now() - m_stepTime > kLimit * 1000) {
+            char message[64];
+            snprintf(message, sizeof(message), "timed out in step %d with pool %d active", m_step, m_active);
+
+            expect(false, message);
+            return finish();
+        }
+
+        switch (m_step) {
+        case 0:
+            if (m_active != 0 || m_jobFrom != 0 || (m_standby > 0 && m_pools[1]->logins() == 0)) {
+                return;
+            }
+
+            expect(m_pools[2]->logins() == 0, "cold pool logged in");
+            kill(0);
+            return next();
+
+        case 1:
+            if (m_active != 1 || m_jobFrom != 1) {
+                return;
+            }
+
+            printf("standby %d: primary killed, %" PRIu64 " pauses, GPUs idle %.1f ms, job from pool 1 after %.1f ms\n",
+                   m_standby, m_pauses, m_idle / 1e3, (m_jobTime - m_stepTime) / 1e3);
+
+            if (m_standby == 0) {
+                expect(m_pauses > 0, "no pause without standby");
+                return finish();
+            }
+
+            expect(m_pauses == 0 && m_idle == 0, "GPUs paused although a standby was ready");
+            return next();
+
+        case 2:
+            if (m_pools[0]->isListening()) {
+                return;
+            }
+
+            if (!expect(m_pools[0]->listen(m_ports[0]) == m_ports[0], "primary failed to listen again")) {
+                return finish();
+            }
+
+            return next();
+
+        case 3:
+            if (m_active != 0 || m_jobFrom != 0) {
+                return;
+            }
+
+            printf("standby %d: primary back, active again after %.1f ms\n", m_standby, (now() - m_stepTime) / 1e3);
+            expect(m_pauses == 0, "GPUs paused while the primary came back");
+
+            if (m_pools[1]->logins() == 0) {
+                return;
+            }
+
+            kill(0);
+            kill(1);
+            return next();
+
+        case 4:
+            if (m_active != 2 || m_jobFrom != 2) {
+                return;
+            }
+
+            printf("standby %d: primary and standby killed, %" PRIu64 " pauses, GPUs idle %.1f ms until the cold pool 2\n",
+                   m_standby, m_pauses, m_idle / 1e3);
+
+            expect(m_pauses > 0, "no pause although no standby was left");
+            return finish();
+        }
+    }
+
+
+    void finish()
+    {
+        uv_timer_stop(&m_timer);
+        m_strategy->stop();
+
+        for (int i = 0; i < kPools; ++i) {
+            kill(i);
+        }
+
+        uv_close(reinterpret_cast<uv_handle_t *>(&m_timer), nullptr);
+        uv_stop(uv_default_loop());
+    }
+
+    bool m_failed;
+    const int m_standby;
+    FakePool *m_pools[kPools];
+    int m_ports[kPools];
+    int m_step;
+    int m_active;
+    int m_jobFrom;
+    uint64_t m_pauses;
+    uint64_t m_idle;
+    uint64_t m_idleSince;
+    uint64_t m_jobTime;
+    uint64_t m_stepTime;
+    FailoverStrategy *m_strategy;
+    uv_timer_t m_timer;
+};
+
+
+int main()
+{
+    Platform::init("check-failover");
+
+    Check classic(0);
+    bool ok = classic.run();
+
+    Check standby(1);
+    ok = standby.run() && ok;
+
+    printf(ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Fake stratum pools for testing a miner by hand, commands are read from stdin one per line:
+ *
+ *   kill <n>        stop pool n and drop its miners
+ *   start <n>       listen again on the port of pool n
+ *   job             send a new job to every miner
+ *   rate <n> <B/s>  throttle reads of pool n, 0 reads at full speed
+ *   stats           print logins, submits and bytes per pool
+ *
+ * usage: fake-pool <port> [port...]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <uv.h>
+#include <vector>
+
+
+#include "FakePool.h"
+
+
+static std::string input;
+static std::vector<FakePool *> pools;
+static std::vector<int> ports;
+
+
+static FakePool *pool(const char *arg)
+{
+    const size_t index = arg ? strtoul(arg, nullptr, 10) : pools.size();
+    if (index >= pools.size()) {
+        printf("no pool %s\n", arg ? arg : "");
+        return nullptr;
+    }
+
+    return pools[index];
+}
+
+
+static void command(char *line)
+{
+    const char *name = strtok(line, " \t\r");
+    const char *arg  = strtok(nullptr, " \t\r");
+
+    if (!name) {
+        return;
+    }
+
+    if (strcmp(name, "job") == 0) {
+        for (FakePool *p : pools) {
+            p->notify();
+        }
+    }
+    else if (strcmp(name, "stats") == 0) {
+        for (size_t i = 0; i < pools.size(); ++i) {
+            printf("pool %zu :%d %s, %zu miners, %" PRIu64 " logins, %" PRIu64 " submits, %" PRIu64 " bytes%s\n", i, ports[i],
+                   pools[i]->isListening() ? "up" : "down", pools[i]->connections(), pools[i]->logins(), pools[i]->submits(),
+                   pools[i]->bytes(), pools[i]->isValid() ? "" : ", invalid submits seen");
+        }
+    }
+    else if (strcmp(name, "kill") == 0 || strcmp(name, "start") == 0 || strcmp(name, "rate") == 0) {
+        FakePool *target = pool(arg);
+        if (!target) {
+            return;
+        }
+
+        if (name[0] == 'k') {
+            target->kill();
+        }
+        else if (name[0] == 's') {
+            const int port = ports[strtoul(arg, nullptr, 10)];
+
+            if (target->listen(port) != port) {
+                printf("pool %s failed to listen on %d\n", arg, port);
+            }
+        }
+        else {
+            const char *rate = strtok(nullptr, " \t\r");
+            target->setReadRate(rate ? strtoul(rate, nullptr, 10) : 0);
+        }
+    }
+    else {
+        printf("unknown command \"%s\"\n", name);
+    }
+
+    fflush(stdout);
+}
+
+
+static void onAlloc(uv_handle_t *, size_t suggested, uv_buf_t *buf)
+{
+    buf->base = new char[suggested];
+    buf->len  = suggested;
+}
+
+
+static void onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    if (nread < 0) {
+        delete [] buf->base;
+        uv_close(reinterpret_cast<uv_handle_t *>(stream), nullptr);
+
+        for (FakePool *p : pools) {
+            p->kill();
+        }
+
+        return;
+    }
+
+    input.append(buf->base, static_cast<size_t>(nread));
+    delete [] buf->base;
+
+    for (size_t end = input.find('\n'); end != std::string::npos; end = input.find('\n')) {
+        std::string line = input.substr(0, end);
+        input.erase(0, end + 1);
+
+        command(&line[0]);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <port> [port...]\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        FakePool *p    = new FakePool();
+        const int port = p->listen(atoi(argv[i]));
+
+        if (port < 0) {
+            fprintf(stderr, "failed to listen on %s\n", argv[i]);
+            return 1;
+        }
+
+        printf("pool %d listening on 127.0.0.1:%d\n", i - 1, port);
+
+        pools.push_back(p);
+        ports.push_back(port);
+    }
+
+    fflush(stdout);
+
+    uv_pipe_t in;
+    uv_pipe_init(uv_default_loop(), &in, 0);
+    uv_pipe_open(&in, 0);
+    uv_read_start(reinterpret_cast<uv_stream_t *>(&in), onAlloc, onRead);
+
+    return uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
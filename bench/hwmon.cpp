@@ -0,0 +1,375 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Hwmon and GpuSensors against a fake sysfs tree: discovery by PCI address, values per card, in-place re-reads and
+ * how fast a changed sensor reaches the snapshot
+ *
+ * usage: check-hwmon
+ *
+ * Bus 03 exists in domains 0000 and 0001, the lower domain has to win. Bus 07 only has power1_input, bus 09 has
+ * no card at all. The GpuSensors part runs for a little over Hashrate::ShortInterval.
+ */
+
+#include <chrono>
+#include <fcntl.h>
+#include <ftw.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+#include "amd/GpuContext.h"
+#include "amd/GpuSensors.h"
+#include "amd/Hwmon.h"
+#include "common/utils/timestamp.h"
+#include "workers/Hashrate.h"
+
+
+static int failures = 0;
+
+
+#define CHECK(x, fmt, ...) \
+    if (!(x)) { \
+        fprintf(stderr, "FAILED %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+        failures++; \
+    }
+
+
+struct Card
+{
+    const char *address;
+    const char *hwmon;
+    const char *power;
+    int temperature;
+    int pwm;
+    int microwatts;
+    int busy;
+};
+
+
+static const Card cards[] = {
+    { "0000:03:00.0", "hwmon2", "power1_average", 61000, 100, 120000000, 97 },
+    { "0001:03:00.0", "hwmon0", "power1_average", 43000, 200, 30000000,  12 },
+    { "0000:07:00.0", "hwmon1", "power1_input",   55000, 150, 95000000,  88 }
+};
+
+
+// One sample period of GpuSensors, plus the 50 ms sleep granularity of its thread and scheduling jitter
+static const int64_t kPeriod = 1000;
+static const int64_t kSlack  = 100;
+
+
+static std::string root;
+
+
+static void makeDir(const std::string &path)
+{
+    if (mkdir(path.c_str(), 0755) != 0) {
+        fprintf(stderr, "mkdir %s failed\n", path.c_str());
+        exit(1);
+    }
+}
+
+
+// Truncates and rewrites the same inode, like sysfs regenerating an attribute
+static void writeFile(const std::string &path, int value)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "open %s failed\n", path.c_str());
+        exit(1);
+    }
+
+    fprintf(file, "%d\n", value);
+    fclose(file);
+}
+
+
+static int readFile(const std::string &path)
+{
+    int value  = -1;
+    FILE *file = fopen(path.c_str(), "r");
+    if (file) {
+        if (fscanf(file, "%d", &value) != 1) {
+            value = -1;
+        }
+
+        fclose(file);
+    }
+
+    return value;
+}
+
+
+static std::string devicePath(const Card &card)
+{
+    return root + "/bus/pci/devices/" + card.address;
+}
+
+
+static std::string hwmonPath(const Card &card)
+{
+    return devicePath(card) + "/hwmon/" + card.hwmon;
+}
+
+
+// bus/pci/devices/<d:b:d.f>/{gpu_busy_percent,hwmon/hwmonN/{temp1_input,pwm1,pwm1_enable,power1_*}}, plus a host bridge without hwmon
+static void build()
+{
+    char temp[] = "/tmp/check-hwmon.XXXXXX";
+    if (!mkdtemp(temp)) {
+        fprintf(stderr, "mkdtemp failed\n");
+        exit(1);
+    }
+
+    root = temp;
+    makeDir(root + "/bus");
+    makeDir(root + "/bus/pci");
+    makeDir(root + "/bus/pci/devices");
+    makeDir(root + "/bus/pci/devices/0000:00:00.0");
+
+    for (const Card &card : cards) {
+        makeDir(devicePath(card));
+        makeDir(devicePath(card) + "/hwmon");
+        makeDir(hwmonPath(card));
+
+        writeFile(devicePath(card) + "/gpu_busy_percent", card.busy);
+        writeFile(hwmonPath(card) + "/temp1_input", card.temperature);
+        writeFile(hwmonPath(card) + "/pwm1", card.pwm);
+        writeFile(hwmonPath(card) + "/pwm1_enable", 2);
+        writeFile(hwmonPath(card) + "/" + card.power, card.microwatts);
+    }
+}
+
+
+static int removeEntry(const char *path, const struct stat *, int, struct FTW *)
+{
+    return ::remove(path);
+}
+
+
+static void cleanup()
+{
+    nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+
+static void discovery()
+{
+    for (const Card &card : { cards[0], cards[2] }) {
+        uint32_t bus = 0;
+        sscanf(card.address, "%*x:%x", &bus);
+
+        Hwmon hwmon;
+        CHECK(hwmon.open(root.c_str(), bus, 0, 0), "bus %02x not found", bus);
+        CHECK(hwmon.address() == std::string(card.address), "bus %02x mapped to %s, expected %s", bus, hwmon.address(), card.address);
+        CHECK(hwmon.path() == hwmonPath(card), "bus %02x uses %s, expected %s", bus, hwmon.path(), hwmonPath(card).c_str());
+        CHECK(hwmon.isPwmWritable(), "pwm1 of %s is not writable", card.address);
+
+        int temperature = -1;
+        int pwm         = -1;
+        int microwatts  = -1;
+        int busy        = -1;
+
+        CHECK(hwmon.temperature(temperature) && temperature == card.temperature, "%s temperature %d, expected %d", card.address, temperature, card.temperature);
+        CHECK(hwmon.pwm(pwm) && pwm == card.pwm, "%s pwm %d, expected %d", card.address, pwm, card.pwm);
+        CHECK(hwmon.power(microwatts) && microwatts == card.microwatts, "%s power %d, expected %d", card.address, microwatts, card.microwatts);
+        CHECK(hwmon.busy(busy) && busy == card.busy, "%s busy %d, expected %d", card.address, busy, card.busy);
+    }
+
+    Hwmon missing;
+    CHECK(!missing.open(root.c_str(), 0x09, 0, 0), "bus 09 found at %s", missing.address());
+    CHECK(!missing.open(root.c_str(), 0x00, 0, 0), "host bridge without hwmon accepted");
+}
+
+
+// The nodes stay open: a file rewritten in place is seen by the next pread, a file replaced by a new inode is not
+static void reread()
+{
+    const Card &card = cards[0];
+    const std::string temp1 = hwmonPath(card) + "/temp1_input";
+
+    Hwmon hwmon;
+    CHECK(hwmon.open(root.c_str(), 0x03, 0, 0), "bus 03 not found");
+
+    int temperature = -1;
+    for (int value : { 104000, 9000, 72000 }) {
+        writeFile(temp1, value);
+        CHECK(hwmon.temperature(temperature) && temperature == value, "temperature %d after rewrite, expected %d", temperature, value);
+    }
+
+    writeFile(temp1 + ".new", 80000);
+    rename((temp1 + ".new").c_str(), temp1.c_str());
+    CHECK(hwmon.temperature(temperature) && temperature == 72000, "temperature %d after replace, expected the open node to keep 72000", temperature);
+
+    CHECK(hwmon.setPwmEnable(1), "pwm1_enable not written");
+    CHECK(hwmon.setPwm(180), "pwm1 not written");
+    CHECK(readFile(hwmonPath(card) + "/pwm1_enable") == 1, "pwm1_enable is %d, expected 1", readFile(hwmonPath(card) + "/pwm1_enable"));
+    CHECK(readFile(hwmonPath(card) + "/pwm1") == 180, "pwm1 is %d, expected 180", readFile(hwmonPath(card) + "/pwm1"));
+
+    int pwm = -1;
+    CHECK(hwmon.pwm(pwm) && pwm == 180, "pwm %d after write, expected 180", pwm);
+
+    writeFile(temp1, card.temperature);
+    writeFile(hwmonPath(card) + "/pwm1", card.pwm);
+    writeFile(hwmonPath(card) + "/pwm1_enable", 2);
+}
+
+
+// Consistent pair of snapshot and average, retried if a sample was published in between
+static bool snapshot(size_t deviceIdx, GpuSensors::Sample &sample, GpuSensors::Average &average)
+{
+    GpuSensors::Sample check;
+
+    do {
+        if (!GpuSensors::read(deviceIdx, sample) || !GpuSensors::average(deviceIdx, Hashrate::ShortInterval, average)) {
+            return false;
+        }
+    } while (!GpuSensors::read(deviceIdx, check) || check.timestamp != sample.timestamp);
+
+    return true;
+}
+
+
+static bool waitFirst(size_t deviceIdx, GpuSensors::Sample &sample)
+{
+    const int64_t deadline = xmrig::steadyTimestamp() + kPeriod + kSlack;
+
+    while (!GpuSensors::read(deviceIdx, sample)) {
+        if (xmrig::steadyTimestamp() > deadline) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    return true;
+}
+
+
+// The service thread samples card 0 on bus 03 and card 1 on bus 07, the GPU index must map to the right card
+static void sensors()
+{
+    std::vector<GpuContext> contexts(2);
+    std::vector<GpuContext *> pointers;
+
+    contexts[0].deviceIdx       = 0;
+    contexts[0].device_pciBusID = 0x03;
+    contexts[1].deviceIdx       = 1;
+    contexts[1].device_pciBusID = 0x07;
+
+    for (GpuContext &ctx : contexts) {
+        pointers.push_back(&ctx);
+    }
+
+    GpuSensors::Sample sample;
+    GpuSensors::Average average;
+
+    GpuSensors::start(pointers, root.c_str());
+
+    // The fan level is moved by the cooling policy before it is published, the temperature is passed through as is
+    int64_t first = 0;
+
+    for (size_t i = 0; i < contexts.size(); ++i) {
+        const Card &card = cards[i == 0 ? 0 : 2];
+
+        CHECK(waitFirst(i, sample), "no sample for GPU #%zu within %" PRId64 " ms", i, kPeriod + kSlack);
+        CHECK(sample.temperature == card.temperature / 1000, "GPU #%zu temperature %d, expected %d", i, sample.temperature, card.temperature / 1000);
+
+        if (i == 0) {
+            first = sample.timestamp;
+        }
+    }
+
+    CHECK(!GpuSensors::read(2, sample), "GPU #2 does not exist");
+    CHECK(!GpuSensors::average(0, 5000, average), "5000 ms is not a Hashrate window");
+
+    if (failures > 0) {
+        GpuSensors::stop();
+        return;
+    }
+
+    // A rewritten sensor file has to show up in the snapshot no later than the next sample
+    writeFile(hwmonPath(cards[0]) + "/temp1_input", 70000);
+
+    const int64_t changed = xmrig::steadyTimestamp();
+    while (GpuSensors::read(0, sample) && sample.temperature != 70 && xmrig::steadyTimestamp() - changed <= kPeriod + kSlack) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    const int64_t latency = xmrig::steadyTimestamp() - changed;
+    CHECK(sample.temperature == 70, "temperature %d %" PRId64 " ms after the change, expected 70", sample.temperature, latency);
+    printf("temperature change seen after %" PRId64 " ms\n", latency);
+
+    // NaN while the history is shorter than the window, a number from the first sample that covers it
+    while (true) {
+        if (!snapshot(0, sample, average)) {
+            CHECK(false, "no snapshot for GPU #0");
+            break;
+        }
+
+        const int64_t history = sample.timestamp - first;
+        if (history >= Hashrate::ShortInterval) {
+            CHECK(isnormal(average.temperature) && average.temperature >= 61.0 && average.temperature <= 70.0, "average temperature %.2f after %" PRId64 " ms of history", average.temperature, history);
+            printf("short window covered after %" PRId64 " ms of history\n", history);
+            break;
+        }
+
+        // -Ofast implies finite math, isnan() folds to false, the API tells a missing average apart with isnormal() as well
+        CHECK(!isnormal(average.temperature) && !isnormal(average.fan) && !isnormal(average.power) && !isnormal(average.busy), "average %.2f %.2f %.2f %.2f after %" PRId64 " ms of history, expected NaN", average.temperature, average.fan, average.power, average.busy, history);
+
+        if (failures > 0 || xmrig::steadyTimestamp() - first > Hashrate::ShortInterval + kPeriod + kSlack) {
+            CHECK(failures > 0, "no sample covers the short window after %" PRId64 " ms", xmrig::steadyTimestamp() - first);
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    GpuSensors::stop();
+}
+
+
+int main()
+{
+    build();
+    discovery();
+    reread();
+    sensors();
+    cleanup();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d failures\n", failures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
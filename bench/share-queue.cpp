@@ -0,0 +1,222 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Shares per second from 1 to 32 GPU threads into one consumer, the mutex protected std::list of Job copies Workers
+ * used before against ShareQueue
+ *
+ * usage: bench-share-queue [shares=1000000]
+ *
+ * The consumer busy polls instead of waiting for uv_async_send, so only the queues are measured. Every share is
+ * checked to arrive exactly once and in order per producer.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <uv.h>
+#include <vector>
+
+
+#include "common/net/Job.h"
+#include "workers/ShareQueue.h"
+
+
+using namespace xmrig;
+
+
+static ShareQueue queue;
+static const char *kBlob = "07074420823cfde6f1c26b30f90ec7dd01e4887534a20f0b0d04c36ed80e71e0fd77b07670eb94000000000bd5335f973daad8619b91ffc911f57cced458bbbf2ce03753c9bdfa0ff0169dc9";
+
+
+class Legacy
+{
+public:
+    inline bool pop(Job &job)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+
+        job = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        return true;
+    }
+
+
+    inline void push(const Job &job)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(job);
+    }
+
+private:
+    std::list<Job> m_queue;
+    std::mutex m_mutex;
+};
+
+
+// Tracks the next expected nonce of every producer, returns false on a lost, duplicated or reordered share
+class Checker
+{
+public:
+    inline Checker(size_t producers) : m_next(producers, 0) {}
+
+    inline bool add(uint32_t threadId, uint32_t nonce)
+    {
+        if (threadId >= m_next.size() || m_next[threadId] != nonce) {
+            return false;
+        }
+
+        m_next[threadId]++;
+        return true;
+    }
+
+private:
+    std::vector<uint32_t> m_next;
+};
+
+
+// The ring is static like Workers::m_shares, every run drains it completely
+static double runRing(size_t producers, size_t perProducer, bool &ok)
+{
+    std::atomic<size_t> ready(0);
+    std::vector<std::thread> threads;
+
+    const uint64_t start = uv_hrtime();
+
+    for (size_t i = 0; i < producers; ++i) {
+        threads.emplace_back([=, &ready]() {
+            ready++;
+
+            for (size_t n = 0; n < perProducer; ++n) {
+                const ShareQueue::Share share = { nullptr, static_cast<uint32_t>(n), static_cast<uint32_t>(i) };
+
+                while (!queue.push(share)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    Checker checker(producers);
+    ShareQueue::Share share;
+    const size_t total = producers * perProducer;
+
+    for (size_t received = 0; received < total;) {
+        if (!queue.pop(share)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ok = checker.add(share.threadId, share.nonce) && ok;
+        received++;
+    }
+
+    const double elapsed = (uv_hrtime() - start) / 1e9;
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return total / elapsed;
+}
+
+
+static double runLegacy(const Job &job, size_t producers, size_t perProducer, bool &ok)
+{
+    Legacy legacy;
+    std::vector<std::thread> threads;
+
+    const uint64_t start = uv_hrtime();
+
+    for (size_t i = 0; i < producers; ++i) {
+        threads.emplace_back([=, &legacy]() {
+            Job result(job);
+            result.setThreadId(static_cast<int>(i));
+
+            for (size_t n = 0; n < perProducer; ++n) {
+                *result.nonce() = static_cast<uint32_t>(n);
+                legacy.push(result);
+            }
+        });
+    }
+
+    Checker checker(producers);
+    Job result;
+    const size_t total = producers * perProducer;
+
+    for (size_t received = 0; received < total;) {
+        if (!legacy.pop(result)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ok = checker.add(static_cast<uint32_t>(result.threadId()), *result.nonce()) && ok;
+        received++;
+    }
+
+    const double elapsed = (uv_hrtime() - start) / 1e9;
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return total / elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+    const size_t shares = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+    Job job(0, false, Algorithm(CRYPTONIGHT, VARIANT_2), Id("bench"));
+    job.setBlob(kBlob);
+    job.setTarget("b88d0600");
+
+    bool ok = true;
+
+    printf("producers  list Mshares/s  ring Mshares/s  speedup\n");
+
+    for (size_t producers : { 1, 2, 4, 8, 16, 32 }) {
+        const size_t perProducer = std::max<size_t>(shares / producers, 1);
+
+        const double legacy = runLegacy(job, producers, perProducer, ok);
+        const double ring   = runRing(producers, perProducer, ok);
+
+        printf("%9zu  %15.2f  %14.2f  %6.2fx\n", producers, legacy / 1e6, ring / 1e6, ring / legacy);
+    }
+
+    if (!ok) {
+        printf("lost, duplicated or reordered shares\n");
+        return 1;
+    }
+
+    return 0;
+}
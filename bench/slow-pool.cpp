@@ -0,0 +1,301 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Client::submit against a pool that reads slowly: every share must still be delivered once and in order,
+ * the connection must stay up and the backlog must be reported instead of dropped
+ *
+ * usage: check-slow-pool [shares=5000] [bytes per second=1048576]
+ *
+ * Batches of 64 submits are queued every millisecond like Workers::onResult does when GPUs find shares faster than
+ * the pool takes them. Every submit must get its response, a backlog is no reason to lose a result.
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+
+#include "FakePool.h"
+#include "base/net/Pool.h"
+#include "common/interfaces/IClientListener.h"
+#include "common/interfaces/ILogBackend.h"
+#include "common/log/Log.h"
+#include "common/net/Client.h"
+#include "common/net/SubmitResult.h"
+#include "net/JobResult.h"
+
+
+using namespace xmrig;
+
+
+static const size_t kBatch   = 64;
+static const uint64_t kLimit = 30 * 1000;
+
+
+// Counts the slow pool warnings of Client
+class Backend : public ILogBackend
+{
+public:
+    inline Backend() : warnings(0) {}
+
+    void message(Level level, const char *fmt, va_list) override
+    {
+        if (level == WARNING && strstr(fmt, "reading slowly")) {
+            warnings++;
+        }
+    }
+
+    void text(const char *, va_list) override {}
+
+    uint64_t warnings;
+};
+
+
+static Backend *backend = nullptr;
+
+
+class Check : public IClientListener
+{
+public:
+    inline Check(const FakePool &pool, uint64_t shares) :
+        m_closed(false),
+        m_port(0),
+        m_accepted(0),
+        m_rejected(0),
+        m_shares(shares),
+        m_submitted(0),
+        m_client(nullptr),
+        m_pool(pool)
+    {}
+
+
+    bool run(int port)
+    {
+        m_port = port;
+
+        Pool pool("127.0.0.1", static_cast<uint16_t>(port), "check", "x");
+        pool.adjust(Algorithm(CRYPTONIGHT, VARIANT_2));
+
+        uv_timer_init(uv_default_loop(), &m_batch);
+        uv_timer_init(uv_default_loop(), &m_done);
+        uv_timer_init(uv_default_loop(), &m_limit);
+        m_batch.data = this;
+        m_done.data  = this;
+        m_limit.data = this;
+
+        uv_timer_start(&m_limit, Check::onLimit, kLimit, 0);
+        uv_timer_start(&m_done, Check::onDone, 10, 10);
+
+        m_client = new Client(0, "check-slow-pool", this);
+        m_client->setQuiet(true);
+        m_client->connect(pool);
+
+        uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+        if (m_closed) {
+            fprintf(stderr, "connection closed after %" PRIu64 " of %" PRIu64 " accepted\n", m_accepted, m_shares);
+        }
+
+        if (m_rejected > 0) {
+            fprintf(stderr, "%" PRIu64 " shares rejected\n", m_rejected);
+        }
+
+        if (m_accepted + m_rejected < m_shares) {
+            fprintf(stderr, "%" PRIu64 " of %" PRIu64 " submits got no response\n", m_shares - m_accepted - m_rejected, m_shares);
+        }
+
+        return !m_closed && m_rejected == 0 && m_accepted == m_shares;
+    }
+
+protected:
+    void onClose(Client *, int) override
+    {
+        m_closed = true;
+        stop();
+    }
+
+
+    void onJobReceived(Client *, const Job &job) override
+    {
+        m_job = job;
+
+        uv_walk(uv_default_loop(), Check::onWalk, &m_port);
+        uv_timer_start(&m_batch, Check::onBatch, 0, 1);
+    }
+
+
+    void onLoginSuccess(Client *) override {}
+
+
+    void onResultAccepted(Client *, const SubmitResult &, const char *error) override
+    {
+        if (error) {
+            m_rejected++;
+        }
+        else {
+            m_accepted++;
+        }
+
+    }
+
+private:
+    static void onBatch(uv_timer_t *handle)
+    {
+        static_cast<Check *>(handle->data)->submit();
+    }
+
+
+    // Shrinks the send buffer of the socket Client connected to the pool, so the backlog is held by its write queue and not by the kernel
+    static void onWalk(uv_handle_t *handle, void *arg)
+    {
+        sockaddr_in addr;
+        int size = sizeof(addr);
+
+        if (handle->type != UV_TCP || uv_tcp_getpeername(reinterpret_cast<uv_tcp_t *>(handle), reinterpret_cast<sockaddr *>(&addr), &size) < 0 ||
+            ntohs(addr.sin_port) != *static_cast<int *>(arg)) {
+            return;
+        }
+
+        int buffer = 4096;
+        uv_send_buffer_size(handle, &buffer);
+    }
+
+
+    // Done once the pool has every submit and every one of them is answered
+    static void onDone(uv_timer_t *handle)
+    {
+        Check *check = static_cast<Check *>(handle->data);
+
+        if (check->m_pool.submits() == check->m_shares && check->m_accepted + check->m_rejected == check->m_shares) {
+            check->stop();
+        }
+    }
+
+
+    static void onLimit(uv_timer_t *handle)
+    {
+        fprintf(stderr, "no answer to all shares within %" PRIu64 " s\n", kLimit / 1000);
+        static_cast<Check *>(handle->data)->stop();
+    }
+
+
+    void stop()
+    {
+        uv_timer_stop(&m_batch);
+        uv_timer_stop(&m_done);
+        uv_timer_stop(&m_limit);
+        uv_stop(uv_default_loop());
+    }
+
+
+    void submit()
+    {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(kBatch, m_shares - m_submitted));
+
+        for (size_t i = 0; i < count; ++i) {
+            JobResult result(m_job);
+            result.nonce = static_cast<uint32_t>(m_submitted + i);
+            memset(result.result, static_cast<int>(i + 1), sizeof(result.result));
+
+            m_client->submit(result);
+        }
+
+        m_submitted += count;
+
+        if (m_submitted == m_shares) {
+            uv_timer_stop(&m_batch);
+        }
+    }
+
+    bool m_closed;
+    int m_port;
+    Job m_job;
+    uint64_t m_accepted;
+    uint64_t m_rejected;
+    uint64_t m_shares;
+    uint64_t m_submitted;
+    Client *m_client;
+    const FakePool &m_pool;
+    uv_timer_t m_batch;
+    uv_timer_t m_done;
+    uv_timer_t m_limit;
+};
+
+
+int main(int argc, char **argv)
+{
+    const uint64_t shares = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000;
+    const size_t rate     = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1024 * 1024;
+
+    if (shares == 0 || rate == 0) {
+        fprintf(stderr, "usage: %s [shares=5000] [bytes per second=1048576]\n", argv[0]);
+        return 1;
+    }
+
+    backend = new Backend();
+
+    Log::init();
+    Log::add(backend);
+
+    FakePool pool;
+    pool.setReadRate(rate);
+
+    const int port = pool.listen();
+    if (port < 0) {
+        fprintf(stderr, "fake pool failed to listen\n");
+        return 1;
+    }
+
+    const uint64_t start = uv_hrtime();
+    Check check(pool, shares);
+    bool ok = check.run(port);
+    const double elapsed = (uv_hrtime() - start) / 1e9;
+
+    printf("%" PRIu64 " submits in %.2f s, pool read %" PRIu64 " KB in %" PRIu64 " reads, %.0f KB/s\n",
+           pool.submits(), elapsed, pool.bytes() / 1024, pool.reads(), pool.bytes() / 1024 / elapsed);
+    printf("%" PRIu64 " slow pool warnings\n", backend->warnings);
+
+    if (!pool.isValid()) {
+        fprintf(stderr, "malformed or reordered submits\n");
+        ok = false;
+    }
+
+    if (pool.submits() != shares) {
+        fprintf(stderr, "pool received %" PRIu64 " of %" PRIu64 " submits\n", pool.submits(), shares);
+        ok = false;
+    }
+
+    // The backlog only builds up if the pool takes longer than a second, which is what the defaults are for
+    if (backend->warnings == 0 && pool.bytes() > rate) {
+        fprintf(stderr, "no slow pool warning\n");
+        ok = false;
+    }
+
+    printf(ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
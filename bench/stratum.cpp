@@ -0,0 +1,367 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stratum receive path: line parsing with the rapidjson Document Client used before against StratumMessage, the scalar
+ * hex decoder against Job::fromHex, and the time Client takes from reading a job off the socket to handing it on
+ *
+ * usage: bench-stratum [iterations=1000000]
+ *
+ * The decoders are compared on random input of every length first, any difference fails the run.
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+#include <vector>
+
+
+#include "FakePool.h"
+#include "base/net/Pool.h"
+#include "common/interfaces/IClientListener.h"
+#include "common/net/Client.h"
+#include "common/net/Job.h"
+#include "common/net/StratumMessage.h"
+#include "rapidjson/document.h"
+
+
+using namespace xmrig;
+
+
+static const char *kHex = "0123456789abcdefABCDEF";
+
+
+struct Fields
+{
+    const char *algo;
+    const char *blob;
+    const char *id;
+    const char *target;
+    uint64_t height;
+};
+
+
+// Job::fromHex before SSE2
+static bool scalarFromHex(const char *in, unsigned int len, unsigned char *out)
+{
+    bool error = false;
+
+    auto hex2bin = [&error](char c) -> unsigned char {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 0xA;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 0xA;
+        }
+
+        error = true;
+        return 0;
+    };
+
+    for (unsigned int i = 0; i < len; i += 2) {
+        out[i / 2] = (hex2bin(in[i]) << 4) | hex2bin(in[i + 1]);
+
+        if (error) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Client::parse and Client::parseJob before StratumMessage, up to the Job setters
+static bool documentParse(char *line, Fields &fields)
+{
+    rapidjson::Document doc;
+    if (doc.ParseInsitu(line).HasParseError() || !doc.IsObject()) {
+        return false;
+    }
+
+    const rapidjson::Value &id = doc["id"];
+    if (id.IsInt64()) {
+        return doc["result"].IsObject() && doc["error"].IsNull();
+    }
+
+    const rapidjson::Value &params = doc["params"];
+    if (strcmp(doc["method"].GetString(), "job") != 0 || !params.IsObject()) {
+        return false;
+    }
+
+    fields.id     = params["job_id"].GetString();
+    fields.blob   = params["blob"].GetString();
+    fields.target = params["target"].GetString();
+    fields.algo   = params.HasMember("algo") ? params["algo"].GetString() : nullptr;
+    fields.height = params.HasMember("height") && params["height"].IsUint64() ? params["height"].GetUint64() : 0;
+
+    return true;
+}
+
+
+static bool messageParse(char *line, Fields &fields)
+{
+    StratumMessage msg;
+    if (!msg.parse(line)) {
+        return false;
+    }
+
+    if (msg.isResponse()) {
+        return msg.hasResult() && !msg.hasError();
+    }
+
+    if (!msg.hasJob()) {
+        return false;
+    }
+
+    fields.id     = msg.job().id;
+    fields.blob   = msg.job().blob;
+    fields.target = msg.job().target;
+    fields.algo   = msg.job().algo;
+    fields.height = msg.job().height;
+
+    return true;
+}
+
+
+static int checkHex()
+{
+    std::vector<char> in(256);
+    unsigned char expected[128];
+    unsigned char actual[128];
+    int failures = 0;
+
+    srand(1);
+
+    for (unsigned int len = 0; len <= in.size(); len += 2) {
+        for (int round = 0; round < 200; ++round) {
+            for (unsigned int i = 0; i < len; ++i) {
+                in[i] = kHex[rand() % 22];
+            }
+
+            // Every other round one character is replaced with a byte that is not a hex digit
+            if (len > 0 && round % 2) {
+                const char bad[] = { 'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80', '\xff' };
+                in[rand() % len] = bad[rand() % sizeof(bad)];
+            }
+
+            memset(expected, 0, sizeof(expected));
+            memset(actual, 0, sizeof(actual));
+
+            const bool a = scalarFromHex(in.data(), len, expected);
+            const bool b = Job::fromHex(in.data(), len, actual);
+
+            if (a != b || (a && memcmp(expected, actual, len / 2) != 0)) {
+                if (failures++ == 0) {
+                    fprintf(stderr, "fromHex differs for \"%.*s\"\n", static_cast<int>(len), in.data());
+                }
+            }
+        }
+    }
+
+    return failures;
+}
+
+
+template<typename Parse>
+static double parseRate(Parse parse, const char *line, uint64_t iterations, Fields &fields)
+{
+    const size_t size = strlen(line) + 1;
+    std::vector<char> buf(size);
+
+    const uint64_t start = uv_hrtime();
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        memcpy(buf.data(), line, size);
+
+        if (!parse(buf.data(), fields)) {
+            return 0.0;
+        }
+    }
+
+    return iterations / ((uv_hrtime() - start) / 1e9);
+}
+
+
+template<typename Decode>
+static double hexRate(Decode decode, const char *hex, uint64_t iterations)
+{
+    const unsigned int len = static_cast<unsigned int>(strlen(hex));
+    unsigned char out[128];
+    uint64_t sum = 0;
+
+    const uint64_t start = uv_hrtime();
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        decode(hex, len, out);
+        sum += out[i % (len / 2)];
+    }
+
+    const double elapsed = (uv_hrtime() - start) / 1e9;
+
+    // keeps the compiler from dropping the loop
+    if (sum == UINT64_MAX) {
+        printf("\n");
+    }
+
+    return iterations / elapsed;
+}
+
+
+// Times every job notification from the libuv read callback of Client to onJobReceived
+class Switch : public IClientListener
+{
+public:
+    inline Switch(FakePool &pool, size_t jobs) : m_jobs(jobs), m_client(nullptr), m_pool(pool) {}
+
+
+    void run(int port)
+    {
+        Pool pool("127.0.0.1", static_cast<uint16_t>(port), "bench", "x");
+        pool.adjust(Algorithm(CRYPTONIGHT, VARIANT_2));
+
+        m_latencies.reserve(m_jobs);
+
+        m_client = new Client(0, "bench-stratum", this);
+        m_client->setQuiet(true);
+        m_client->connect(pool);
+
+        uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    }
+
+
+    void print()
+    {
+        if (m_latencies.empty()) {
+            printf("job switch: no jobs received\n");
+            return;
+        }
+
+        std::sort(m_latencies.begin(), m_latencies.end());
+
+        printf("job switch, socket read to onJobReceived: %zu jobs, p50 %.2f us, p99 %.2f us, max %.2f us\n", m_latencies.size(),
+               m_latencies[m_latencies.size() / 2] / 1e3, m_latencies[m_latencies.size() * 99 / 100] / 1e3, m_latencies.back() / 1e3);
+    }
+
+    inline bool isDone() const { return m_latencies.size() == m_jobs; }
+
+protected:
+    void onClose(Client *, int) override
+    {
+        uv_stop(uv_default_loop());
+    }
+
+
+    void onJobReceived(Client *, const Job &job) override
+    {
+        // the login reply carries the first job, only notifications are timed
+        if (job.height() > 0) {
+            m_latencies.push_back(uv_hrtime() - job.received());
+        }
+
+        if (isDone()) {
+            m_client->disconnect();
+            return;
+        }
+
+        m_pool.notify();
+    }
+
+
+    void onLoginSuccess(Client *) override {}
+    void onResultAccepted(Client *, const SubmitResult &, const char *) override {}
+
+private:
+    size_t m_jobs;
+    Client *m_client;
+    FakePool &m_pool;
+    std::vector<uint64_t> m_latencies;
+};
+
+
+int main(int argc, char **argv)
+{
+    const uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations=1000000]\n", argv[0]);
+        return 1;
+    }
+
+    const int failures = checkHex();
+    if (failures > 0) {
+        fprintf(stderr, "%d fromHex mismatches\n", failures);
+        return 1;
+    }
+
+    char job[512];
+    snprintf(job, sizeof(job), "{\"jsonrpc\":\"2.0\",\"method\":\"job\",\"params\":{\"blob\":\"%s\",\"job_id\":\"123456789\",\"target\":\"b88d0600\","
+                               "\"algo\":\"cn/r\",\"height\":1806260}}", FakePool::kBlob);
+
+    const char *response = "{\"id\":42,\"jsonrpc\":\"2.0\",\"error\":null,\"result\":{\"status\":\"OK\"}}";
+
+    Fields before = {};
+    Fields after  = {};
+
+    const double docJob = parseRate(documentParse, job, iterations, before);
+    const double msgJob = parseRate(messageParse, job, iterations, after);
+
+    if (docJob == 0.0 || msgJob == 0.0 || strcmp(before.blob, after.blob) != 0 || strcmp(before.id, after.id) != 0 ||
+        strcmp(before.target, after.target) != 0 || strcmp(before.algo, after.algo) != 0 || before.height != after.height) {
+        fprintf(stderr, "job notification parsed differently\n");
+        return 1;
+    }
+
+    const double docResponse = parseRate(documentParse, response, iterations, before);
+    const double msgResponse = parseRate(messageParse, response, iterations, after);
+
+    if (docResponse == 0.0 || msgResponse == 0.0) {
+        fprintf(stderr, "submit response not parsed\n");
+        return 1;
+    }
+
+    const double scalar = hexRate(scalarFromHex, FakePool::kBlob, iterations);
+    const double sse2   = hexRate(Job::fromHex, FakePool::kBlob, iterations);
+
+    printf("                     before (lines/s)  after (lines/s)  speedup\n");
+    printf("job notification     %16.0f  %15.0f  %6.2fx\n", docJob, msgJob, msgJob / docJob);
+    printf("submit response      %16.0f  %15.0f  %6.2fx\n", docResponse, msgResponse, msgResponse / docResponse);
+    printf("blob hex (%3zu chars) %16.0f  %15.0f  %6.2fx\n", strlen(FakePool::kBlob), scalar, sse2, sse2 / scalar);
+
+    FakePool pool;
+    const int port = pool.listen();
+    if (port < 0) {
+        fprintf(stderr, "fake pool failed to listen\n");
+        return 1;
+    }
+
+    Switch bench(pool, static_cast<size_t>(std::min<uint64_t>(iterations / 100 + 1, 10000)));
+    bench.run(port);
+    bench.print();
+
+    return bench.isDone() ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Randomized check of SubmitTable against std::map, the reference it replaced in Client
+ *
+ * usage: check-submit-table [rounds=200000] [seed]
+ */
+
+#include <inttypes.h>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#include "common/net/SubmitTable.h"
+
+
+using namespace xmrig;
+
+
+static int failures = 0;
+
+
+#define CHECK(x, fmt, ...) \
+    if (!(x)) { \
+        fprintf(stderr, "FAILED %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+        failures++; \
+    }
+
+
+static bool equal(const SubmitResult &a, const SubmitResult &b)
+{
+    return a.seq == b.seq && a.diff == b.diff && a.actualDiff == b.actualDiff && a.threadId == b.threadId;
+}
+
+
+// A cluster that wraps around the end of the slot array: taking its first entry must move the others back into place,
+// a deletion that leaves a gap makes every entry behind it unreachable
+static void backwardShift()
+{
+    SubmitTable table;
+    SubmitResult result;
+
+    const int64_t capacity = SubmitTable::kInitialCapacity;
+    const int64_t seqs[]   = { capacity - 1, 2 * capacity - 1, 3 * capacity - 1, capacity, 4 * capacity - 1 };
+
+    for (int64_t seq : seqs) {
+        table.insert(SubmitResult(seq, 1, 1));
+    }
+
+    CHECK(table.take(capacity - 1, result) && result.seq == capacity - 1, "take head of the wrapped cluster");
+
+    for (size_t i = 1; i < sizeof(seqs) / sizeof(seqs[0]); ++i) {
+        CHECK(table.take(seqs[i], result) && result.seq == seqs[i], "%" PRId64 " unreachable after backward shift", seqs[i]);
+    }
+
+    CHECK(table.size() == 0, "size %zu after taking everything", table.size());
+
+    // The entry at its home slot must stay, only entries displaced past the gap move
+    table.insert(SubmitResult(1, 1, 1));
+    table.insert(SubmitResult(1 + capacity, 1, 1));
+    table.insert(SubmitResult(2, 1, 1));
+    CHECK(table.take(1, result), "take 1");
+    CHECK(table.take(2, result) && result.seq == 2, "2 lost after backward shift");
+    CHECK(table.take(1 + capacity, result) && result.seq == 1 + capacity, "1 + capacity lost after backward shift");
+}
+
+
+// A backlog far beyond the initial slots must keep every entry, at most half of the slots may be used
+static void growth()
+{
+    SubmitTable table;
+    SubmitResult result;
+
+    const int64_t count = SubmitTable::kInitialCapacity * 20;
+
+    for (int64_t seq = 0; seq < count; ++seq) {
+        table.insert(SubmitResult(seq * 7, 1, 1));
+
+        CHECK(table.size() * 2 <= table.capacity(), "%zu entries in %zu slots", table.size(), table.capacity());
+    }
+
+    CHECK(table.size() == static_cast<size_t>(count), "size %zu after %" PRId64 " inserts", table.size(), count);
+    CHECK((table.capacity() & (table.capacity() - 1)) == 0, "capacity %zu is not a power of two", table.capacity());
+
+    table.insert(SubmitResult(7, 2, 2));
+    CHECK(table.size() == static_cast<size_t>(count), "replacing grew the size to %zu", table.size());
+    CHECK(!table.take(-1, result), "take a missing key from a grown table");
+
+    for (int64_t seq = 0; seq < count; ++seq) {
+        CHECK(table.take(seq * 7, result) && result.seq == seq * 7, "%" PRId64 " lost after growing", seq * 7);
+    }
+
+    CHECK(result.diff == 1 && table.size() == 0, "size %zu after taking everything", table.size());
+
+    const size_t capacity = table.capacity();
+    table.clear();
+    CHECK(table.capacity() == capacity, "clear released the slots");
+}
+
+
+// Mostly growing sequences like a pool connection, with random keys and random gaps mixed in to force collisions
+static void randomized(uint64_t rounds, uint32_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::map<int64_t, SubmitResult> reference;
+    SubmitTable table;
+    SubmitResult result;
+    int64_t sequence = 0;
+
+    for (uint64_t round = 0; round < rounds && failures == 0; ++round) {
+        const uint32_t op = rng() % 100;
+
+        if (op < 45) {
+            const int64_t seq = (rng() % 4 == 0) ? static_cast<int64_t>(rng() % 4096) : ++sequence;
+            const SubmitResult submit(seq, static_cast<uint32_t>(rng()), rng(), 0, static_cast<int>(rng() % 16));
+
+            table.insert(submit);
+            reference[seq] = submit;
+        }
+        else if (op < 90 && !reference.empty()) {
+            auto it = reference.begin();
+            std::advance(it, rng() % reference.size());
+
+            CHECK(table.take(it->first, result) && equal(result, it->second), "round %" PRIu64 ": take %" PRId64, round, it->first);
+            reference.erase(it);
+        }
+        else {
+            const int64_t seq = static_cast<int64_t>(rng() % 8192);
+            const bool taken  = table.take(seq, result);
+
+            CHECK(taken == (reference.count(seq) > 0), "round %" PRIu64 ": take %" PRId64 " returned %d", round, seq, taken);
+            if (taken) {
+                CHECK(equal(result, reference[seq]), "round %" PRIu64 ": take %" PRId64 " returned another entry", round, seq);
+                reference.erase(seq);
+            }
+        }
+
+        CHECK(table.size() == reference.size(), "round %" PRIu64 ": size %zu, expected %zu", round, table.size(), reference.size());
+
+        if (rng() % 50000 == 0) {
+            table.clear();
+            reference.clear();
+        }
+    }
+
+    for (const auto &entry : reference) {
+        CHECK(table.take(entry.first, result) && equal(result, entry.second), "final take %" PRId64, entry.first);
+    }
+
+    CHECK(table.size() == 0, "size %zu after draining", table.size());
+}
+
+
+int main(int argc, char **argv)
+{
+    const uint64_t rounds = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    const uint32_t seed   = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : std::random_device()();
+
+    // A broken table can loop forever in a later phase, stop at the first one that fails
+    backwardShift();
+
+    if (failures == 0) {
+        growth();
+    }
+
+    if (failures == 0) {
+        randomized(rounds, seed);
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "%d failures, seed %u\n", failures, seed);
+        return 1;
+    }
+
+    printf("OK, %" PRIu64 " rounds, seed %u\n", rounds, seed);
+    return 0;
+}
@@ -0,0 +1,337 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Serialized submits per second and heap allocations per share, the rapidjson path Client used before against Client::submit
+ *
+ * usage: bench-submit [shares=200000]
+ *
+ * Client::submit runs against a fake pool on a loopback socket in the same process and the pool answers every submit,
+ * only the time and the allocations inside the submit calls are counted.
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <map>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <uv.h>
+
+
+#include "FakePool.h"
+#include "base/net/Pool.h"
+#include "common/interfaces/IClientListener.h"
+#include "common/net/Client.h"
+#include "common/net/SubmitResult.h"
+#include "net/JobResult.h"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+
+using namespace xmrig;
+
+
+static bool counting        = false;
+static uint64_t allocations = 0;
+
+
+void *operator new(size_t size)
+{
+    if (counting) {
+        allocations++;
+    }
+
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+
+static const size_t kBatch = 64;
+
+
+// Client::submit and Client::send(Document) before the direct formatter
+class Legacy
+{
+public:
+    inline Legacy() : m_sequence(1) {}
+
+    void submit(const JobResult &result, const char *rpcId)
+    {
+        using namespace rapidjson;
+
+        char *nonce = m_sendBuf;
+        char *data  = m_sendBuf + 16;
+
+        Job::toHex(reinterpret_cast<const unsigned char*>(&result.nonce), 4, nonce);
+        nonce[8] = '\0';
+
+        Job::toHex(result.result, 32, data);
+        data[64] = '\0';
+
+        Document doc(kObjectType);
+        auto &allocator = doc.GetAllocator();
+
+        doc.AddMember("id",      m_sequence, allocator);
+        doc.AddMember("jsonrpc", "2.0", allocator);
+        doc.AddMember("method",  "submit", allocator);
+
+        Value params(kObjectType);
+        params.AddMember("id",     StringRef(rpcId), allocator);
+        params.AddMember("job_id", StringRef(result.jobId.data()), allocator);
+        params.AddMember("nonce",  StringRef(nonce), allocator);
+        params.AddMember("result", StringRef(data), allocator);
+
+        doc.AddMember("params", params, allocator);
+
+        m_results[m_sequence] = SubmitResult(m_sequence, result.diff, result.actualDiff());
+
+        StringBuffer buffer(0, 512);
+        Writer<StringBuffer> writer(buffer);
+        doc.Accept(writer);
+
+        const size_t size = buffer.GetSize();
+        memcpy(m_sendBuf, buffer.GetString(), size);
+        m_sendBuf[size]     = '\n';
+        m_sendBuf[size + 1] = '\0';
+
+        m_sequence++;
+    }
+
+    // The pool answered everything that is outstanding
+    inline void accept() { m_results.clear(); }
+
+private:
+    char m_sendBuf[2048];
+    int64_t m_sequence;
+    std::map<int64_t, SubmitResult> m_results;
+};
+
+
+class Bench : public IClientListener
+{
+public:
+    inline Bench(uint64_t shares) :
+        m_accepted(0),
+        m_allocations(0),
+        m_elapsed(0),
+        m_rejected(0),
+        m_shares(shares),
+        m_submitted(0),
+        m_client(nullptr)
+    {}
+
+
+    void run(int port)
+    {
+        Pool pool("127.0.0.1", static_cast<uint16_t>(port), "bench", "x");
+        pool.adjust(Algorithm(CRYPTONIGHT, VARIANT_2));
+
+        m_client = new Client(0, "bench-submit", this);
+        m_client->setQuiet(true);
+        m_client->connect(pool);
+
+        uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    }
+
+
+    void print() const
+    {
+        printf("after:  Client::submit\n");
+        printf("        %.0f submits/s, %.2f allocations per share, %" PRIu64 " accepted, %" PRIu64 " rejected\n",
+               m_submitted / (m_elapsed / 1e9), static_cast<double>(m_allocations) / m_submitted, m_accepted, m_rejected);
+    }
+
+protected:
+    void onClose(Client *, int) override
+    {
+        if (m_submitted < m_shares) {
+            fprintf(stderr, "connection to the fake pool closed after %" PRIu64 " submits\n", m_submitted);
+            uv_stop(uv_default_loop());
+        }
+    }
+
+
+    void onJobReceived(Client *, const Job &job) override
+    {
+        m_job = job;
+
+        submit();
+    }
+
+
+    void onLoginSuccess(Client *) override {}
+
+
+    void onResultAccepted(Client *, const SubmitResult &, const char *error) override
+    {
+        if (error) {
+            m_rejected++;
+        }
+        else {
+            m_accepted++;
+        }
+
+        if (m_accepted + m_rejected < m_submitted) {
+            return;
+        }
+
+        if (m_submitted < m_shares) {
+            return submit();
+        }
+
+        uv_stop(uv_default_loop());
+    }
+
+private:
+    void submit()
+    {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(kBatch, m_shares - m_submitted));
+        JobResult results[kBatch];
+
+        for (size_t i = 0; i < count; ++i) {
+            JobResult result(m_job);
+            result.nonce = static_cast<uint32_t>(m_submitted + i);
+            memset(result.result, static_cast<int>(i + 1), sizeof(result.result));
+
+            results[i] = result;
+        }
+
+        counting = true;
+        allocations = 0;
+        const uint64_t start = uv_hrtime();
+
+        for (size_t i = 0; i < count; ++i) {
+            m_client->submit(results[i]);
+        }
+
+        m_elapsed += uv_hrtime() - start;
+        counting = false;
+
+        m_allocations += allocations;
+        m_submitted   += count;
+    }
+
+    Job m_job;
+    uint64_t m_accepted;
+    uint64_t m_allocations;
+    uint64_t m_elapsed;
+    uint64_t m_rejected;
+    uint64_t m_shares;
+    uint64_t m_submitted;
+    Client *m_client;
+};
+
+
+static void legacy(uint64_t shares)
+{
+    Job job(0, false, Algorithm(CRYPTONIGHT, VARIANT_2), Id("bench"));
+    job.setId("1");
+    job.setBlob(FakePool::kBlob);
+    job.setTarget("b88d0600");
+
+    Legacy client;
+    JobResult results[kBatch];
+    uint64_t elapsed   = 0;
+    uint64_t submitted = 0;
+
+    allocations = 0;
+
+    while (submitted < shares) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(kBatch, shares - submitted));
+
+        for (size_t i = 0; i < count; ++i) {
+            JobResult result(job);
+            result.nonce = static_cast<uint32_t>(submitted + i);
+            memset(result.result, static_cast<int>(i + 1), sizeof(result.result));
+
+            results[i] = result;
+        }
+
+        counting = true;
+        const uint64_t start = uv_hrtime();
+
+        for (size_t i = 0; i < count; ++i) {
+            client.submit(results[i], "bench");
+        }
+
+        elapsed += uv_hrtime() - start;
+        counting = false;
+
+        client.accept();
+        submitted += count;
+    }
+
+    printf("before: rapidjson Document, StringBuffer and std::map\n");
+    printf("        %.0f submits/s, %.2f allocations per share\n", submitted / (elapsed / 1e9), static_cast<double>(allocations) / submitted);
+}
+
+
+int main(int argc, char **argv)
+{
+    const uint64_t shares = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    if (shares == 0) {
+        fprintf(stderr, "usage: %s [shares=200000]\n", argv[0]);
+        return 1;
+    }
+
+    legacy(shares);
+
+    FakePool pool;
+    const int port = pool.listen();
+    if (port < 0) {
+        fprintf(stderr, "fake pool failed to listen\n");
+        return 1;
+    }
+
+    Bench bench(shares);
+    bench.run(port);
+    bench.print();
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Drives ThermalController with a simulated card and checks that it holds maxtemp
+ *
+ * usage: check-thermal
+ *
+ * The card is a first order model: at duty d it heads for ambient + d * (full load rise) with time constant tau.
+ * The sensor reports whole degrees a few seconds late, the controller is updated once per second like in Thermal.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <stdio.h>
+
+
+#include "workers/ThermalController.h"
+
+
+struct Model
+{
+    double ambient;
+    double rise;
+    double tau;
+    int lag;
+};
+
+
+struct Result
+{
+    double duty;
+    double overshoot;
+    double settle;
+};
+
+
+static const double kAmbient = 30.0;
+static const double kTarget  = 75.0;
+static const int kDuration   = 1800;
+static const int kSettled    = 1200;
+
+
+// Cold start at full load, the settling error is the largest distance from the target over the last ten minutes
+static Result simulate(const Model &model, double ambientStep = 0.0)
+{
+    ThermalController controller;
+    std::deque<double> sensor(static_cast<size_t>(model.lag) + 1, model.ambient);
+
+    double temperature = model.ambient;
+    double duty        = 1.0;
+    double work        = 0.0;
+    Result result      = { 0.0, 0.0, 0.0 };
+
+    for (int s = 0; s < kDuration; ++s) {
+        const double ambient = model.ambient + (s >= kDuration / 2 ? ambientStep : 0.0);
+        temperature += (ambient + duty * model.rise - temperature) / model.tau;
+
+        sensor.push_back(temperature);
+        sensor.pop_front();
+
+        duty = controller.update(std::round(sensor.front()), kTarget, 1.0);
+
+        result.overshoot = std::max(result.overshoot, temperature - kTarget);
+
+        if (s >= kSettled) {
+            result.settle = std::max(result.settle, std::fabs(temperature - kTarget));
+            work += duty;
+        }
+    }
+
+    result.duty = work / (kDuration - kSettled);
+
+    return result;
+}
+
+
+int main()
+{
+    int failures = 0;
+
+    printf("full load  tau  lag  overshoot  settle  duty   ideal\n");
+
+    // Every card must settle within 1C, a card that would run up to 15C above maxtemp at full load must also overshoot
+    // by less than 3C, hotter cards overshoot more while the integral term catches up
+    for (double rise = 50.0; rise <= 90.0; rise += 10.0) {
+        for (double tau : { 30.0, 45.0, 60.0 }) {
+            for (int lag : { 0, 3 }) {
+                const Model model   = { kAmbient, rise, tau, lag };
+                const Result result = simulate(model);
+                const bool checked  = kAmbient + rise <= kTarget + 15.0;
+                const bool ok       = result.settle <= 1.0 && (!checked || result.overshoot < 3.0);
+
+                printf("%6.0fC  %5.0fs  %2ds  %7.2fC  %5.2fC  %.3f  %.3f%s\n", kAmbient + rise, tau, lag, result.overshoot, result.settle,
+                       result.duty, std::min(1.0, (kTarget - kAmbient) / rise), ok ? "" : "  FAILED");
+
+                if (!ok) {
+                    failures++;
+                }
+            }
+        }
+    }
+
+    // The room warms up by 8C half way, the card must settle again
+    for (double tau : { 30.0, 60.0 }) {
+        const Model model   = { kAmbient, 55.0, tau, 3 };
+        const Result result = simulate(model, 8.0);
+        const bool ok       = result.settle <= 1.0;
+
+        printf("ambient +8C, tau %.0fs: settle %.2fC, duty %.3f%s\n", tau, result.settle, result.duty, ok ? "" : "  FAILED");
+
+        if (!ok) {
+            failures++;
+        }
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "%d failures\n", failures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
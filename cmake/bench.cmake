@@ -0,0 +1,45 @@
+# Benchmarks and fake servers are run by hand, checks that need no GPU and no network are registered with CTest
+enable_testing()
+
+# Everything but main(), harnesses only pull in the objects they use
+set(BENCH_CORE_SOURCES ${SOURCES})
+list(REMOVE_ITEM BENCH_CORE_SOURCES src/xmrig.cpp)
+
+add_library(bench-core STATIC ${BENCH_CORE_SOURCES} ${SOURCES_OS} ${SOURCES_CRYPTO} ${SOURCES_SYSLOG} ${HTTPD_SOURCES} ${TLS_SOURCES} ${CN_GPU_SOURCES} ${XMRIG_ASM_SOURCES})
+target_link_libraries(bench-core ${XMRIG_ASM_LIBRARY} ${OPENSSL_LIBRARIES} ${UV_LIBRARIES} ${MHD_LIBRARY} ${EXTRA_LIBS} ${LIBS})
+
+add_executable(bench-share-queue bench/share-queue.cpp)
+target_link_libraries(bench-share-queue bench-core)
+
+add_executable(check-thermal bench/thermal.cpp)
+target_link_libraries(check-thermal bench-core)
+add_test(NAME thermal COMMAND check-thermal)
+
+add_executable(check-hwmon bench/hwmon.cpp)
+target_link_libraries(check-hwmon bench-core)
+add_test(NAME hwmon COMMAND check-hwmon)
+
+add_executable(bench-api bench/api-summary.cpp)
+target_link_libraries(bench-api ${UV_LIBRARIES} ${EXTRA_LIBS})
+
+add_executable(bench-submit bench/submit.cpp bench/FakePool.cpp)
+target_link_libraries(bench-submit bench-core)
+
+add_executable(check-submit-table bench/submit-table.cpp)
+target_link_libraries(check-submit-table bench-core)
+add_test(NAME submit-table COMMAND check-submit-table)
+
+add_executable(check-slow-pool bench/slow-pool.cpp bench/FakePool.cpp)
+target_link_libraries(check-slow-pool bench-core)
+add_test(NAME slow-pool COMMAND check-slow-pool)
+
+add_executable(bench-stratum bench/stratum.cpp bench/FakePool.cpp)
+target_link_libraries(bench-stratum bench-core)
+add_test(NAME stratum COMMAND bench-stratum 1000)
+
+add_executable(check-failover bench/failover.cpp bench/FakePool.cpp)
+target_link_libraries(check-failover bench-core)
+add_test(NAME failover COMMAND check-failover)
+
+add_executable(fake-pool bench/fake-pool.cpp bench/FakePool.cpp)
+target_link_libraries(fake-pool ${UV_LIBRARIES} ${EXTRA_LIBS})
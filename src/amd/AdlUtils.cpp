@@ -61,6 +61,7 @@ typedef int(*ADL2_OVERDRIVE6_FANSPEED_SET) (ADL_CONTEXT_HANDLE, int, ADLOD6FanSp
 typedef int(*ADL2_OVERDRIVEN_CAPABILITIES_GET)	(ADL_CONTEXT_HANDLE, int, ADLODNCapabilities*);
 
 static uv_mutex_t m_mutex;
+static std::string sysfsRoot = "/sys";
 
 
 ADL2_MAIN_CONTROL_CREATE                        ADL2_Main_Control_Create = nullptr;
@@ -119,45 +120,35 @@ void *hDLL = NULL;      // Handle to .so library
 HINSTANCE hDLL;         // Handle to DLL
 #endif
 
+// Everything below the root is looked up relative to it, a fake tree can stand in for /sys
+void AdlUtils::setSysfsRoot(const char *root)
+{
+    sysfsRoot = root && root[0] ? root : "/sys";
+}
+
+
 bool AdlUtils::InitADL(CoolingContext *cool)
 {
 
 #ifdef __linux__
-    // Loop over hwmon to find the correct card id
-    char filenameBuf[100];
-    int iCardIndex;
-
-    for (iCardIndex = 0; iCardIndex <= 16; iCardIndex++)
-    {
-        snprintf(filenameBuf, 100, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/temp1_input", cool->PciBus, iCardIndex);
-        //LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-        cool->ifsTemp.open(filenameBuf, std::ifstream::in);
-        if (cool->ifsTemp.is_open()) {
-            cool->Card = iCardIndex;
-            break;
-        }
-    }
-    if (!cool->ifsTemp.is_open()) {
-        LOG_ERR("Failed to open %s", filenameBuf);
+    if (!cool->hwmon.open(sysfsRoot.c_str(), cool->PciBus, cool->PciDevice, cool->PciFunction)) {
         return false;
     }
 
-    snprintf(filenameBuf, 100, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/pwm1", cool->PciBus, cool->Card);
-    //LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-    cool->ifsFan.open(filenameBuf, std::ifstream::in);
-    if (!cool->ifsFan.is_open()) {
-        LOG_ERR("Failed to open %s", filenameBuf);
+    LOG_INFO("GPU #%i PCI %s uses %s", cool->Card, cool->hwmon.address(), cool->hwmon.path());
 
+    cool->IsFanControlEnabled = cool->hwmon.isPwmWritable();
+    if (!cool->IsFanControlEnabled) {
         // Check for root
         uid_t uid = geteuid();
         if (uid != 0) {
             LOG_ERR("UserID %i has no priviledge to open fan control, needs to be run as root, fan control disabled!", uid);
-            cool->IsFanControlEnabled = false;
         }
-
-
+        else {
+            LOG_ERR("No writable pwm1 in %s, fan control disabled!", cool->hwmon.path());
+        }
     }
-    cool->IsFanControlEnabled = true;
+
     return true;
 
 #else	
@@ -222,12 +213,8 @@ bool  AdlUtils::ReleaseADL(CoolingContext *cool, bool bReset)
 		cool->CurrentFanLevel = 0;
 		AdlUtils::SetFanPercent( cool, cool->CurrentFanLevel);
 	}
-	if (cool->ifsTemp.is_open()) {
-		cool->ifsTemp.close();
-	}
-	if (cool->ifsFan.is_open()) {
-		cool->ifsFan.close();
-	}
+	cool->hwmon.close();
+	return true;
 
 #else	
     int ret = ADL2_Main_Control_Destroy(cool->context);
@@ -239,31 +226,16 @@ bool  AdlUtils::ReleaseADL(CoolingContext *cool, bool bReset)
 #endif	
 }
 
-bool AdlUtils::Get_GPU_Busy(CoolingContext *cool, const xmrig::OclThread * thread)
+bool AdlUtils::Get_GPU_Busy(CoolingContext *cool)
 {
 #ifdef __linux__
-	int result;
-	char filenameBuf[150];
-	std::ifstream ifsGPUBusy;
-
-    //LOG_INFO("DEBUG GetFanPercentLinux 1");
-
-    snprintf(filenameBuf, 150, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/gpu_busy_percent", cool->PciBus);
-    	
-    //LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-    ifsGPUBusy.open (filenameBuf);
-    if (!ifsGPUBusy.is_open()) {
-        LOG_ERR("Failed to open %s", filenameBuf);
-        LOG_INFO("DEBUG Get_GPU_Busy Exit false");
+    int busy;
+    if (!cool->hwmon.busy(busy)) {
         return false;
     }
 
-    int busy;
-    ifsGPUBusy >> busy;
-    ifsGPUBusy.close();  
-    
     cool->Busy = (cool->Busy + busy) / 2;
-    
+
     return true;
 
 #else
@@ -271,31 +243,16 @@ bool AdlUtils::Get_GPU_Busy(CoolingContext *cool, const xmrig::OclThread * threa
 #endif
 }
 
-bool AdlUtils::Get_GPU_Power(CoolingContext *cool, const xmrig::OclThread * thread)
+bool AdlUtils::Get_GPU_Power(CoolingContext *cool)
 {
 #ifdef __linux__
-	int result;
-	char filenameBuf[150];
-	std::ifstream ifsGPUPower;
-
-    //LOG_INFO("DEBUG Get_GPU_Power 1");
-
-    snprintf(filenameBuf, 150, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/power1_average", cool->PciBus, cool->Card );
-    	
-    //LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-    ifsGPUPower.open (filenameBuf);
-    if (!ifsGPUPower.is_open()) {
-        LOG_ERR("Failed to open %s", filenameBuf);
-        LOG_INFO("DEBUG Get_GPU_Power Exit false");
+    int power;
+    if (!cool->hwmon.power(power)) {
         return false;
     }
 
-    int power;
-    ifsGPUPower >> power;
-    ifsGPUPower.close();  
-    
     cool->Power = (int)((cool->Power + (power / 1000000)) / 2);
-    
+
     return true;
 
 #else
@@ -303,22 +260,21 @@ bool AdlUtils::Get_GPU_Power(CoolingContext *cool, const xmrig::OclThread * thre
 #endif
 }
 
-bool AdlUtils::Get_DeviceID_by_PCI(CoolingContext *cool, const xmrig::OclThread * thread)
+bool AdlUtils::Get_DeviceID_by_PCI(CoolingContext *cool)
 {
 #ifdef __linux__
-    return Get_DeviceID_by_PCI_Linux(cool, thread);
+    return Get_DeviceID_by_PCI_Linux(cool);
 #else
-    return Get_DeviceID_by_PCI_Windows(cool, thread);
+    return Get_DeviceID_by_PCI_Windows(cool);
 #endif
 }
 
-bool AdlUtils::Get_DeviceID_by_PCI_Linux(CoolingContext *cool, const xmrig::OclThread * thread)
+bool AdlUtils::Get_DeviceID_by_PCI_Linux(CoolingContext *cool)
 {
-    //LOG_INFO("thread->pciBusID() = %i", thread->pciBusID());
     return true;
 }
 
-bool AdlUtils::Get_DeviceID_by_PCI_Windows(CoolingContext *cool, const xmrig::OclThread * thread)
+bool AdlUtils::Get_DeviceID_by_PCI_Windows(CoolingContext *cool)
 {
 #ifndef __linux__
     int iNumberAdapters = 0;
@@ -334,14 +290,14 @@ bool AdlUtils::Get_DeviceID_by_PCI_Windows(CoolingContext *cool, const xmrig::Oc
 
             for (int i = 0; i < iNumberAdapters; i++) {
                 //LOG_INFO("%i " YELLOW("PCI:%04x:%02x:%02x") " UID %s AdapterID %i present %i exists %i", i, infos[i].iFunctionNumber, infos[i].iBusNumber, infos[i].iDeviceNumber, infos[i].strDriverPath, infos[i].iAdapterIndex, infos[i].iPresent, infos[i].iExist);
-                if (thread->pciBusID() == infos[i].iBusNumber) {
+                if (cool->PciBus == infos[i].iBusNumber) {
                     iCandidateIndex = i;
                     cool->Card = i;
                     
                     AdlUtils::GetMaxFanRpm(cool);
 
                     if (TemperatureWindows(cool)) {
-                        LOG_INFO("Card "  YELLOW("PCI:%04x:%02x:%02x") " Temp %i Thread %i ADL Adapter %i", thread->pciDomainID(), thread->pciBusID(), thread->pciDeviceID(), cool->CurrentTemp, thread->threadId(), cool->Card);
+                        LOG_INFO("Card "  YELLOW("PCI:%02x") " Temp %i ADL Adapter %i", cool->PciBus, cool->CurrentTemp, cool->Card);
                         found = true;
                         break;
                     }
@@ -375,7 +331,9 @@ bool AdlUtils::GetMaxFanRpm(CoolingContext *cool)
         cool->MaxFanSpeed = overdriveCapabilities.fanSpeed.iMax;
     }
     return true;
-#endif    
+#else
+    return false;
+#endif
 }
 
 bool AdlUtils::GetFanPercent(CoolingContext *cool, int *percent)
@@ -389,38 +347,22 @@ bool AdlUtils::GetFanPercent(CoolingContext *cool, int *percent)
 
 bool AdlUtils::GetFanPercentLinux(CoolingContext *cool, int *percent)
 {
-	int result;
-	char filenameBuf[150];
-	std::ifstream ifsFanSpeed;
-
-    //LOG_INFO("DEBUG GetFanPercentLinux 1");
-
-    snprintf(filenameBuf, 150, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/pwm1", cool->PciBus, cool->Card );
-		
-    //LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-    ifsFanSpeed.open (filenameBuf);
-    if (!ifsFanSpeed.is_open()) {
-        LOG_ERR("Failed to open %s", filenameBuf);
-        LOG_INFO("DEBUG GetFanPercentLinux Exit 1");
+#ifdef __linux__
+    int speed;
+    if (!cool->hwmon.pwm(speed)) {
         return false;
     }
 
-    int speed;
-    ifsFanSpeed >> speed;
-    ifsFanSpeed.close();  
-    
-    //LOG_INFO("DEBUG GetFanPercentLinux Speed %i", speed);
-
     cool->CurrentFanLevel = (speed * 100) / 255;
     if (percent != NULL)
     {
         *percent = cool->CurrentFanLevel;
     }
-    //LOG_INFO("DEBUG GetFanPercentLinux Percent %i", cool->CurrentFan);
 
-    //LOG_INFO("DEBUG GetFanPercentLinux Exit 2");
-    
     return true;
+#else
+    return false;
+#endif
 }
 
 bool AdlUtils::GetFanPercentWindows(CoolingContext *cool, int *percent)
@@ -510,60 +452,21 @@ bool AdlUtils::SetFanPercentWindows(CoolingContext *cool, int percent)
 bool AdlUtils::SetFanPercentLinux(CoolingContext *cool, int percent)
 {
 #ifdef __linux__
-	int result;
-	char filenameBuf[100];
-	std::ofstream ifsFanControl;
-	std::ofstream ifsFanSpeed;
-
-	snprintf(filenameBuf, 100, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/pwm1_enable", cool->PciBus, cool->Card );
-	//LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-	ifsFanControl.open (filenameBuf);
-	if (!ifsFanControl.is_open()) {
-		LOG_ERR("Failed to open %s", filenameBuf);
-
-		// Check for root
-		uid_t uid = geteuid();
-		if (uid != 0) {
-			LOG_ERR("UserID %i has no priviledge to open fan control, needs to be run as root, fan control disabled!", uid);
-			cool->IsFanControlEnabled = false;
-		}
-		return false;
-	}
-	cool->IsFanControlEnabled = true;
-
-    //LOG_INFO("DEBUG SetFanPercentLinux percent %i", percent);
-
 	if (percent == 0) {
-		char *automatic = "2";
-		ifsFanControl << automatic;
-		ifsFanControl.close();
-		cool->FanIsAutomatic = true;
-		result = ADL_OK;
-	}
-	else {
-		char *manual = "1";
-		ifsFanControl << manual;
-		ifsFanControl.close();
-		cool->FanIsAutomatic = false;
-
-		snprintf(filenameBuf, 100, "/sys/module/amdgpu/drivers/pci:amdgpu/0000:%02x:00.0/hwmon/hwmon%i/pwm1", cool->PciBus, cool->Card );
-		//LOG_INFO("OPEN std::ifstream %s", filenameBuf);
-		ifsFanSpeed.open (filenameBuf);
-		if (!ifsFanSpeed.is_open()) {
-			LOG_ERR("Failed to open %s", filenameBuf);
+		// Back to automatic fan control
+		if (!cool->hwmon.setPwmEnable(2)) {
 			return false;
 		}
+		cool->FanIsAutomatic = true;
+		return true;
+	}
 
-		int speed = (percent * 255) / 100;
-		ifsFanSpeed << speed;
-		ifsFanSpeed.close();
-
-        //LOG_INFO("DEBUG SetFanPercentLinux Speed %i", speed);
-
-		result = ADL_OK;
+	if (!cool->hwmon.setPwmEnable(1)) {
+		return false;
 	}
+	cool->FanIsAutomatic = false;
 
-	return true;
+	return cool->hwmon.setPwm((percent * 255) / 100);
 #else
     return false;
 #endif
@@ -582,44 +485,12 @@ bool AdlUtils::Temperature(CoolingContext *cool)
 bool AdlUtils::TemperatureLinux(CoolingContext *cool)
 {
 #ifdef __linux__
-	int result;
-
-	
-	int temp = 0;
-	int fan = 0;
-	try
-	{
-		if (cool->ifsTemp.is_open()) {
-			//LOG_INFO("Filestream is open.");
-			cool->ifsTemp.seekg (0, std::ifstream::beg);
-			cool->ifsTemp >> temp;
-			result = ADL_OK;
-		}
-		//LOG_INFO("Temp is %i", temp);
-		if (cool->ifsFan.is_open()) {
-			//LOG_INFO("Filestream is open.");
-			cool->ifsFan.seekg (0, std::ifstream::beg);
-			cool->ifsFan >> fan;
-			result = ADL_OK;
-		}
-
-	}
-	catch(const std::exception& ex) {
-		LOG_ERR("Exception reading temp: %s", ex.what());
-		result = ADL_ERR;
+	int temp;
+	if (!cool->hwmon.temperature(temp)) {
+		return false;
 	}
 
 	cool->CurrentTemp = temp / 1000;
-	//cool->CurrentFan = (fan * 100) / 255;
-
-	//LOG_INFO("FINAL std::ifstream temp %i", temp);
-			
-
-				//if (topology.pcie.bus == infos[i].iBusNumber) {
-			
-				//LOG_DEBUG("***** Card %u temp %u adapterindex %u, adlbus %u oclbus %u", i, temp, infos[i].iAdapterIndex, infos[i].iBusNumber, topology.pcie.bus);
-			
-	
 	return true;
 #else
     return false;
@@ -649,94 +520,46 @@ ulong AdlUtils::GetTickCount(void)
 }
 #endif
 
-bool  AdlUtils::DoCooling(cl_device_id DeviceID, int deviceIdx, int ThreadID, CoolingContext *cool)
+// Reads the sensors and drives the fan, called once per sample by the sensor service, throttling is up to the thermal controller of the card
+bool  AdlUtils::DoCooling(CoolingContext *cool)
 {
-	const int StartSleepFactor = 100;
-    const float IncreaseSleepFactor = 1.5;
 	const int FanFactor = 2;
     const int FanAutoDefault = 50;
-    const ulong TickDiff = GetTickCount() - cool->LastTick;
 	
-    AdlUtils::Get_GPU_Power(cool, NULL);
-    AdlUtils::Get_GPU_Busy(cool, NULL);
+    AdlUtils::Get_GPU_Power(cool);
+    AdlUtils::Get_GPU_Busy(cool);
 
     if (AdlUtils::Temperature(cool) != true) {
 		return false;
 	}
-    //LOG_INFO("cool->CurrentTemp %u cool->SleepFactor %u cool->NeedsCooling %s", cool->CurrentTemp, cool->SleepFactor, cool->NeedsCooling ? "TRUE":"FALSE");
-	
-    if (TickDiff < 1000) {
-        //LOG_INFO("TickDiff %u cool->LastTick %u GetTickCount() %u", TickDiff, cool->LastTick, GetTickCount());
-		return true;
-	}
-    //LOG_INFO("TickDiff %u cool->LastTick %u GetTickCount() %u", TickDiff, cool->LastTick, GetTickCount());
-	cool->LastTick = GetTickCount();
 
     if (Workers::fanlevel() > 0)
     {
         SetFanPercent(cool, Workers::fanlevel());
     }
 
-    //LOG_INFO("DEBUG DoCooling 2");
 	if (!AdlUtils::GetFanPercent(cool, NULL)) {
 		LOG_ERR("Failed to get Fan speed for card %i", cool->Card);
 		return false;
 	}
-    
-    //LOG_INFO("DEBUG DoCooling 3");
-    
-    //LOG_INFO("CurrentTemp %i, maxTemp %i",cool->CurrentTemp, Workers::maxtemp() );
-    //LOG_INFO("cool->NeedsCooling %s", cool->NeedsCooling ? "TRUE" : "FALSE" );
 
 	if (cool->CurrentTemp > Workers::maxtemp()) {
-		if (!cool->NeedsCooling) {
-			cool->SleepFactor = StartSleepFactor;
-			LOG_INFO( YELLOW("Card %u Thread %i Temperature %u is over %i, reduced mining, Sleeptime %i"), deviceIdx, ThreadID, cool->CurrentTemp, Workers::maxtemp(), cool->SleepFactor);
-		}
 		cool->NeedsCooling = true;
-        //cool->CurrentFan = 100;
-        //AdlUtils::SetFanPercent(cool, cool->CurrentFan);
 	}
 
-	if (cool->NeedsCooling) {
-		if (cool->CurrentTemp < Workers::maxtemp() - Workers::falloff()) {
-			LOG_INFO( YELLOW("Card %u Thread %i Temperature %i is below %i, do full mining, Sleeptime was %u"), deviceIdx, ThreadID, cool->CurrentTemp, Workers::maxtemp() - Workers::falloff(), cool->SleepFactor);
-			//cool->LastTemp = cool->CurrentTemp;
-			if (cool->SleepFactor <= StartSleepFactor) {
-				cool->SleepFactor = 0;
-			    cool->NeedsCooling = false;
-            }
-
-            cool->SleepFactor = (int)((float)cool->SleepFactor / IncreaseSleepFactor);
+	if (cool->NeedsCooling && cool->CurrentTemp < Workers::maxtemp() - Workers::falloff()) {
+		cool->NeedsCooling = false;
 
-       		if (Workers::fanlevel() == 0)
-			{
-				// Decrease fan speed
-				if (cool->CurrentFanLevel > 0)
-					cool->CurrentFanLevel = cool->CurrentFanLevel - FanFactor;
-				SetFanPercent(cool, cool->CurrentFanLevel);
-			}
-
-			LOG_INFO( YELLOW("Card %u Sleeptime is now %u"), cool->Card, cool->SleepFactor);
-
-		}
-		else {
-			if ((cool->LastTemp < cool->CurrentTemp) && (cool->CurrentTemp > (Workers::maxtemp() - Workers::falloff()))) {
-				cool->SleepFactor = (int)((float)cool->SleepFactor * IncreaseSleepFactor);
-				if (cool->SleepFactor > 9999) {
-					cool->SleepFactor = 9999;
-				}
-				LOG_INFO("Card %u Temperature %i SleepFactor %i LastTemp %i NeedCooling %i ", cool->Card, cool->CurrentTemp, cool->SleepFactor, cool->LastTemp, cool->NeedsCooling);
-			}
+		if (Workers::fanlevel() == 0)
+		{
+			// Decrease fan speed
+			if (cool->CurrentFanLevel > 0)
+				cool->CurrentFanLevel = cool->CurrentFanLevel - FanFactor;
+			SetFanPercent(cool, cool->CurrentFanLevel);
 		}
-		
 	}
 
-    //LOG_INFO("DEBUG DoCooling 4");
-
 	if (cool->NeedsCooling) {
-		int iReduceMining = 5;
-
         if (Workers::fanlevel() == 0)
 		{
 			// Increase fan speed
@@ -744,12 +567,6 @@ bool  AdlUtils::DoCooling(cl_device_id DeviceID, int deviceIdx, int ThreadID, Co
 				cool->CurrentFanLevel = cool->CurrentFanLevel + (FanFactor*5);
 			SetFanPercent(cool, cool->CurrentFanLevel);
 		}
-		//LOG_INFO("Card %u Temperature %i iReduceMining %i iSleepFactor %i LastTemp %i NeedCooling %i ", deviceIdx, temp, iReduceMining, cool->SleepFactor, cool->LastTemp, cool->NeedCooling);
-
-		do {
-			std::this_thread::sleep_for(std::chrono::milliseconds(cool->SleepFactor));
-			iReduceMining = iReduceMining - 1;
-		} while ((iReduceMining > 0) && (Workers::sequence() > 0));
 	}
 	else {
         if (Workers::fanlevel() == 0)
@@ -759,7 +576,6 @@ bool  AdlUtils::DoCooling(cl_device_id DeviceID, int deviceIdx, int ThreadID, Co
                 if (!cool->FanIsAutomatic) {
                     if (cool->CurrentFanLevel > FanAutoDefault) {
                         cool->CurrentFanLevel = cool->CurrentFanLevel - FanFactor;
-                        //LOG_INFO("DEBUG AdlUtils::SetFanPercent %i", cool->CurrentFan);
                         AdlUtils::SetFanPercent(cool, cool->CurrentFanLevel);
                     }
                     else {
@@ -783,8 +599,6 @@ bool  AdlUtils::DoCooling(cl_device_id DeviceID, int deviceIdx, int ThreadID, Co
         }
 	}
 	cool->LastTemp = cool->CurrentTemp;
-	
-    //LOG_INFO("DEBUG DoCooling Exit");
 
     return true;
-}
\ No newline at end of file
+}
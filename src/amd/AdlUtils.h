@@ -9,7 +9,7 @@
 #include <uv.h>
 
 #include "3rdparty/ADL/adl_structures.h"
-#include "workers/OclThread.h"
+#include "amd/CoolingContext.h"
 
 // Memory allocation function
 //void* __stdcall ADL_Main_Memory_Alloc(int iSize);
@@ -23,12 +23,13 @@ class AdlUtils
 public:
 	
 	static bool InitADL(CoolingContext *cool);
+	static void setSysfsRoot(const char *root);
 	static bool ReleaseADL(CoolingContext *cool, bool bReset);
-    static bool Get_DeviceID_by_PCI(CoolingContext *cool, const xmrig::OclThread * thread);
-	static bool Get_DeviceID_by_PCI_Linux(CoolingContext *cool, const xmrig::OclThread * thread);
-	static bool Get_DeviceID_by_PCI_Windows(CoolingContext *cool, const xmrig::OclThread * thread);
-	static bool Get_GPU_Busy(CoolingContext *cool, const xmrig::OclThread * thread);
-	static bool Get_GPU_Power(CoolingContext *cool, const xmrig::OclThread * thread);
+    static bool Get_DeviceID_by_PCI(CoolingContext *cool);
+	static bool Get_DeviceID_by_PCI_Linux(CoolingContext *cool);
+	static bool Get_DeviceID_by_PCI_Windows(CoolingContext *cool);
+	static bool Get_GPU_Busy(CoolingContext *cool);
+	static bool Get_GPU_Power(CoolingContext *cool);
 	static bool Temperature(CoolingContext *cool);
 	static bool TemperatureLinux(CoolingContext *cool);
 	static bool TemperatureWindows(CoolingContext *cool);
@@ -38,7 +39,7 @@ public:
 	static bool SetFanPercent(CoolingContext *cool, int percent);
 	static bool SetFanPercentLinux(CoolingContext *cool, int percent);
 	static bool SetFanPercentWindows(CoolingContext *cool, int percent);
-	static bool DoCooling(cl_device_id DeviceID, int deviceIdx, int ThreadID, CoolingContext *cool);
+	static bool DoCooling(CoolingContext *cool);
 
     static bool GetMaxFanRpm(CoolingContext *cool);
 	
@@ -6,23 +6,26 @@
 #include <fstream>
 #include <uv.h>
 
+#ifdef __linux__
+#include "amd/Hwmon.h"
+#endif
+
 typedef struct _CoolingContext {
-	int SleepFactor = 0;
 	int LastTemp = 0;
-	ulong LastTick = 0;
 	int CurrentTemp = 0;
 	int CurrentFanLevel = 0;
 	bool NeedsCooling = false;
 	bool FanIsAutomatic = false;
 	bool IsFanControlEnabled = false;
 	int PciBus = -1;
+	int PciDevice = 0;
+	int PciFunction = 0;
 	int GPUIndex = -1;
 	int Card = -1;
 	int Busy = -1;
 	int Power = -1;
 #ifdef __linux__
-	std::ifstream ifsTemp;
-	std::ifstream ifsFan;
+	Hwmon hwmon;
 #else
     ADL_CONTEXT_HANDLE context;
     int MaxFanSpeed;
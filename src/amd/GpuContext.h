@@ -34,6 +34,7 @@
 
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 
 
@@ -41,6 +42,54 @@
 #include "common/xmrig.h"
 
 
+class OclProfiler;
+
+
+/* Buffers, events and host side results of one batch in flight, used by pipelined mode (see XMRRunJobPipelined) */
+struct GpuBatch
+{
+    enum Stage {
+        Idle,
+        Hashing,   /* cn0, cn1, cn2 enqueued, branch counters read pending */
+        Finishing  /* final hash kernels enqueued, output read pending */
+    };
+
+    inline GpuBatch() :
+        StatesBuffer(nullptr),
+        OutputBuffer(nullptr),
+        BranchBuffers{ nullptr },
+        BranchEvent(nullptr),
+        OutputEvent(nullptr),
+        BranchNonces{ 0 },
+        Nonce(0),
+        stage(Idle)
+    {
+        memset(Output, 0, sizeof(Output));
+    }
+
+    cl_mem StatesBuffer;
+    cl_mem OutputBuffer;
+    cl_mem BranchBuffers[4];
+    cl_event BranchEvent;
+    cl_event OutputEvent;
+    cl_uint BranchNonces[4];
+    cl_uint Output[0x100];
+    uint32_t Nonce;
+    Stage stage;
+};
+
+
+/* Launch settings of a running GPU thread, applied by ReconfigureOpenCLDevice */
+struct GpuSettings
+{
+    size_t intensity;
+    size_t worksize;
+    int stridedIndex;
+    int memChunk;
+    int unrollFactor;
+};
+
+
 struct GpuContext
 {
     inline GpuContext() :
@@ -53,6 +102,10 @@ struct GpuContext
         compMode(1),
         unrollFactor(8),
         vendor(xmrig::OCL_VENDOR_UNKNOWN),
+        cache(true),
+        pipeline(false),
+        deviceDispatch(false),
+        profiling(false),
         threadIdx(0),
         opencl_ctx(nullptr),
         platformIdx(0),
@@ -67,7 +120,14 @@ struct GpuContext
         ProgramCryptonightR(nullptr),
         freeMem(0),
         globalMem(0),
+        allocatedIntensity(0),
         computeUnits(0),
+        device_pciBusID(0),
+        device_pciDeviceID(0),
+        device_pciDomainID(0),
+        device_pciFunctionID(0),
+        BatchIdx(0),
+        profiler(nullptr),
         Nonce(0)
     {
         memset(Kernels, 0, sizeof(Kernels));
@@ -83,6 +143,13 @@ struct GpuContext
     int compMode;
     int unrollFactor;
     xmrig::OclVendor vendor;
+    bool cache;
+    bool pipeline;
+    bool deviceDispatch;
+    bool profiling;
+
+    inline size_t configuredIntensity() const { return allocatedIntensity > 0 ? allocatedIntensity : rawIntensity; }
+    inline GpuSettings settings() const       { return { configuredIntensity(), workSize, stridedIndex, memChunk, unrollFactor }; }
 
     /*Output vars*/
     size_t threadIdx;
@@ -100,14 +167,23 @@ struct GpuContext
     cl_program ProgramCryptonightR;
     size_t freeMem;
     size_t globalMem;
+    size_t allocatedIntensity; /* buffers are sized for it, rawIntensity can be lowered at runtime down from it */
     cl_uint computeUnits;
     xmrig::String board;
     xmrig::String name;
 
-    /* PCI-E values*/
+    /* PCI-E values, the AMD topology query has no domain, it stays 0 */
     uint32_t device_pciBusID;
     uint32_t device_pciDeviceID;
     uint32_t device_pciDomainID;
+    uint32_t device_pciFunctionID;
+
+    /* Pipelined mode, batch 0 shares ExtraBuffers[1..5] and OutputBuffer, batch 1 owns its own copies */
+    GpuBatch Batches[2];
+    size_t BatchIdx;
+
+    /* Profiling mode only, events of commands in flight */
+    OclProfiler *profiler;
 
     uint32_t Nonce;
 };
@@ -0,0 +1,324 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <thread>
+#include <uv.h>
+
+
+#include "amd/AdlUtils.h"
+#include "amd/CoolingContext.h"
+#include "amd/GpuContext.h"
+#include "amd/GpuSensors.h"
+#include "common/log/Log.h"
+#include "common/utils/timestamp.h"
+#include "workers/Hashrate.h"
+
+
+namespace {
+
+
+static const size_t kHistorySize = 1024;
+static const size_t kHistoryMask = kHistorySize - 1;
+static const size_t kWindows     = 3;
+
+
+// Running totals of every reading, the mean over any range of samples is the difference of two entries
+struct Total
+{
+    int64_t timestamp;
+    int64_t temperature;
+    int64_t fan;
+    int64_t power;
+    int64_t busy;
+};
+
+
+struct Card
+{
+    size_t deviceIdx;
+    bool enabled;
+    CoolingContext cool;
+
+    // Written only by the sampling thread, one sample per second covers 17 minutes
+    Total history[kHistorySize];
+    size_t top;
+    size_t tail[kWindows];
+
+    // Seqlock, the sampling thread is the only writer, an odd sequence means an update is in progress
+    std::atomic<uint32_t> sequence;
+    std::atomic<int64_t> timestamp;
+    std::atomic<int> temperature;
+    std::atomic<int> fan;
+    std::atomic<int> power;
+    std::atomic<int> busy;
+    std::atomic<double> average[kWindows][4];
+};
+
+
+} // namespace
+
+
+static const int64_t kInterval = 1000;
+static const size_t windows[kWindows] = { Hashrate::ShortInterval, Hashrate::MediumInterval, Hashrate::LargeInterval };
+
+
+static std::atomic<bool> running(false);
+static std::vector<Card *> cards;
+static uv_thread_t thread;
+
+
+static int window(size_t ms)
+{
+    for (size_t i = 0; i < kWindows; ++i) {
+        if (windows[i] == ms) {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+
+// Same forward-only window cursors as Hashrate::add(), so the 15 minute mean costs as much as the 10 second one
+static void record(Card *card, int64_t timestamp)
+{
+    const Total &last = card->history[(card->top - 1) & kHistoryMask];
+    const bool first  = card->top == 0;
+
+    Total &total      = card->history[card->top++ & kHistoryMask];
+    total.timestamp   = timestamp;
+    total.temperature = (first ? 0 : last.temperature) + card->cool.CurrentTemp;
+    total.fan         = (first ? 0 : last.fan) + card->cool.CurrentFanLevel;
+    total.power       = (first ? 0 : last.power) + card->cool.Power;
+    total.busy        = (first ? 0 : last.busy) + card->cool.Busy;
+
+    for (size_t w = 0; w < kWindows; ++w) {
+        const int64_t start = timestamp - static_cast<int64_t>(windows[w]);
+        size_t &tail        = card->tail[w];
+
+        if (card->top - tail > kHistorySize) {
+            tail = card->top - kHistorySize;
+        }
+
+        while (tail + 1 < card->top && card->history[(tail + 1) & kHistoryMask].timestamp <= start) {
+            tail++;
+        }
+
+        const Total &oldest = card->history[tail & kHistoryMask];
+        const size_t count  = card->top - 1 - tail;
+
+        if (oldest.timestamp > start || count == 0) {
+            for (size_t i = 0; i < 4; ++i) {
+                card->average[w][i].store(nan(""), std::memory_order_relaxed);
+            }
+
+            continue;
+        }
+
+        card->average[w][0].store(static_cast<double>(total.temperature - oldest.temperature) / count, std::memory_order_relaxed);
+        card->average[w][1].store(static_cast<double>(total.fan - oldest.fan) / count, std::memory_order_relaxed);
+        card->average[w][2].store(static_cast<double>(total.power - oldest.power) / count, std::memory_order_relaxed);
+        card->average[w][3].store(static_cast<double>(total.busy - oldest.busy) / count, std::memory_order_relaxed);
+    }
+}
+
+
+static void publish(Card *card)
+{
+    const uint32_t sequence = card->sequence.load(std::memory_order_relaxed);
+    const int64_t timestamp = xmrig::steadyTimestamp();
+
+    card->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record(card, timestamp);
+
+    card->timestamp.store(timestamp, std::memory_order_relaxed);
+    card->temperature.store(card->cool.CurrentTemp, std::memory_order_relaxed);
+    card->fan.store(card->cool.CurrentFanLevel, std::memory_order_relaxed);
+    card->power.store(card->cool.Power, std::memory_order_relaxed);
+    card->busy.store(card->cool.Busy, std::memory_order_relaxed);
+
+    card->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+// All sensor and fan I/O happens here, hashing threads and the main loop never touch sysfs or ADL
+static void onSample(void *)
+{
+    for (Card *card : cards) {
+        card->enabled = AdlUtils::InitADL(&card->cool);
+        if (!card->enabled) {
+            LOG_WARN("Cooling is disabled for GPU #%zu!", card->deviceIdx);
+            continue;
+        }
+
+        card->enabled = AdlUtils::Get_DeviceID_by_PCI(&card->cool);
+        if (!card->enabled) {
+            LOG_ERR("Failed get_deviceid_by_pci GPU #%zu pciBusID %02x", card->deviceIdx, card->cool.PciBus);
+            continue;
+        }
+
+        AdlUtils::GetMaxFanRpm(&card->cool);
+    }
+
+    while (running.load(std::memory_order_relaxed)) {
+        const int64_t next = xmrig::steadyTimestamp() + kInterval;
+
+        for (Card *card : cards) {
+            if (card->enabled && AdlUtils::DoCooling(&card->cool)) {
+                publish(card);
+            }
+        }
+
+        while (running.load(std::memory_order_relaxed) && xmrig::steadyTimestamp() < next) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    for (Card *card : cards) {
+        if (card->enabled) {
+            AdlUtils::ReleaseADL(&card->cool, true);
+        }
+    }
+}
+
+
+bool GpuSensors::average(size_t deviceIdx, size_t ms, Average &average)
+{
+    const int w = window(ms);
+    if (w < 0) {
+        return false;
+    }
+
+    for (const Card *card : cards) {
+        if (card->deviceIdx != deviceIdx) {
+            continue;
+        }
+
+        uint32_t sequence;
+        do {
+            sequence = card->sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+
+            average.temperature = card->average[w][0].load(std::memory_order_relaxed);
+            average.fan         = card->average[w][1].load(std::memory_order_relaxed);
+            average.power       = card->average[w][2].load(std::memory_order_relaxed);
+            average.busy        = card->average[w][3].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) || sequence != card->sequence.load(std::memory_order_relaxed));
+
+        return true;
+    }
+
+    return false;
+}
+
+
+// Never blocks, retries only while the sampling thread is in the middle of an update
+bool GpuSensors::read(size_t deviceIdx, Sample &sample)
+{
+    for (const Card *card : cards) {
+        if (card->deviceIdx != deviceIdx) {
+            continue;
+        }
+
+        uint32_t sequence;
+        do {
+            sequence = card->sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+
+            sample.timestamp   = card->timestamp.load(std::memory_order_relaxed);
+            sample.temperature = card->temperature.load(std::memory_order_relaxed);
+            sample.fan         = card->fan.load(std::memory_order_relaxed);
+            sample.power       = card->power.load(std::memory_order_relaxed);
+            sample.busy        = card->busy.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) || sequence != card->sequence.load(std::memory_order_relaxed));
+
+        return sample.timestamp > 0;
+    }
+
+    return false;
+}
+
+
+void GpuSensors::start(const std::vector<GpuContext *> &contexts, const char *root)
+{
+    AdlUtils::setSysfsRoot(root);
+
+    // The API looks cards up from its own thread, the list must never reallocate
+    cards.reserve(contexts.size());
+
+    for (const GpuContext *ctx : contexts) {
+        Card *card             = new Card();
+        card->deviceIdx        = ctx->deviceIdx;
+        card->enabled          = false;
+        card->cool.PciBus      = static_cast<int>(ctx->device_pciBusID);
+        card->cool.PciDevice   = static_cast<int>(ctx->device_pciDeviceID);
+        card->cool.PciFunction = static_cast<int>(ctx->device_pciFunctionID);
+        card->cool.Card        = static_cast<int>(ctx->deviceIdx);
+        card->sequence         = 0;
+        card->timestamp        = 0;
+        card->temperature      = 0;
+        card->fan              = 0;
+        card->power            = 0;
+        card->busy             = 0;
+        card->top              = 0;
+
+        for (size_t w = 0; w < kWindows; ++w) {
+            card->tail[w] = 0;
+
+            for (size_t i = 0; i < 4; ++i) {
+                card->average[w][i] = nan("");
+            }
+        }
+
+        cards.push_back(card);
+    }
+
+    running = true;
+    uv_thread_create(&thread, onSample, nullptr);
+}
+
+
+void GpuSensors::stop()
+{
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    // Cards stay allocated, the API thread may still read a snapshot while the miner shuts down
+    uv_thread_join(&thread);
+}
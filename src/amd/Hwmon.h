@@ -0,0 +1,74 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XMRIG_HWMON_H
+#define XMRIG_HWMON_H
+
+
+#include <stdint.h>
+#include <string>
+
+
+/* amdgpu sysfs nodes of one card, found by PCI address once and kept open, every read is a single pread */
+class Hwmon
+{
+public:
+    Hwmon();
+    Hwmon(const Hwmon &other) = delete;
+    ~Hwmon();
+
+    Hwmon &operator=(const Hwmon &other) = delete;
+
+    bool busy(int &percent) const;
+    bool open(const char *root, uint32_t bus, uint32_t device, uint32_t function);
+    bool power(int &microwatts) const;
+    bool pwm(int &value) const;
+    bool setPwm(int value) const;
+    bool setPwmEnable(int mode) const;
+    bool temperature(int &millidegrees) const;
+    void close();
+
+    inline bool isPwmWritable() const     { return m_pwmWritable; }
+    inline const char *address() const    { return m_address.c_str(); }
+    inline const char *path() const       { return m_path.c_str(); }
+
+private:
+    static bool find(const std::string &devices, uint32_t bus, uint32_t device, uint32_t function, std::string &address);
+    static bool findHwmon(const std::string &device, std::string &path);
+    static bool readInt(int fd, int &value);
+    static bool writeInt(int fd, int value);
+    static int openNode(const std::string &path, bool writable);
+
+    bool m_pwmWritable;
+    int m_busy;
+    int m_power;
+    int m_pwm;
+    int m_pwmEnable;
+    int m_temp;
+    std::string m_address;
+    std::string m_path;
+};
+
+
+#endif /* XMRIG_HWMON_H */
@@ -0,0 +1,246 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+
+#include "amd/Hwmon.h"
+#include "common/log/Log.h"
+
+
+Hwmon::Hwmon() :
+    m_pwmWritable(false),
+    m_busy(-1),
+    m_power(-1),
+    m_pwm(-1),
+    m_pwmEnable(-1),
+    m_temp(-1)
+{
+}
+
+
+Hwmon::~Hwmon()
+{
+    close();
+}
+
+
+bool Hwmon::busy(int &percent) const
+{
+    return readInt(m_busy, percent);
+}
+
+
+// Walks <root>/bus/pci/devices once, the card is matched by bus, device and function, the domain is taken from sysfs
+bool Hwmon::open(const char *root, uint32_t bus, uint32_t device, uint32_t function)
+{
+    close();
+
+    const std::string devices = std::string(root) + "/bus/pci/devices";
+    if (!find(devices, bus, device, function, m_address)) {
+        LOG_ERR("No PCI device *:%02x:%02x.%x found in %s", bus, device, function, devices.c_str());
+        return false;
+    }
+
+    const std::string node = devices + "/" + m_address;
+    if (!findHwmon(node, m_path)) {
+        LOG_ERR("No hwmon with temp1_input found for PCI %s", m_address.c_str());
+        return false;
+    }
+
+    m_temp = openNode(m_path + "/temp1_input", false);
+    if (m_temp < 0) {
+        LOG_ERR("Failed to open %s/temp1_input", m_path.c_str());
+        return false;
+    }
+
+    m_power = openNode(m_path + "/power1_average", false);
+    if (m_power < 0) {
+        m_power = openNode(m_path + "/power1_input", false);
+    }
+
+    m_busy        = openNode(node + "/gpu_busy_percent", false);
+    m_pwmEnable   = openNode(m_path + "/pwm1_enable", true);
+    m_pwm         = openNode(m_path + "/pwm1", true);
+    m_pwmWritable = m_pwm >= 0 && m_pwmEnable >= 0;
+
+    if (m_pwm < 0) {
+        m_pwm = openNode(m_path + "/pwm1", false);
+    }
+
+    return true;
+}
+
+
+bool Hwmon::power(int &microwatts) const
+{
+    return readInt(m_power, microwatts);
+}
+
+
+bool Hwmon::pwm(int &value) const
+{
+    return readInt(m_pwm, value);
+}
+
+
+bool Hwmon::setPwm(int value) const
+{
+    return m_pwmWritable && writeInt(m_pwm, value);
+}
+
+
+bool Hwmon::setPwmEnable(int mode) const
+{
+    return m_pwmWritable && writeInt(m_pwmEnable, mode);
+}
+
+
+bool Hwmon::temperature(int &millidegrees) const
+{
+    return readInt(m_temp, millidegrees);
+}
+
+
+void Hwmon::close()
+{
+    for (int *fd : { &m_busy, &m_power, &m_pwm, &m_pwmEnable, &m_temp }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    m_pwmWritable = false;
+    m_address.clear();
+    m_path.clear();
+}
+
+
+// OpenCL does not report the PCI domain, if the same bus address exists in several domains the lowest one wins
+bool Hwmon::find(const std::string &devices, uint32_t bus, uint32_t device, uint32_t function, std::string &address)
+{
+    DIR *dir = opendir(devices.c_str());
+    if (!dir) {
+        return false;
+    }
+
+    std::vector<std::string> matches;
+    while (const dirent *entry = readdir(dir)) {
+        unsigned int d, b, s, f;
+        if (sscanf(entry->d_name, "%x:%x:%x.%x", &d, &b, &s, &f) == 4 && b == bus && s == device && f == function) {
+            matches.push_back(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+
+    if (matches.empty()) {
+        return false;
+    }
+
+    std::sort(matches.begin(), matches.end());
+    if (matches.size() > 1) {
+        LOG_WARN("PCI address %02x:%02x.%x exists in %zu domains, using %s", bus, device, function, matches.size(), matches[0].c_str());
+    }
+
+    address = matches[0];
+    return true;
+}
+
+
+bool Hwmon::findHwmon(const std::string &device, std::string &path)
+{
+    const std::string hwmon = device + "/hwmon";
+    DIR *dir = opendir(hwmon.c_str());
+    if (!dir) {
+        return false;
+    }
+
+    std::vector<std::string> candidates;
+    while (const dirent *entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "hwmon", 5) == 0 && access((hwmon + "/" + entry->d_name + "/temp1_input").c_str(), R_OK) == 0) {
+            candidates.push_back(hwmon + "/" + entry->d_name);
+        }
+    }
+
+    closedir(dir);
+
+    if (candidates.empty()) {
+        return false;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    path = candidates[0];
+    return true;
+}
+
+
+// sysfs regenerates the attribute on every read from offset 0, no reopen or seek needed
+bool Hwmon::readInt(int fd, int &value)
+{
+    if (fd < 0) {
+        return false;
+    }
+
+    char buf[32];
+    const ssize_t size = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (size <= 0) {
+        return false;
+    }
+
+    buf[size] = '\0';
+
+    char *end = nullptr;
+    const long result = strtol(buf, &end, 10);
+    if (end == buf) {
+        return false;
+    }
+
+    value = static_cast<int>(result);
+    return true;
+}
+
+
+bool Hwmon::writeInt(int fd, int value)
+{
+    char buf[16];
+    const int size = snprintf(buf, sizeof(buf), "%d\n", value);
+
+    return pwrite(fd, buf, size, 0) == size;
+}
+
+
+int Hwmon::openNode(const std::string &path, bool writable)
+{
+    return ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+}
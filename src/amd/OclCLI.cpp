@@ -62,7 +62,7 @@ int OclCLI::getPCIInfo(GpuContext *context, int DeviceId)
         LOG_DEBUG("****************** m_ctx->deviceIdx %u INFO: Topology: PCI[ B#%u D#%u F#%u ]", deviceIdx, (int)topology.pcie.bus, (int)topology.pcie.device, (int)topology.pcie.function);
         context->device_pciBusID = (int)topology.pcie.bus;
         context->device_pciDeviceID = (int)topology.pcie.device;
-        context->device_pciDomainID = (int)topology.pcie.function;
+        context->device_pciFunctionID = (int)topology.pcie.function;
 
     }
     return status;
@@ -23,8 +23,11 @@
  */
 
 
+#include <algorithm>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
 
@@ -40,6 +43,24 @@
 #include "crypto/CryptoNight_constants.h"
 
 
+// Program built for one device in a context, identified by the calc_hash key, program is nullptr while the build is in progress
+struct OclCache::SharedProgram
+{
+    cl_context opencl_ctx;
+    cl_device_id device;
+    std::string hash;
+    cl_program program;
+    int64_t elapsed;
+};
+
+
+static std::condition_variable shared_programs_cv;
+static std::mutex shared_programs_mutex;
+static std::vector<OclCache::SharedProgram> shared_programs;
+static int64_t shared_saved_time = 0;
+static size_t shared_count       = 0;
+
+
 OclCache::OclCache(int index, cl_context opencl_ctx, GpuContext *ctx, const char *source_code, xmrig::Config *config) :
     m_oclCtx(opencl_ctx),
     m_sourceCode(source_code),
@@ -50,17 +71,24 @@ OclCache::OclCache(int index, cl_context opencl_ctx, GpuContext *ctx, const char
 }
 
 
+// Poll with exponential backoff from 1 ms up to 100 ms, a finished build returns without sleeping
 cl_int OclCache::wait_build(cl_program program, cl_device_id device)
 {
     cl_build_status status;
-    do
-    {
+    size_t delay = 1;
+
+    for (;;) {
         if (OclLib::getProgramBuildInfo(program, device, CL_PROGRAM_BUILD_STATUS, sizeof(cl_build_status), &status, nullptr) != CL_SUCCESS) {
             return OCL_ERR_API;
         }
 
-        sleep(1);
-    } while (status == CL_BUILD_IN_PROGRESS);
+        if (status != CL_BUILD_IN_PROGRESS) {
+            break;
+        }
+
+        sleep(delay);
+        delay = delay < 50 ? delay * 2 : 100;
+    }
 
     return CL_SUCCESS;
 }
@@ -96,6 +124,21 @@ bool OclCache::load()
         return false;
     }
 
+    const int64_t timeStart = xmrig::steadyTimestamp();
+
+    if (share()) {
+        return true;
+    }
+
+    const bool result = build(options);
+    remember(result, xmrig::steadyTimestamp() - timeStart);
+
+    return result;
+}
+
+
+bool OclCache::build(const char *options)
+{
     std::ifstream clBinFile(m_fileName, std::ofstream::in | std::ofstream::binary);
 
     if (!m_config->isOclCache() || !clBinFile.good()) {
@@ -115,9 +158,6 @@ bool OclCache::load()
             return false;
         }
 
-        const cl_uint num_devices = numDevices();
-        const int dev_id          = devId(num_devices);
-
         if (wait_build(m_ctx->Program, m_ctx->DeviceID) != CL_SUCCESS) {
             return false;
         }
@@ -127,27 +167,20 @@ bool OclCache::load()
         LOG_INFO(m_config->isColors() ? "GPU " WHITE_BOLD("#%zu") " " GREEN_BOLD("compilation completed") ", elapsed time " WHITE_BOLD("%.3fs") :
             "GPU #%zu compilation completed, elapsed time %.3fs", m_ctx->deviceIdx, (timeFinish - timeStart) / 1000.0);
 
-        if (!save(dev_id, num_devices)) {
+        std::string binary;
+        if (m_config->isOclCache() && !(getBinary(m_ctx->Program, m_ctx->DeviceID, binary) && saveBinary(m_fileName, binary))) {
             return false;
         }
     }
     else {
-        std::ostringstream ss;
-        ss << clBinFile.rdbuf();
-        std::string s = ss.str();
+        clBinFile.close();
 
-        size_t bin_size = s.size();
-        auto data_ptr = s.data();
-
-        cl_int clStatus;
-        cl_int ret;
-        m_ctx->Program = OclLib::createProgramWithBinary(m_oclCtx, 1, &m_ctx->DeviceID, &bin_size, reinterpret_cast<const unsigned char **>(&data_ptr), &clStatus, &ret);
-        if (ret != CL_SUCCESS) {
-            LOG_NOTICE("Try to delete file %s", m_fileName.c_str());
-            return false;
+        std::string binary;
+        if (loadBinary(m_fileName, binary)) {
+            m_ctx->Program = createFromBinary(m_oclCtx, m_ctx->DeviceID, binary);
         }
 
-        if (OclLib::buildProgram(m_ctx->Program, 1, &m_ctx->DeviceID) != CL_SUCCESS) {
+        if (!m_ctx->Program) {
             LOG_NOTICE("Try to delete file %s", m_fileName.c_str());
             return false;
         }
@@ -156,6 +189,35 @@ bool OclCache::load()
     return true;
 }
 
+
+int64_t OclCache::savedTime()
+{
+    std::lock_guard<std::mutex> g(shared_programs_mutex);
+
+    return shared_saved_time;
+}
+
+
+size_t OclCache::sharedCount()
+{
+    std::lock_guard<std::mutex> g(shared_programs_mutex);
+
+    return shared_count;
+}
+
+
+// The registry holds its own reference, so a program outlives the thread that built it (see ReconfigureOpenCLDevice)
+void OclCache::release()
+{
+    std::lock_guard<std::mutex> g(shared_programs_mutex);
+
+    for (const SharedProgram &shared : shared_programs) {
+        OclLib::releaseProgram(shared.program);
+    }
+
+    shared_programs.clear();
+}
+
 bool OclCache::get_device_string(int platform, cl_device_id device, std::string& result)
 {
     result.clear();
@@ -206,13 +268,9 @@ bool OclCache::prepare(const char *options)
     if (!get_device_string(m_config->platformIndex(), m_ctx->DeviceID, device_string)) {
         return false;
     }
-    calc_hash(device_string, m_sourceCode, options, m_fileName);
+    calc_hash(device_string, m_sourceCode, options, m_hash);
 
-#   ifdef _WIN32
-    m_fileName = prefix() + "\\xmrig\\.cache\\" + m_fileName + ".bin";
-#   else
-    m_fileName = prefix() + "/.cache/" + m_fileName + ".bin";
-#   endif
+    m_fileName = fileName(m_hash);
 
 #   ifndef XMRIG_STRICT_OPENCL_CACHE
     LOG_INFO("           CACHE: %s", m_fileName.c_str());
@@ -222,46 +280,224 @@ bool OclCache::prepare(const char *options)
 }
 
 
-bool OclCache::save(int dev_id, cl_uint num_devices) const
+// Reuse a program already built in this context with the same key: threads on the same device share it,
+// identical devices create their own from its binary instead of compiling or reading the cache file.
+// While another thread builds the key for this device, wait for it; otherwise register as the builder and return false.
+bool OclCache::share()
 {
-    if (!m_config->isOclCache()) {
-        return true;
+    std::unique_lock<std::mutex> lock(shared_programs_mutex);
+
+    for (;;) {
+        const SharedProgram *other = nullptr;
+        bool building              = false;
+        bool deviceBuilding        = false;
+
+        for (const SharedProgram &shared : shared_programs) {
+            if (shared.opencl_ctx != m_oclCtx || shared.hash != m_hash) {
+                continue;
+            }
+
+            if (!shared.program) {
+                building       = true;
+                deviceBuilding = deviceBuilding || shared.device == m_ctx->DeviceID;
+                continue;
+            }
+
+            if (shared.device == m_ctx->DeviceID) {
+                if (OclLib::retainProgram(shared.program) != CL_SUCCESS) {
+                    return false;
+                }
+
+                m_ctx->Program     = shared.program;
+                shared_saved_time += shared.elapsed;
+                shared_count++;
+
+                LOG_INFO(m_config->isColors() ? "GPU " WHITE_BOLD("#%zu") " " GREEN_BOLD("program shared") " with another thread" :
+                                                "GPU #%zu program shared with another thread", m_ctx->deviceIdx);
+                return true;
+            }
+
+            if (!other) {
+                other = &shared;
+            }
+        }
+
+        // Register as the builder for this device first, so other threads on it wait instead of creating a copy too,
+        // a failed copy leaves the registration to the build in load()
+        if (other && !deviceBuilding) {
+            const SharedProgram source = *other;
+            shared_programs.push_back({ m_oclCtx, m_ctx->DeviceID, m_hash, nullptr, 0 });
+
+            std::string binary;
+            const bool copied = getBinary(source.program, source.device, binary);
+
+            lock.unlock();
+
+            return copied && shareBinary(binary, source.elapsed);
+        }
+
+        if (!building) {
+            shared_programs.push_back({ m_oclCtx, m_ctx->DeviceID, m_hash, nullptr, 0 });
+            return false;
+        }
+
+        shared_programs_cv.wait(lock);
     }
+}
 
-    createDirectory();
+
+// Called without shared_programs_mutex, clCreateProgramWithBinary and clBuildProgram must not block other devices
+bool OclCache::shareBinary(const std::string &binary, int64_t original)
+{
+    const int64_t timeStart = xmrig::steadyTimestamp();
+
+    m_ctx->Program = createFromBinary(m_oclCtx, m_ctx->DeviceID, binary);
+    if (!m_ctx->Program) {
+        return false;
+    }
+
+    const int64_t elapsed = xmrig::steadyTimestamp() - timeStart;
+
+    {
+        std::lock_guard<std::mutex> g(shared_programs_mutex);
+
+        shared_saved_time += original > elapsed ? original - elapsed : 0;
+        shared_count++;
+    }
+
+    remember(true, original);
+
+    LOG_INFO(m_config->isColors() ? "GPU " WHITE_BOLD("#%zu") " " GREEN_BOLD("program shared") " with an identical GPU" :
+                                    "GPU #%zu program shared with an identical GPU", m_ctx->deviceIdx);
+    return true;
+}
+
+
+// Publish the result of build() and wake up threads waiting for the same key
+void OclCache::remember(bool result, int64_t elapsed) const
+{
+    {
+        std::lock_guard<std::mutex> g(shared_programs_mutex);
+
+        auto it = std::find_if(shared_programs.begin(), shared_programs.end(), [this](const SharedProgram &shared) {
+            return !shared.program && shared.opencl_ctx == m_oclCtx && shared.device == m_ctx->DeviceID && shared.hash == m_hash;
+        });
+
+        if (!result) {
+            if (it != shared_programs.end()) {
+                shared_programs.erase(it);
+            }
+        }
+        else if (it != shared_programs.end()) {
+            OclLib::retainProgram(m_ctx->Program);
+
+            it->program = m_ctx->Program;
+            it->elapsed = elapsed;
+        }
+        else {
+            OclLib::retainProgram(m_ctx->Program);
+            shared_programs.push_back({ m_oclCtx, m_ctx->DeviceID, m_hash, m_ctx->Program, elapsed });
+        }
+    }
+
+    shared_programs_cv.notify_all();
+}
+
+
+std::string OclCache::fileName(const std::string &name)
+{
+#   ifdef _WIN32
+    return prefix() + "\\xmrig\\.cache\\" + name + ".bin";
+#   else
+    return prefix() + "/.cache/" + name + ".bin";
+#   endif
+}
+
+
+bool OclCache::getBinary(cl_program program, cl_device_id device, std::string &binary)
+{
+    cl_uint num_devices = 0;
+    OclLib::getProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices);
+
+    std::vector<cl_device_id> devices_ids(num_devices);
+    OclLib::getProgramInfo(program, CL_PROGRAM_DEVICES, sizeof(cl_device_id) * devices_ids.size(), devices_ids.data());
+
+    size_t dev_id = 0;
+    while (dev_id < devices_ids.size() && devices_ids[dev_id] != device) {
+        dev_id++;
+    }
+
+    if (dev_id == devices_ids.size()) {
+        return false;
+    }
 
     std::vector<size_t> binary_sizes(num_devices);
-    OclLib::getProgramInfo(m_ctx->Program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t) * binary_sizes.size(), binary_sizes.data());
+    OclLib::getProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t) * binary_sizes.size(), binary_sizes.data());
 
     std::vector<char*> all_programs(num_devices);
     std::vector<std::vector<char>> program_storage;
 
-    size_t mem_size = 0;
     for (size_t i = 0; i < all_programs.size(); ++i) {
         program_storage.emplace_back(std::vector<char>(binary_sizes[i]));
         all_programs[i] = program_storage[i].data();
-        mem_size += binary_sizes[i];
     }
 
-    if (OclLib::getProgramInfo(m_ctx->Program, CL_PROGRAM_BINARIES, num_devices * sizeof(char*), all_programs.data()) != CL_SUCCESS) {
+    if (OclLib::getProgramInfo(program, CL_PROGRAM_BINARIES, num_devices * sizeof(char*), all_programs.data()) != CL_SUCCESS) {
         return false;
     }
 
+    binary.assign(all_programs[dev_id], binary_sizes[dev_id]);
+
+    return !binary.empty();
+}
+
+
+bool OclCache::loadBinary(const std::string &fileName, std::string &binary)
+{
+    std::ifstream clBinFile(fileName, std::ofstream::in | std::ofstream::binary);
+    if (!clBinFile.good()) {
+        return false;
+    }
+
+    std::ostringstream ss;
+    ss << clBinFile.rdbuf();
+    binary = ss.str();
+
+    return !binary.empty();
+}
+
+
+bool OclCache::saveBinary(const std::string &fileName, const std::string &binary)
+{
+    createDirectory();
+
     std::ofstream file_stream;
-    file_stream.open(m_fileName, std::ofstream::out | std::ofstream::binary);
-    file_stream.write(all_programs[dev_id], binary_sizes[dev_id]);
+    file_stream.open(fileName, std::ofstream::out | std::ofstream::binary);
+    file_stream.write(binary.data(), binary.size());
     file_stream.close();
 
-    return true;
+    return file_stream.good();
 }
 
 
-cl_uint OclCache::numDevices() const
+cl_program OclCache::createFromBinary(cl_context opencl_ctx, cl_device_id device, const std::string &binary)
 {
-    cl_uint num_devices = 0;
-    OclLib::getProgramInfo(m_ctx->Program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices);
+    size_t bin_size = binary.size();
+    auto data_ptr = binary.data();
+
+    cl_int clStatus;
+    cl_int ret;
+    cl_program program = OclLib::createProgramWithBinary(opencl_ctx, 1, &device, &bin_size, reinterpret_cast<const unsigned char **>(&data_ptr), &clStatus, &ret);
+    if (ret != CL_SUCCESS) {
+        return nullptr;
+    }
+
+    if (OclLib::buildProgram(program, 1, &device) != CL_SUCCESS) {
+        OclLib::releaseProgram(program);
+        return nullptr;
+    }
 
-    return num_devices;
+    return program;
 }
 
 
@@ -298,21 +534,3 @@ size_t OclCache::worksize(const GpuContext *ctx, xmrig::Variant variant)
 
     return ctx->workSize;
 }
-
-
-int OclCache::devId(cl_uint num_devices) const
-{
-    std::vector<cl_device_id> devices_ids(num_devices);
-    OclLib::getProgramInfo(m_ctx->Program, CL_PROGRAM_DEVICES, sizeof(cl_device_id)* devices_ids.size(), devices_ids.data());
-
-    int dev_id = 0;
-    for (auto & ocl_device : devices_ids) {
-        if (ocl_device == m_ctx->DeviceID) {
-            break;
-        }
-
-        dev_id++;
-    }
-
-    return dev_id;
-}
@@ -26,6 +26,9 @@
 #define XMRIG_OCLCACHE_H
 
 
+#include <vector>
+
+
 #include "amd/GpuContext.h"
 
 
@@ -37,12 +40,25 @@ namespace xmrig {
 class OclCache
 {
 public:
+    struct SharedProgram;
+
     OclCache(int index, cl_context opencl_ctx, GpuContext *ctx, const char *source_code, xmrig::Config *config);
 
     bool load();
 
+    static int64_t savedTime();
+    static size_t sharedCount();
+    static void release();
+
     static void getOptions(xmrig::Algo algo, xmrig::Variant variant, const GpuContext* ctx, char* options, size_t options_size);
     static bool get_device_string(int platform, cl_device_id device, std::string& result);
+    static bool getBinary(cl_program program, cl_device_id device, std::string &binary);
+    static bool loadBinary(const std::string &fileName, std::string &binary);
+    static bool saveBinary(const std::string &fileName, const std::string &binary);
+    static cl_program createFromBinary(cl_context opencl_ctx, cl_device_id device, const std::string &binary);
+    static std::string fileName(const std::string &name);
+    static void createDirectory();
+    static void listDirectory(std::vector<std::string> &names);
     static void calc_hash(const std::string& device_string, const char* source_code, const char *options, std::string& hash);
     static cl_int wait_build(cl_program program, cl_device_id device);
     static int amdDriverMajorVersion(const GpuContext* ctx);
@@ -50,11 +66,11 @@ public:
     static size_t worksize(const GpuContext *ctx, xmrig::Variant variant);
 
 private:
+    bool build(const char *options);
     bool prepare(const char *options);
-    bool save(int dev_id, cl_uint num_devices) const;
-    cl_uint numDevices() const;
-    int devId(cl_uint num_devices) const;
-    void createDirectory() const;
+    bool share();
+    bool shareBinary(const std::string &binary, int64_t original);
+    void remember(bool result, int64_t elapsed) const;
 
     static std::string prefix();
 
@@ -63,6 +79,7 @@ private:
     GpuContext *m_ctx;
     int m_index;
     std::string m_fileName;
+    std::string m_hash;
     xmrig::Config *m_config;
 };
 
@@ -21,6 +21,7 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <dirent.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -28,13 +29,30 @@
 #include "amd/OclCache.h"
 
 
-void OclCache::createDirectory() const
+void OclCache::createDirectory()
 {
     std::string path = prefix() + "/.cache";
     mkdir(path.c_str(), 0744);
 }
 
 
+void OclCache::listDirectory(std::vector<std::string> &names)
+{
+    const std::string path = prefix() + "/.cache";
+
+    DIR *dir = opendir(path.c_str());
+    if (!dir) {
+        return;
+    }
+
+    while (dirent *entry = readdir(dir)) {
+        names.emplace_back(entry->d_name);
+    }
+
+    closedir(dir);
+}
+
+
 std::string OclCache::prefix()
 {
     return ".";
@@ -43,5 +61,5 @@ std::string OclCache::prefix()
 
 void OclCache::sleep(size_t ms)
 {
-    ::usleep(ms / 1000);
+    ::usleep(ms * 1000);
 }
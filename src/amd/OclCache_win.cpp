@@ -30,7 +30,7 @@
 #include "amd/OclCache.h"
 
 
-void OclCache::createDirectory() const
+void OclCache::createDirectory()
 {
     std::string path = prefix() + "/xmrig";
     _mkdir(path.c_str());
@@ -40,6 +40,24 @@ void OclCache::createDirectory() const
 }
 
 
+void OclCache::listDirectory(std::vector<std::string> &names)
+{
+    const std::string path = prefix() + "\\xmrig\\.cache\\*";
+
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA(path.c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    do {
+        names.emplace_back(data.cFileName);
+    } while (FindNextFileA(handle, &data));
+
+    FindClose(handle);
+}
+
+
 std::string OclCache::prefix()
 {
     char path[MAX_PATH + 1];
@@ -22,7 +22,15 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -95,114 +103,190 @@ struct CacheEntry
     cl_program program;
 };
 
-struct BackgroundTaskBase
+struct BackgroundTask
 {
-    virtual ~BackgroundTaskBase() {}
-    virtual void exec() = 0;
+    BackgroundTask(xmrig::Variant variant, uint64_t height, std::string &&source, std::string &&options, std::string &&hash, std::string &&key) :
+        variant(variant),
+        height(height),
+        source(std::move(source)),
+        options(std::move(options)),
+        hash(std::move(hash)),
+        key(std::move(key))
+    {}
+
+    xmrig::Variant variant;
+    uint64_t height;
+    std::string source;
+    std::string options;
+    std::string hash;
+    std::string key;
+    std::vector<GpuContext*> contexts;
 };
 
-template<typename T>
-struct BackgroundTask : public BackgroundTaskBase
-{
-    BackgroundTask(T&& func) : m_func(std::move(func)) {}
-    void exec() override { m_func(); }
+typedef std::shared_ptr<const std::string> ProgramBinary;
 
-    T m_func;
+struct BuildEntry
+{
+    xmrig::Variant variant;
+    uint64_t height;
+    std::shared_future<ProgramBinary> binary;
 };
 
+static const size_t kMaxBackgroundThreads = 4;
+
 static std::mutex CryptonightR_cache_mutex;
-static std::mutex CryptonightR_build_mutex;
 static std::vector<CacheEntry> CryptonightR_cache;
+static std::map<std::string, BuildEntry> CryptonightR_builds;
+static std::map<int, uint64_t> CryptonightR_pruned_height;
 
 static std::mutex background_tasks_mutex;
-static std::vector<BackgroundTaskBase*> background_tasks;
-static std::thread* background_thread = nullptr;
+static std::condition_variable background_tasks_cv;
+static std::deque<BackgroundTask*> background_tasks;
+static std::map<std::string, BackgroundTask*> background_queued;
+static size_t background_threads = 0;
+static size_t background_idle    = 0;
+
+
+static cl_program CryptonightR_build_program(const GpuContext *ctx, xmrig::Variant variant, uint64_t height, const std::string &source, const std::string &options, const std::string &hash);
+
 
 static void background_thread_proc()
 {
-    std::vector<BackgroundTaskBase*> tasks;
     for (;;) {
-        tasks.clear();
+        BackgroundTask *task;
         {
-            std::lock_guard<std::mutex> g(background_tasks_mutex);
-            background_tasks.swap(tasks);
+            std::unique_lock<std::mutex> lock(background_tasks_mutex);
+
+            ++background_idle;
+            background_tasks_cv.wait(lock, []{ return !background_tasks.empty(); });
+            --background_idle;
+
+            task = background_tasks.front();
+            background_tasks.pop_front();
+            background_queued.erase(task->key);
         }
 
-        for (BackgroundTaskBase* task : tasks) {
-            task->exec();
-            delete task;
+        // The first context compiles, the others are created from the binary its build keeps under the key
+        for (const GpuContext *ctx : task->contexts) {
+            CryptonightR_build_program(ctx, task->variant, task->height, task->source, task->options, task->hash);
         }
 
-        OclCache::sleep(500);
+        delete task;
     }
 }
 
-template<typename T>
-static void background_exec(T&& func)
-{
-    BackgroundTaskBase* task = new BackgroundTask<T>(std::move(func));
 
+// Identical requests still waiting in the queue are merged into one task
+static void background_exec(GpuContext *ctx, xmrig::Variant variant, uint64_t height, std::string &&source, std::string &&options, std::string &&hash, std::string &&key)
+{
     std::lock_guard<std::mutex> g(background_tasks_mutex);
+
+    auto it = background_queued.find(key);
+    if (it != background_queued.end()) {
+        std::vector<GpuContext*> &contexts = it->second->contexts;
+        if (std::find(contexts.begin(), contexts.end(), ctx) == contexts.end()) {
+            contexts.push_back(ctx);
+        }
+
+        return;
+    }
+
+    BackgroundTask *task = new BackgroundTask(variant, height, std::move(source), std::move(options), std::move(hash), std::move(key));
+    task->contexts.push_back(ctx);
+
     background_tasks.push_back(task);
-    if (!background_thread) {
-        background_thread = new std::thread(background_thread_proc);
+    background_queued[task->key] = task;
+
+    const size_t max_threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), kMaxBackgroundThreads));
+    if (background_idle == 0 && background_threads < max_threads) {
+        std::thread(background_thread_proc).detach();
+        ++background_threads;
     }
+
+    background_tasks_cv.notify_one();
 }
 
 
-static cl_program CryptonightR_build_program(const GpuContext *ctx, xmrig::Variant variant, uint64_t height, const std::string &source, const std::string &options, std::string hash)
+static std::string CryptonightR_key(xmrig::Variant variant, uint64_t height, const std::string &hash)
 {
-    std::vector<cl_program> old_programs;
-    old_programs.reserve(32);
-    {
-        std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "cnr-%d-%" PRIu64 "-", static_cast<int>(variant), height);
 
-        // Remove old programs from cache
-        for (size_t i = 0; i < CryptonightR_cache.size();)
-        {
-            const CacheEntry& entry = CryptonightR_cache[i];
-            if ((entry.variant == variant) && (entry.height + PRECOMPILATION_DEPTH < height))
-            {
-                LOG_DEBUG("CryptonightR: program for height %" PRIu64 " released (old program)", entry.height);
-                old_programs.push_back(entry.program);
-                CryptonightR_cache[i] = std::move(CryptonightR_cache.back());
-                CryptonightR_cache.pop_back();
-            }
-            else
-            {
-                ++i;
+    return prefix + hash;
+}
+
+
+// Same policy as the in-memory cache: binaries more than PRECOMPILATION_DEPTH heights behind are removed
+static void CryptonightR_remove_old_binaries(xmrig::Variant variant, uint64_t height)
+{
+    std::vector<std::string> names;
+    OclCache::listDirectory(names);
+
+    const std::string ext = ".bin";
+
+    for (const std::string &name : names) {
+        int v      = 0;
+        uint64_t h = 0;
+        if (name.size() <= ext.size() || sscanf(name.c_str(), "cnr-%d-%" SCNu64 "-", &v, &h) != 2) {
+            continue;
+        }
+
+        if ((v == static_cast<int>(variant)) && (h + PRECOMPILATION_DEPTH < height)) {
+            const std::string fileName = OclCache::fileName(name.substr(0, name.size() - ext.size()));
+            if (remove(fileName.c_str()) == 0) {
+                LOG_DEBUG("CryptonightR: binary for height %" PRIu64 " removed (old program)", h);
             }
         }
     }
+}
 
-    for (cl_program p : old_programs) {
-        OclLib::releaseProgram(p);
+
+// Only the first build of a new height scans the cache directory, the other devices and the precompiled
+// heights behind it would find nothing left to remove
+static bool CryptonightR_prune_binaries(xmrig::Variant variant, uint64_t height)
+{
+    std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+
+    uint64_t &pruned = CryptonightR_pruned_height[static_cast<int>(variant)];
+    if (height <= pruned) {
+        return false;
     }
 
-    std::lock_guard<std::mutex> g1(CryptonightR_build_mutex);
+    pruned = height;
+    return true;
+}
 
-    cl_program program = nullptr;
-    {
-        std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
 
-        // Check if the cache already has this program (some other thread might have added it first)
-        for (const CacheEntry& entry : CryptonightR_cache)
+// Must be called with CryptonightR_cache_mutex held
+static cl_program CryptonightR_find_program(const GpuContext *ctx, xmrig::Variant variant, uint64_t height, const std::string &hash)
+{
+    for (const CacheEntry& entry : CryptonightR_cache)
+    {
+        if ((entry.variant == variant) && (entry.height == height) && (entry.deviceIdx == ctx->deviceIdx) && (entry.hash == hash))
         {
-            if ((entry.variant == variant) && (entry.height == height) && (entry.deviceIdx == ctx->deviceIdx) && (entry.hash == hash))
-            {
-                program = entry.program;
-                break;
-            }
+            return entry.program;
         }
     }
 
-    if (program) {
-        return program;
+    return nullptr;
+}
+
+
+static cl_program CryptonightR_compile_program(const GpuContext *ctx, uint64_t height, const std::string &source, const std::string &options, const std::string &fileName, std::string &binary)
+{
+    if (ctx->cache && OclCache::loadBinary(fileName, binary)) {
+        cl_program program = OclCache::createFromBinary(ctx->opencl_ctx, ctx->DeviceID, binary);
+        if (program) {
+            LOG_DEBUG("CryptonightR: program for height %" PRIu64 " loaded from %s", height, fileName.c_str());
+            return program;
+        }
     }
 
+    binary.clear();
+
     cl_int ret;
     const char* s = source.c_str();
-    program = OclLib::createProgramWithSource(ctx->opencl_ctx, 1, &s, nullptr, &ret);
+    cl_program program = OclLib::createProgramWithSource(ctx->opencl_ctx, 1, &s, nullptr, &ret);
     if (ret != CL_SUCCESS)
     {
         LOG_ERR("CryptonightR: clCreateProgramWithSource returned error %s", OclError::toString(ret));
@@ -227,10 +311,140 @@ static cl_program CryptonightR_build_program(const GpuContext *ctx, xmrig::Varia
 
     LOG_DEBUG("CryptonightR: program for height %" PRIu64 " compiled", height);
 
+    if (!OclCache::getBinary(program, ctx->DeviceID, binary)) {
+        binary.clear();
+    }
+    else if (ctx->cache && !OclCache::saveBinary(fileName, binary)) {
+        LOG_WARN("CryptonightR: failed to save program for height %" PRIu64 " to %s", height, fileName.c_str());
+    }
+
+    return program;
+}
+
+
+// Another device built this program, create ours from its binary instead of compiling the source again
+static cl_program CryptonightR_program_from_binary(const GpuContext *ctx, xmrig::Variant variant, uint64_t height, const std::string &hash, const ProgramBinary &binary)
+{
     {
         std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
-        CryptonightR_cache.emplace_back(variant, height, ctx->deviceIdx, std::move(hash), program);
+
+        cl_program program = CryptonightR_find_program(ctx, variant, height, hash);
+        if (program) {
+            return program;
+        }
     }
+
+    if (!binary) {
+        return nullptr;
+    }
+
+    cl_program program = OclCache::createFromBinary(ctx->opencl_ctx, ctx->DeviceID, *binary);
+    if (!program) {
+        LOG_ERR("CryptonightR: failed to create program for height %" PRIu64 " from binary", height);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+
+    cl_program existing = CryptonightR_find_program(ctx, variant, height, hash);
+    if (existing) {
+        OclLib::releaseProgram(program);
+        return existing;
+    }
+
+    CryptonightR_cache.emplace_back(variant, height, ctx->deviceIdx, std::string(hash), program);
+    return program;
+}
+
+
+static cl_program CryptonightR_build_program(const GpuContext *ctx, xmrig::Variant variant, uint64_t height, const std::string &source, const std::string &options, const std::string &hash)
+{
+    std::vector<cl_program> old_programs;
+    old_programs.reserve(32);
+    {
+        std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+
+        // Remove old programs from cache
+        for (size_t i = 0; i < CryptonightR_cache.size();)
+        {
+            const CacheEntry& entry = CryptonightR_cache[i];
+            if ((entry.variant == variant) && (entry.height + PRECOMPILATION_DEPTH < height))
+            {
+                LOG_DEBUG("CryptonightR: program for height %" PRIu64 " released (old program)", entry.height);
+                old_programs.push_back(entry.program);
+                CryptonightR_cache[i] = std::move(CryptonightR_cache.back());
+                CryptonightR_cache.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        for (auto it = CryptonightR_builds.begin(); it != CryptonightR_builds.end();) {
+            if ((it->second.variant == variant) && (it->second.height + PRECOMPILATION_DEPTH < height)) {
+                it = CryptonightR_builds.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    for (cl_program p : old_programs) {
+        OclLib::releaseProgram(p);
+    }
+
+    if (ctx->cache && CryptonightR_prune_binaries(variant, height)) {
+        CryptonightR_remove_old_binaries(variant, height);
+    }
+
+    const std::string key = CryptonightR_key(variant, height, hash);
+
+    // One build per key, other devices and threads asking for the same program wait for its future. A successful
+    // build stays under its key until its height gets old, so devices that ask later load the binary instead of
+    // compiling again, with or without the disk cache
+    std::promise<ProgramBinary> promise;
+    std::shared_future<ProgramBinary> future;
+    {
+        std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+
+        cl_program program = CryptonightR_find_program(ctx, variant, height, hash);
+        if (program) {
+            return program;
+        }
+
+        auto it = CryptonightR_builds.find(key);
+        if (it == CryptonightR_builds.end()) {
+            CryptonightR_builds[key] = { variant, height, promise.get_future().share() };
+        }
+        else {
+            future = it->second.binary;
+        }
+    }
+
+    if (future.valid()) {
+        return CryptonightR_program_from_binary(ctx, variant, height, hash, future.get());
+    }
+
+    std::string binary;
+    cl_program program = CryptonightR_compile_program(ctx, height, source, options, OclCache::fileName(key), binary);
+
+    {
+        std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
+
+        if (program) {
+            CryptonightR_cache.emplace_back(variant, height, ctx->deviceIdx, std::string(hash), program);
+        }
+
+        // A failed build is not kept, the next request tries again
+        if (!program || binary.empty()) {
+            CryptonightR_builds.erase(key);
+        }
+    }
+
+    promise.set_value(binary.empty() ? ProgramBinary() : std::make_shared<const std::string>(std::move(binary)));
+
     return program;
 }
 
@@ -243,11 +457,6 @@ static bool is_64bit(xmrig::Variant variant)
 
 cl_program CryptonightR_get_program(GpuContext* ctx, xmrig::Variant variant, uint64_t height, bool background)
 {
-    if (background) {
-        background_exec([=](){ CryptonightR_get_program(ctx, variant, height, false); });
-        return nullptr;
-    }
-
     const char* source_code_template =
         #include "opencl/wolf-aes.cl"
         #include "opencl/cryptonight_r.cl"
@@ -302,15 +511,18 @@ cl_program CryptonightR_get_program(GpuContext* ctx, xmrig::Variant variant, uin
         std::lock_guard<std::mutex> g(CryptonightR_cache_mutex);
 
         // Check if the cache has this program
-        for (const CacheEntry& entry : CryptonightR_cache)
-        {
-            if ((entry.variant == variant) && (entry.height == height) && (entry.deviceIdx == ctx->deviceIdx) && (entry.hash == hash))
-            {
-                LOG_DEBUG("CryptonightR: program for height %" PRIu64 " found in cache", height);
-                return entry.program;
-            }
+        cl_program program = CryptonightR_find_program(ctx, variant, height, hash);
+        if (program) {
+            LOG_DEBUG("CryptonightR: program for height %" PRIu64 " found in cache", height);
+            return background ? nullptr : program;
         }
     }
 
-    return CryptonightR_build_program(ctx, variant, height, source, options, hash);
+    if (background) {
+        std::string key = CryptonightR_key(variant, height, hash);
+        background_exec(ctx, variant, height, std::move(source_code), options, std::move(hash), std::move(key));
+        return nullptr;
+    }
+
+    return CryptonightR_build_program(ctx, variant, height, source_code, options, hash);
 }
@@ -38,6 +38,7 @@
 #include "amd/OclError.h"
 #include "amd/OclGPU.h"
 #include "amd/OclLib.h"
+#include "amd/OclProfiler.h"
 #include "amd/OclCryptonightR_gen.h"
 #include "common/log/Log.h"
 #include "common/utils/timestamp.h"
@@ -67,6 +68,18 @@ inline static bool setKernelArgFromExtraBuffers(GpuContext *ctx, size_t kernel,
 }
 
 
+inline static bool setKernelArgMem(GpuContext *ctx, size_t kernel, cl_uint argument, const cl_mem *mem)
+{
+    cl_int ret;
+    if ((ret = OclLib::setKernelArg(ctx->Kernels[kernel], argument, sizeof(cl_mem), mem)) != CL_SUCCESS) {
+        LOG_ERR(kSetKernelArgErr, err_to_str(ret), kernel, argument);
+        return false;
+    }
+
+    return true;
+}
+
+
 inline static int cn0KernelOffset(xmrig::Variant variant)
 {
 #   ifndef XMRIG_NO_CN_GPU
@@ -185,18 +198,24 @@ static void printGPU(int index, GpuContext *ctx, xmrig::Config *config)
 }
 
 
+// Assembled by InitOpenCL, shared by all devices
+static std::string kernel_source;
+
+
 size_t InitOpenCLGpu(int index, cl_context opencl_ctx, GpuContext* ctx, const char* source_code, xmrig::Config *config)
 {
     ctx->opencl_ctx = opencl_ctx;
 
-    printGPU(index, ctx, config);
-
     cl_int ret;
-    ctx->CommandQueues = OclLib::createCommandQueue(opencl_ctx, ctx->DeviceID, &ret);
+    ctx->CommandQueues = OclLib::createCommandQueue(opencl_ctx, ctx->DeviceID, &ret, ctx->profiling ? CL_QUEUE_PROFILING_ENABLE : 0);
     if (ret != CL_SUCCESS) {
         return OCL_ERR_API;
     }
 
+    if (ctx->profiling) {
+        ctx->profiler = new OclProfiler(ctx->deviceIdx);
+    }
+
     ctx->InputBuffer = OclLib::createBuffer(opencl_ctx, CL_MEM_READ_ONLY, 128, nullptr, &ret);
     if (ret != CL_SUCCESS) {
         LOG_ERR("Error %s when calling clCreateBuffer to create input buffer.", err_to_str(ret));
@@ -204,6 +223,8 @@ size_t InitOpenCLGpu(int index, cl_context opencl_ctx, GpuContext* ctx, const ch
     }
 
     size_t g_thd = ctx->rawIntensity;
+    ctx->allocatedIntensity = g_thd;
+
     ctx->ExtraBuffers[0] = OclLib::createBuffer(opencl_ctx, CL_MEM_READ_WRITE, xmrig::cn_select_memory(config->algorithm().algo()) * g_thd, nullptr, &ret);
     if (ret != CL_SUCCESS) {
         LOG_ERR("Error %s when calling clCreateBuffer to create hash scratchpads buffer.", err_to_str(ret));
@@ -251,6 +272,35 @@ size_t InitOpenCLGpu(int index, cl_context opencl_ctx, GpuContext* ctx, const ch
         return OCL_ERR_API;
     }
 
+    ctx->Batches[0].StatesBuffer = ctx->ExtraBuffers[1];
+    ctx->Batches[0].OutputBuffer = ctx->OutputBuffer;
+    memcpy(ctx->Batches[0].BranchBuffers, ctx->ExtraBuffers + 2, sizeof(ctx->Batches[0].BranchBuffers));
+
+    // Pipelined mode needs a second set of per-batch buffers, scratchpads are shared because cn0, cn1 and cn2 never overlap in an in-order queue
+    if (ctx->pipeline) {
+        GpuBatch &batch = ctx->Batches[1];
+
+        batch.StatesBuffer = OclLib::createBuffer(opencl_ctx, CL_MEM_READ_WRITE, 200 * g_thd, nullptr, &ret);
+        if (ret != CL_SUCCESS) {
+            LOG_ERR("Error %s when calling clCreateBuffer to create pipeline hash states buffer.", err_to_str(ret));
+            return OCL_ERR_API;
+        }
+
+        for (size_t i = 0; i < 4; ++i) {
+            batch.BranchBuffers[i] = OclLib::createBuffer(opencl_ctx, CL_MEM_READ_WRITE, sizeof(cl_uint) * (g_thd + 2), nullptr, &ret);
+            if (ret != CL_SUCCESS) {
+                LOG_ERR("Error %s when calling clCreateBuffer to create pipeline Branch %zu buffer.", err_to_str(ret), i);
+                return OCL_ERR_API;
+            }
+        }
+
+        batch.OutputBuffer = OclLib::createBuffer(opencl_ctx, CL_MEM_READ_WRITE, sizeof(cl_uint) * 0x100, nullptr, &ret);
+        if (ret != CL_SUCCESS) {
+            LOG_ERR("Error %s when calling clCreateBuffer to create pipeline output buffer.", err_to_str(ret));
+            return OCL_ERR_API;
+        }
+    }
+
     OclCache cache(index, opencl_ctx, ctx, source_code, config);
     if (!cache.load()) {
         return OCL_ERR_API;
@@ -544,14 +594,63 @@ size_t InitOpenCL(const std::vector<GpuContext *> &contexts, xmrig::Config *conf
             contexts[i]->compMode = 0;
         }
 
-        if ((ret = InitOpenCLGpu(i, *opencl_ctx, contexts[i], source_code.c_str(), config)) != OCL_ERR_SUCCESS) {
-            return ret;
-        }
+        contexts[i]->cache          = config->isOclCache();
+        contexts[i]->pipeline       = config->isOclPipeline();
+        contexts[i]->deviceDispatch = config->isOclDeviceDispatch();
+        contexts[i]->profiling      = config->isOclProfiling();
+
+        printGPU(static_cast<int>(i), contexts[i], config);
     }
 
+    kernel_source = std::move(source_code);
+
     return OCL_ERR_SUCCESS;
 }
 
+
+// Per device part of the initialization (buffers, program, kernels), called from each worker thread after InitOpenCL
+// so devices come up in parallel and each one starts hashing as soon as it is ready
+size_t InitOpenCLDevice(GpuContext *ctx, xmrig::Config *config)
+{
+    return InitOpenCLGpu(static_cast<int>(ctx->threadIdx), ctx->opencl_ctx, ctx, kernel_source.c_str(), config);
+}
+
+
+// Must be called from the thread that owns ctx with no batch in flight, programs come from the cache or the shared registry
+size_t ReconfigureOpenCLDevice(GpuContext *ctx, xmrig::Config *config, const GpuSettings &settings)
+{
+    if (settings.intensity == 0 || settings.worksize == 0 || settings.intensity % settings.worksize != 0) {
+        return OCL_ERR_BAD_PARAMS;
+    }
+
+    ReleaseOpenCl(ctx);
+
+    // ProgramCryptonightR is cleared together with the kernels, so the next XMRSetJob creates cn1_cryptonight_r again
+    ctx->InputBuffer         = nullptr;
+    ctx->OutputBuffer        = nullptr;
+    ctx->Program             = nullptr;
+    ctx->ProgramCryptonightR = nullptr;
+    ctx->CommandQueues       = nullptr;
+    ctx->BatchIdx            = 0;
+
+    memset(ctx->ExtraBuffers, 0, sizeof(ctx->ExtraBuffers));
+    memset(ctx->Kernels, 0, sizeof(ctx->Kernels));
+
+    for (GpuBatch &batch : ctx->Batches) {
+        batch = GpuBatch();
+    }
+
+    ctx->rawIntensity       = settings.intensity;
+    ctx->allocatedIntensity = 0;
+    ctx->workSize           = settings.worksize;
+    ctx->stridedIndex       = settings.stridedIndex;
+    ctx->memChunk           = settings.memChunk;
+    ctx->unrollFactor       = settings.unrollFactor;
+    ctx->compMode           = 0;
+
+    return InitOpenCLDevice(ctx, config);
+}
+
 size_t XMRSetJob(GpuContext *ctx, uint8_t *input, size_t input_len, uint64_t target, xmrig::Variant variant, uint64_t height)
 {
     cl_int ret;
@@ -722,6 +821,12 @@ size_t XMRSetJob(GpuContext *ctx, uint8_t *input, size_t input_len, uint64_t tar
                 return OCL_ERR_API;
             }
 
+            // Threads, index of the branch counter, the kernel reads the number of nonces from the device
+            if ((ret = OclLib::setKernelArg(ctx->Kernels[i + 3], 4, sizeof(cl_uint), &numThreads)) != CL_SUCCESS) {
+                LOG_ERR(kSetKernelArgErr, err_to_str(ret), i + 3, 4);
+                return OCL_ERR_API;
+            }
+
             // Output
             if ((ret = OclLib::setKernelArg(ctx->Kernels[i + 3], 2, sizeof(cl_mem), &ctx->OutputBuffer)) != CL_SUCCESS) {
                 LOG_ERR(kSetKernelArgErr, err_to_str(ret), i + 3, 2);
@@ -739,43 +844,31 @@ size_t XMRSetJob(GpuContext *ctx, uint8_t *input, size_t input_len, uint64_t tar
     return OCL_ERR_SUCCESS;
 }
 
-size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
+// Event slot for a command when profiling is enabled, nullptr otherwise
+static inline cl_event *profile(GpuContext *ctx, OclProfiler::Stage stage)
+{
+    return ctx->profiler ? ctx->profiler->event(stage) : nullptr;
+}
+
+
+static size_t enqueueMainKernels(GpuContext *ctx, xmrig::Variant variant, size_t nonce, size_t g_intensity, size_t w_size)
 {
     cl_int ret;
-    cl_uint zero = 0;
-    size_t BranchNonces[4];
-    memset(BranchNonces,0,sizeof(size_t)*4);
 
-    size_t g_intensity = ctx->rawIntensity;
-    size_t w_size = OclCache::worksize(ctx, variant);
     // round up to next multiple of w_size
     size_t g_thd = ((g_intensity + w_size - 1u) / w_size) * w_size;
     // number of global threads must be a multiple of the work group size (w_size)
     assert(g_thd % w_size == 0);
 
-    for(int i = 2; i < 6; ++i) {
-        if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, ctx->ExtraBuffers[i], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), &zero, 0, nullptr, nullptr)) != CL_SUCCESS) {
-            LOG_ERR("Error %s when calling clEnqueueWriteBuffer to zero branch buffer counter %d.", err_to_str(ret), i - 2);
-            return OCL_ERR_API;
-        }
-    }
-
-    if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, ctx->OutputBuffer, CL_FALSE, sizeof(cl_uint) * 0xFF, sizeof(cl_uint), &zero, 0, nullptr, nullptr)) != CL_SUCCESS) {
-        LOG_ERR("Error %s when calling clEnqueueWriteBuffer to fetch results.", err_to_str(ret));
-        return OCL_ERR_API;
-    }
-
-    OclLib::finish(ctx->CommandQueues);
-
-    size_t Nonce[2] = { ctx->Nonce, 1 }, gthreads[2] = { g_thd, 8 }, lthreads[2] = { 8, 8 };
+    size_t Nonce[2] = { nonce, 1 }, gthreads[2] = { g_thd, 8 }, lthreads[2] = { 8, 8 };
     const int cn0_kernel_offset = cn0KernelOffset(variant);
 
-    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn0_kernel_offset], 2, Nonce, gthreads, lthreads, 0, nullptr, nullptr)) != CL_SUCCESS) {
+    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn0_kernel_offset], 2, Nonce, gthreads, lthreads, 0, nullptr, profile(ctx, OclProfiler::Cn0))) != CL_SUCCESS) {
         LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), 0);
         return OCL_ERR_API;
     }
 
-    size_t tmpNonce = ctx->Nonce;
+    size_t tmpNonce = nonce;
     const int cn1_kernel_offset = cn1KernelOffset(variant);
 
     lthreads[0] = w_size;
@@ -786,13 +879,13 @@ size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
         size_t thd = 64;
         size_t intens = g_intensity * thd;
 
-        if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn0_kernel_offset + 1], 1, nullptr, &intens, &thd, 0, nullptr, nullptr)) != CL_SUCCESS) {
+        if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn0_kernel_offset + 1], 1, nullptr, &intens, &thd, 0, nullptr, profile(ctx, OclProfiler::Cn00))) != CL_SUCCESS) {
             LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), cn0_kernel_offset + 1);
             return OCL_ERR_API;
         }
     }
 
-    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn1_kernel_offset], 1, &tmpNonce, &g_thd, lthreads, 0, nullptr, nullptr)) != CL_SUCCESS) {
+    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn1_kernel_offset], 1, &tmpNonce, &g_thd, lthreads, 0, nullptr, profile(ctx, OclProfiler::Cn1))) != CL_SUCCESS) {
         LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), 1);
         return OCL_ERR_API;
     }
@@ -800,56 +893,94 @@ size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
     const int cn2_kernel_offset = cn2KernelOffset(variant);
 
     lthreads[0] = 8;
-    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn2_kernel_offset], 2, Nonce, gthreads, lthreads, 0, nullptr, nullptr)) != CL_SUCCESS) {
+    if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[cn2_kernel_offset], 2, Nonce, gthreads, lthreads, 0, nullptr, profile(ctx, OclProfiler::Cn2))) != CL_SUCCESS) {
         LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), 2);
         return OCL_ERR_API;
     }
 
-    if (variant != xmrig::VARIANT_GPU) {
-        if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->ExtraBuffers[2], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), BranchNonces, 0, nullptr, nullptr) != CL_SUCCESS) {
-            return OCL_ERR_API;
-        }
+    return OCL_ERR_SUCCESS;
+}
 
-        if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->ExtraBuffers[3], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), BranchNonces + 1, 0, nullptr, nullptr) != CL_SUCCESS) {
-            return OCL_ERR_API;
+
+// BranchNonces holds the counters read back by the host, nullptr launches every branch over the whole batch
+// and lets the kernels clip against the counters on the device (device-side dispatch, no host round trip)
+static size_t enqueueBranchKernels(GpuContext *ctx, const cl_uint *BranchNonces, size_t nonce, size_t g_intensity, size_t w_size)
+{
+    cl_int ret;
+
+    for (int i = 0; i < 4; ++i) {
+        const size_t count = BranchNonces ? BranchNonces[i] : g_intensity;
+        if (!count) {
+            continue;
         }
 
-        if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->ExtraBuffers[4], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), BranchNonces + 2, 0, nullptr, nullptr) != CL_SUCCESS) {
+        // round up to next multiple of w_size
+        size_t g_thd = ((count + w_size - 1u) / w_size) * w_size;
+        // number of global threads must be a multiple of the work group size (w_size)
+        assert(g_thd % w_size == 0);
+        size_t tmpNonce = nonce;
+        if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[i + 3], 1, &tmpNonce, &g_thd, &w_size, 0, nullptr, profile(ctx, static_cast<OclProfiler::Stage>(OclProfiler::Blake + i)))) != CL_SUCCESS) {
+            LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), i + 3);
             return OCL_ERR_API;
         }
+    }
+
+    return OCL_ERR_SUCCESS;
+}
+
+
+size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
+{
+    cl_int ret;
+    cl_uint zero = 0;
+    cl_uint BranchNonces[4] = { 0 };
+
+    size_t g_intensity = ctx->rawIntensity;
+    size_t w_size = OclCache::worksize(ctx, variant);
 
-        if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->ExtraBuffers[5], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), BranchNonces + 3, 0, nullptr, nullptr) != CL_SUCCESS) {
+    for(int i = 2; i < 6; ++i) {
+        if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, ctx->ExtraBuffers[i], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), &zero, 0, nullptr, profile(ctx, OclProfiler::Write))) != CL_SUCCESS) {
+            LOG_ERR("Error %s when calling clEnqueueWriteBuffer to zero branch buffer counter %d.", err_to_str(ret), i - 2);
             return OCL_ERR_API;
         }
+    }
+
+    if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, ctx->OutputBuffer, CL_FALSE, sizeof(cl_uint) * 0xFF, sizeof(cl_uint), &zero, 0, nullptr, profile(ctx, OclProfiler::Write))) != CL_SUCCESS) {
+        LOG_ERR("Error %s when calling clEnqueueWriteBuffer to fetch results.", err_to_str(ret));
+        return OCL_ERR_API;
+    }
 
-        OclLib::finish(ctx->CommandQueues);
+    OclLib::finish(ctx->CommandQueues);
 
-        for (int i = 0; i < 4; ++i) {
-            if (BranchNonces[i]) {
-                // Threads
-                if ((OclLib::setKernelArg(ctx->Kernels[i + 3], 4, sizeof(cl_uint), BranchNonces + i)) != CL_SUCCESS) {
-                    LOG_ERR(kSetKernelArgErr, err_to_str(ret), i + 3, 4);
-                    return OCL_ERR_API;
-                }
+    if (enqueueMainKernels(ctx, variant, ctx->Nonce, g_intensity, w_size) != OCL_ERR_SUCCESS) {
+        return OCL_ERR_API;
+    }
 
-                // round up to next multiple of w_size
-                BranchNonces[i] = ((BranchNonces[i] + w_size - 1u) / w_size) * w_size;
-                // number of global threads must be a multiple of the work group size (w_size)
-                assert(BranchNonces[i] % w_size == 0);
-                size_t tmpNonce = ctx->Nonce;
-                if ((ret = OclLib::enqueueNDRangeKernel(ctx->CommandQueues, ctx->Kernels[i + 3], 1, &tmpNonce, BranchNonces + i, &w_size, 0, nullptr, nullptr)) != CL_SUCCESS) {
-                    LOG_ERR("Error %s when calling clEnqueueNDRangeKernel for kernel %d.", err_to_str(ret), i + 3);
+    if (variant != xmrig::VARIANT_GPU) {
+        if (!ctx->deviceDispatch) {
+            for (int i = 0; i < 4; ++i) {
+                if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->ExtraBuffers[i + 2], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), BranchNonces + i, 0, nullptr, profile(ctx, OclProfiler::Read)) != CL_SUCCESS) {
                     return OCL_ERR_API;
                 }
             }
+
+            OclLib::finish(ctx->CommandQueues);
+        }
+
+        if (enqueueBranchKernels(ctx, ctx->deviceDispatch ? nullptr : BranchNonces, ctx->Nonce, g_intensity, w_size) != OCL_ERR_SUCCESS) {
+            return OCL_ERR_API;
         }
     }
 
-    if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->OutputBuffer, CL_TRUE, 0, sizeof(cl_uint) * 0x100, HashOutput, 0, nullptr, nullptr) != CL_SUCCESS) {
+    if (OclLib::enqueueReadBuffer(ctx->CommandQueues, ctx->OutputBuffer, CL_TRUE, 0, sizeof(cl_uint) * 0x100, HashOutput, 0, nullptr, profile(ctx, OclProfiler::Read)) != CL_SUCCESS) {
         return OCL_ERR_API;
     }
 
     OclLib::finish(ctx->CommandQueues);
+
+    if (ctx->profiler) {
+        ctx->profiler->collect();
+    }
     auto & numHashValues = HashOutput[0xFF];
     // avoid out of memory read, we have only storage for 0xFF results
     if (numHashValues > 0xFF) {
@@ -862,6 +993,216 @@ size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
 }
 
 
+// Zero value for non-blocking writes, host memory must stay valid until the command completes
+static const cl_uint kZero = 0;
+
+
+// Kernel arguments are captured at enqueue time, so both batches share the same kernels and only rebind buffers
+static bool setHashingKernelArgs(GpuContext *ctx, const GpuBatch &batch, xmrig::Variant variant)
+{
+    const int cn0_kernel_offset = cn0KernelOffset(variant);
+    const int cn1_kernel_offset = cn1KernelOffset(variant);
+    const int cn2_kernel_offset = cn2KernelOffset(variant);
+
+    if (!setKernelArgMem(ctx, cn0_kernel_offset, 2, &batch.StatesBuffer) ||
+        !setKernelArgMem(ctx, cn1_kernel_offset, 1, &batch.StatesBuffer) ||
+        !setKernelArgMem(ctx, cn2_kernel_offset, 1, &batch.StatesBuffer)) {
+        return false;
+    }
+
+    if (variant == xmrig::VARIANT_GPU) {
+        return setKernelArgMem(ctx, cn0_kernel_offset + 1, 1, &batch.StatesBuffer) && setKernelArgMem(ctx, cn2_kernel_offset, 2, &batch.OutputBuffer);
+    }
+
+    for (cl_uint i = 0; i < 4; ++i) {
+        if (!setKernelArgMem(ctx, cn2_kernel_offset, i + 2, batch.BranchBuffers + i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static size_t enqueueHashing(GpuContext *ctx, GpuBatch &batch, xmrig::Variant variant)
+{
+    cl_int ret;
+    const size_t g_intensity = ctx->rawIntensity;
+
+    if (!setHashingKernelArgs(ctx, batch, variant)) {
+        return OCL_ERR_API;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, batch.BranchBuffers[i], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), &kZero, 0, nullptr, profile(ctx, OclProfiler::Write))) != CL_SUCCESS) {
+            LOG_ERR("Error %s when calling clEnqueueWriteBuffer to zero branch buffer counter %d.", err_to_str(ret), i);
+            return OCL_ERR_API;
+        }
+    }
+
+    if ((ret = OclLib::enqueueWriteBuffer(ctx->CommandQueues, batch.OutputBuffer, CL_FALSE, sizeof(cl_uint) * 0xFF, sizeof(cl_uint), &kZero, 0, nullptr, profile(ctx, OclProfiler::Write))) != CL_SUCCESS) {
+        LOG_ERR("Error %s when calling clEnqueueWriteBuffer to fetch results.", err_to_str(ret));
+        return OCL_ERR_API;
+    }
+
+    batch.Nonce = ctx->Nonce;
+
+    if (enqueueMainKernels(ctx, variant, batch.Nonce, g_intensity, OclCache::worksize(ctx, variant)) != OCL_ERR_SUCCESS) {
+        return OCL_ERR_API;
+    }
+
+    // The queue is in-order, an event on the last read covers all four counters
+    memset(batch.BranchNonces, 0, sizeof(batch.BranchNonces));
+    if (variant != xmrig::VARIANT_GPU && !ctx->deviceDispatch) {
+        for (int i = 0; i < 4; ++i) {
+            if (OclLib::enqueueReadBuffer(ctx->CommandQueues, batch.BranchBuffers[i], CL_FALSE, sizeof(cl_uint) * g_intensity, sizeof(cl_uint), batch.BranchNonces + i, 0, nullptr, i == 3 ? &batch.BranchEvent : profile(ctx, OclProfiler::Read)) != CL_SUCCESS) {
+                return OCL_ERR_API;
+            }
+
+            if (i == 3 && ctx->profiler) {
+                ctx->profiler->add(OclProfiler::Read, batch.BranchEvent);
+            }
+        }
+    }
+
+    batch.stage = GpuBatch::Hashing;
+    ctx->Nonce += (uint32_t) g_intensity;
+
+    return OCL_ERR_SUCCESS;
+}
+
+
+static size_t enqueueFinishing(GpuContext *ctx, GpuBatch &batch, xmrig::Variant variant)
+{
+    if (batch.BranchEvent) {
+        const cl_int ret = OclLib::waitForEvents(1, &batch.BranchEvent);
+
+        OclLib::releaseEvent(batch.BranchEvent);
+        batch.BranchEvent = nullptr;
+
+        if (ret != CL_SUCCESS) {
+            return OCL_ERR_API;
+        }
+    }
+
+    if (variant != xmrig::VARIANT_GPU) {
+        for (size_t i = 0; i < 4; ++i) {
+            if (!setKernelArgMem(ctx, i + 3, 0, &batch.StatesBuffer) || !setKernelArgMem(ctx, i + 3, 1, batch.BranchBuffers + i) || !setKernelArgMem(ctx, i + 3, 2, &batch.OutputBuffer)) {
+                return OCL_ERR_API;
+            }
+        }
+
+        if (enqueueBranchKernels(ctx, ctx->deviceDispatch ? nullptr : batch.BranchNonces, batch.Nonce, ctx->rawIntensity, OclCache::worksize(ctx, variant)) != OCL_ERR_SUCCESS) {
+            return OCL_ERR_API;
+        }
+    }
+
+    if (OclLib::enqueueReadBuffer(ctx->CommandQueues, batch.OutputBuffer, CL_FALSE, 0, sizeof(cl_uint) * 0x100, batch.Output, 0, nullptr, &batch.OutputEvent) != CL_SUCCESS) {
+        return OCL_ERR_API;
+    }
+
+    if (ctx->profiler) {
+        ctx->profiler->add(OclProfiler::Read, batch.OutputEvent);
+    }
+
+    batch.stage = GpuBatch::Finishing;
+
+    return OCL_ERR_SUCCESS;
+}
+
+
+static size_t collectResults(GpuContext *ctx, GpuBatch &batch, cl_event event, cl_uint *HashOutput)
+{
+    const cl_int ret = OclLib::waitForEvents(1, &event);
+    OclLib::releaseEvent(event);
+
+    if (ret != CL_SUCCESS) {
+        return OCL_ERR_API;
+    }
+
+    if (ctx->profiler) {
+        ctx->profiler->collect();
+    }
+
+    memcpy(HashOutput, batch.Output, sizeof(batch.Output));
+
+    auto & numHashValues = HashOutput[0xFF];
+    // avoid out of memory read, we have only storage for 0xFF results
+    if (numHashValues > 0xFF) {
+        numHashValues = 0xFF;
+    }
+
+    return OCL_ERR_SUCCESS;
+}
+
+
+// Pipelined variant of XMRRunJob: enqueue batch N+1 before waiting for the results of batch N-1, so the queue never drains.
+// Queue order is hashing(N), final(N-1), hashing(N+1), final(N), ... HashOutput receives the results of the oldest batch, if any.
+size_t XMRRunJobPipelined(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
+{
+    GpuBatch &current  = ctx->Batches[ctx->BatchIdx];
+    GpuBatch &previous = ctx->Batches[ctx->BatchIdx ^ 1];
+    ctx->BatchIdx ^= 1;
+
+    HashOutput[0xFF] = 0;
+
+    // The slot may still hold the batch before previous, its output read was enqueued ahead of anything below
+    cl_event completed = nullptr;
+    if (current.stage == GpuBatch::Finishing) {
+        completed           = current.OutputEvent;
+        current.OutputEvent = nullptr;
+        current.stage       = GpuBatch::Idle;
+    }
+
+    size_t ret = enqueueHashing(ctx, current, variant);
+
+    if (ret == OCL_ERR_SUCCESS && previous.stage == GpuBatch::Hashing) {
+        OclLib::flush(ctx->CommandQueues);
+        ret = enqueueFinishing(ctx, previous, variant);
+    }
+
+    OclLib::flush(ctx->CommandQueues);
+
+    if (completed && collectResults(ctx, current, completed, HashOutput) != OCL_ERR_SUCCESS) {
+        return OCL_ERR_API;
+    }
+
+    return ret;
+}
+
+
+// Complete the oldest batch in flight without enqueueing new work, used to drain the pipeline before a job switch
+size_t XMRFinishPipelined(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant)
+{
+    HashOutput[0xFF] = 0;
+
+    GpuBatch &oldest = ctx->Batches[ctx->BatchIdx];
+    GpuBatch &next   = ctx->Batches[ctx->BatchIdx ^ 1];
+
+    GpuBatch &batch = oldest.stage != GpuBatch::Idle ? oldest : next;
+    if (batch.stage == GpuBatch::Idle) {
+        return OCL_ERR_SUCCESS;
+    }
+
+    if (batch.stage == GpuBatch::Hashing && enqueueFinishing(ctx, batch, variant) != OCL_ERR_SUCCESS) {
+        batch.stage = GpuBatch::Idle;
+        return OCL_ERR_API;
+    }
+
+    cl_event event    = batch.OutputEvent;
+    batch.OutputEvent = nullptr;
+    batch.stage       = GpuBatch::Idle;
+
+    return collectResults(ctx, batch, event, HashOutput);
+}
+
+
+bool XMRIsPipelineEmpty(const GpuContext *ctx)
+{
+    return ctx->Batches[0].stage == GpuBatch::Idle && ctx->Batches[1].stage == GpuBatch::Idle;
+}
+
+
 void ReleaseOpenCl(GpuContext* ctx)
 {
     OclLib::releaseMemObject(ctx->InputBuffer);
@@ -872,6 +1213,25 @@ void ReleaseOpenCl(GpuContext* ctx)
         OclLib::releaseMemObject(ctx->ExtraBuffers[b]);
     }
 
+    for (GpuBatch &batch : ctx->Batches) {
+        OclLib::releaseEvent(batch.BranchEvent);
+        OclLib::releaseEvent(batch.OutputEvent);
+    }
+
+    delete ctx->profiler;
+    ctx->profiler = nullptr;
+
+    if (ctx->pipeline) {
+        GpuBatch &batch = ctx->Batches[1];
+
+        OclLib::releaseMemObject(batch.StatesBuffer);
+        OclLib::releaseMemObject(batch.OutputBuffer);
+
+        for (cl_mem buffer : batch.BranchBuffers) {
+            OclLib::releaseMemObject(buffer);
+        }
+    }
+
     OclLib::releaseProgram(ctx->Program);
 
     int kernel_count = sizeof(ctx->Kernels) / sizeof(ctx->Kernels[0]);
@@ -54,8 +54,13 @@ private:
 void printPlatforms();
 
 size_t InitOpenCL(const std::vector<GpuContext *> &contexts, xmrig::Config *config, cl_context *opencl_ctx);
+size_t InitOpenCLDevice(GpuContext *ctx, xmrig::Config *config);
+size_t ReconfigureOpenCLDevice(GpuContext *ctx, xmrig::Config *config, const GpuSettings &settings);
 size_t XMRSetJob(GpuContext *ctx, uint8_t *input, size_t input_len, uint64_t target, xmrig::Variant variant, uint64_t height);
 size_t XMRRunJob(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant);
+size_t XMRRunJobPipelined(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant);
+size_t XMRFinishPipelined(GpuContext *ctx, cl_uint *HashOutput, xmrig::Variant variant);
+bool XMRIsPipelineEmpty(const GpuContext *ctx);
 void ReleaseOpenCl(GpuContext* ctx);
 void ReleaseOpenClContext(cl_context opencl_ctx);
 #endif /* XMRIG_OCLGPU_H */
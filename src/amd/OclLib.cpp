@@ -47,6 +47,9 @@ static const char *kEnqueueNDRangeKernel             = "clEnqueueNDRangeKernel";
 static const char *kEnqueueReadBuffer                = "clEnqueueReadBuffer";
 static const char *kEnqueueWriteBuffer               = "clEnqueueWriteBuffer";
 static const char *kFinish                           = "clFinish";
+static const char *kFlush                            = "clFlush";
+static const char *kGetEventInfo                     = "clGetEventInfo";
+static const char *kGetEventProfilingInfo            = "clGetEventProfilingInfo";
 static const char *kGetDeviceIDs                     = "clGetDeviceIDs";
 static const char *kGetDeviceInfo                    = "clGetDeviceInfo";
 static const char *kGetPlatformIDs                   = "clGetPlatformIDs";
@@ -59,6 +62,10 @@ static const char *kReleaseProgram                   = "clReleaseProgram";
 static const char *kReleaseKernel                    = "clReleaseKernel";
 static const char *kReleaseCommandQueue              = "clReleaseCommandQueue";
 static const char *kReleaseContext                   = "clReleaseContext";
+static const char *kReleaseEvent                     = "clReleaseEvent";
+static const char *kRetainEvent                      = "clRetainEvent";
+static const char *kRetainProgram                    = "clRetainProgram";
+static const char *kWaitForEvents                    = "clWaitForEvents";
 
 #if defined(CL_VERSION_2_0)
 typedef cl_command_queue (CL_API_CALL *createCommandQueueWithProperties_t)(cl_context, cl_device_id, const cl_queue_properties *, cl_int *);
@@ -71,6 +78,9 @@ typedef cl_int (CL_API_CALL *enqueueNDRangeKernel_t)(cl_command_queue, cl_kernel
 typedef cl_int (CL_API_CALL *enqueueReadBuffer_t)(cl_command_queue, cl_mem, cl_bool, size_t, size_t, void *, cl_uint, const cl_event *, cl_event *);
 typedef cl_int (CL_API_CALL *enqueueWriteBuffer_t)(cl_command_queue, cl_mem, cl_bool, size_t, size_t, const void *, cl_uint, const cl_event *, cl_event *);
 typedef cl_int (CL_API_CALL *finish_t)(cl_command_queue);
+typedef cl_int (CL_API_CALL *flush_t)(cl_command_queue);
+typedef cl_int (CL_API_CALL *getEventInfo_t)(cl_event, cl_event_info, size_t, void *, size_t *);
+typedef cl_int (CL_API_CALL *getEventProfilingInfo_t)(cl_event, cl_profiling_info, size_t, void *, size_t *);
 typedef cl_int (CL_API_CALL *getDeviceIDs_t)(cl_platform_id, cl_device_type, cl_uint, cl_device_id *, cl_uint *);
 typedef cl_int (CL_API_CALL *getDeviceInfo_t)(cl_device_id, cl_device_info, size_t, void *, size_t *);
 typedef cl_int (CL_API_CALL *getPlatformIDs_t)(cl_uint, cl_platform_id *, cl_uint *);
@@ -87,6 +97,10 @@ typedef cl_int (CL_API_CALL *releaseProgram_t)(cl_program);
 typedef cl_int (CL_API_CALL *releaseKernel_t)(cl_kernel);
 typedef cl_int (CL_API_CALL *releaseCommandQueue_t)(cl_command_queue);
 typedef cl_int (CL_API_CALL *releaseContext_t)(cl_context);
+typedef cl_int (CL_API_CALL *releaseEvent_t)(cl_event);
+typedef cl_int (CL_API_CALL *retainEvent_t)(cl_event);
+typedef cl_int (CL_API_CALL *retainProgram_t)(cl_program);
+typedef cl_int (CL_API_CALL *waitForEvents_t)(cl_uint, const cl_event *);
 
 
 #if defined(CL_VERSION_2_0)
@@ -100,6 +114,9 @@ static enqueueNDRangeKernel_t pEnqueueNDRangeKernel                         = nu
 static enqueueReadBuffer_t pEnqueueReadBuffer                               = nullptr;
 static enqueueWriteBuffer_t pEnqueueWriteBuffer                             = nullptr;
 static finish_t pFinish                                                     = nullptr;
+static flush_t pFlush                                                       = nullptr;
+static getEventInfo_t pGetEventInfo                                         = nullptr;
+static getEventProfilingInfo_t pGetEventProfilingInfo                       = nullptr;
 static getDeviceIDs_t pGetDeviceIDs                                         = nullptr;
 static getDeviceInfo_t pGetDeviceInfo                                       = nullptr;
 static getPlatformIDs_t pGetPlatformIDs                                     = nullptr;
@@ -116,6 +133,10 @@ static releaseProgram_t pReleaseProgram                                     = nu
 static releaseKernel_t pReleaseKernel                                       = nullptr;
 static releaseCommandQueue_t pReleaseCommandQueue                           = nullptr;
 static releaseContext_t pReleaseContext                                     = nullptr;
+static releaseEvent_t pReleaseEvent                                         = nullptr;
+static retainEvent_t pRetainEvent                                           = nullptr;
+static retainProgram_t pRetainProgram                                       = nullptr;
+static waitForEvents_t pWaitForEvents                                       = nullptr;
 
 #define DLSYM(x) if (uv_dlsym(&oclLib, k##x, reinterpret_cast<void**>(&p##x)) == -1) { return false; }
 
@@ -140,6 +161,9 @@ bool OclLib::load()
     DLSYM(EnqueueReadBuffer);
     DLSYM(EnqueueWriteBuffer);
     DLSYM(Finish);
+    DLSYM(Flush);
+    DLSYM(GetEventInfo);
+    DLSYM(GetEventProfilingInfo);
     DLSYM(GetDeviceIDs);
     DLSYM(GetDeviceInfo);
     DLSYM(GetPlatformInfo);
@@ -156,6 +180,10 @@ bool OclLib::load()
     DLSYM(ReleaseKernel);
     DLSYM(ReleaseCommandQueue);
     DLSYM(ReleaseContext);
+    DLSYM(ReleaseEvent);
+    DLSYM(RetainEvent);
+    DLSYM(RetainProgram);
+    DLSYM(WaitForEvents);
 
 #   if defined(CL_VERSION_2_0)
     uv_dlsym(&oclLib, kCreateCommandQueueWithProperties, reinterpret_cast<void**>(&pCreateCommandQueueWithProperties));
@@ -165,19 +193,18 @@ bool OclLib::load()
 }
 
 
-cl_command_queue OclLib::createCommandQueue(cl_context context, cl_device_id device, cl_int *errcode_ret)
+cl_command_queue OclLib::createCommandQueue(cl_context context, cl_device_id device, cl_int *errcode_ret, cl_command_queue_properties properties)
 {
     cl_command_queue result;
 
 #   if defined(CL_VERSION_2_0)
     if (pCreateCommandQueueWithProperties) {
-        const cl_queue_properties commandQueueProperties[] = { 0, 0, 0 };
+        const cl_queue_properties commandQueueProperties[] = { properties ? static_cast<cl_queue_properties>(CL_QUEUE_PROPERTIES) : 0, properties, 0 };
         result = pCreateCommandQueueWithProperties(context, device, commandQueueProperties, errcode_ret);
     }
     else {
 #   endif
-        const cl_command_queue_properties commandQueueProperties = { 0 };
-        result = pCreateCommandQueue(context, device, commandQueueProperties, errcode_ret);
+        result = pCreateCommandQueue(context, device, properties, errcode_ret);
 #   if defined(CL_VERSION_2_0)
     }
 #   endif
@@ -253,6 +280,45 @@ cl_int OclLib::finish(cl_command_queue command_queue)
 }
 
 
+cl_int OclLib::flush(cl_command_queue command_queue)
+{
+    assert(pFlush != nullptr);
+
+    const cl_int ret = pFlush(command_queue);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kFlush);
+    }
+
+    return ret;
+}
+
+
+cl_int OclLib::getEventInfo(cl_event event, cl_event_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret)
+{
+    assert(pGetEventInfo != nullptr);
+
+    const cl_int ret = pGetEventInfo(event, param_name, param_value_size, param_value, param_value_size_ret);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kGetEventInfo);
+    }
+
+    return ret;
+}
+
+
+cl_int OclLib::getEventProfilingInfo(cl_event event, cl_profiling_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret)
+{
+    assert(pGetEventProfilingInfo != nullptr);
+
+    const cl_int ret = pGetEventProfilingInfo(event, param_name, param_value_size, param_value, param_value_size_ret);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kGetEventProfilingInfo);
+    }
+
+    return ret;
+}
+
+
 cl_int OclLib::getDeviceIDs(cl_platform_id platform, cl_device_type device_type, cl_uint num_entries, cl_device_id *devices, cl_uint *num_devices)
 {
     assert(pGetDeviceIDs != nullptr);
@@ -320,6 +386,10 @@ cl_int OclLib::releaseCommandQueue(cl_command_queue command_queue)
 {
     assert(pReleaseCommandQueue != nullptr);
 
+    if (command_queue == nullptr) {
+        return CL_SUCCESS;
+    }
+
     const cl_int ret = pReleaseCommandQueue(command_queue);
     if (ret != CL_SUCCESS) {
         LOG_ERR(kErrorTemplate, OclError::toString(ret), kReleaseCommandQueue);
@@ -342,6 +412,23 @@ cl_int OclLib::releaseContext(cl_context context)
 }
 
 
+cl_int OclLib::releaseEvent(cl_event event)
+{
+    assert(pReleaseEvent != nullptr);
+
+    if (event == nullptr) {
+        return CL_SUCCESS;
+    }
+
+    const cl_int ret = pReleaseEvent(event);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kReleaseEvent);
+    }
+
+    return ret;
+}
+
+
 cl_int OclLib::releaseKernel(cl_kernel kernel)
 {
     assert(pReleaseKernel != nullptr);
@@ -363,6 +450,10 @@ cl_int OclLib::releaseMemObject(cl_mem mem_obj)
 {
     assert(pReleaseMemObject != nullptr);
 
+    if (mem_obj == nullptr) {
+        return CL_SUCCESS;
+    }
+
     const cl_int ret = pReleaseMemObject(mem_obj);
     if (ret != CL_SUCCESS) {
         LOG_ERR(kErrorTemplate, OclError::toString(ret), kReleaseMemObject);
@@ -376,6 +467,10 @@ cl_int OclLib::releaseProgram(cl_program program)
 {
     assert(pReleaseProgram != nullptr);
 
+    if (program == nullptr) {
+        return CL_SUCCESS;
+    }
+
     const cl_int ret = pReleaseProgram(program);
     if (ret != CL_SUCCESS) {
         LOG_ERR(kErrorTemplate, OclError::toString(ret), kReleaseProgram);
@@ -385,6 +480,32 @@ cl_int OclLib::releaseProgram(cl_program program)
 }
 
 
+cl_int OclLib::retainEvent(cl_event event)
+{
+    assert(pRetainEvent != nullptr);
+
+    const cl_int ret = pRetainEvent(event);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kRetainEvent);
+    }
+
+    return ret;
+}
+
+
+cl_int OclLib::retainProgram(cl_program program)
+{
+    assert(pRetainProgram != nullptr);
+
+    const cl_int ret = pRetainProgram(program);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kRetainProgram);
+    }
+
+    return ret;
+}
+
+
 cl_int OclLib::setKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void *arg_value)
 {
     assert(pSetKernelArg != nullptr);
@@ -393,6 +514,19 @@ cl_int OclLib::setKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size
 }
 
 
+cl_int OclLib::waitForEvents(cl_uint num_events, const cl_event *event_list)
+{
+    assert(pWaitForEvents != nullptr);
+
+    const cl_int ret = pWaitForEvents(num_events, event_list);
+    if (ret != CL_SUCCESS) {
+        LOG_ERR(kErrorTemplate, OclError::toString(ret), kWaitForEvents);
+    }
+
+    return ret;
+}
+
+
 cl_kernel OclLib::createKernel(cl_program program, const char *kernel_name, cl_int *errcode_ret)
 {
     assert(pCreateKernel != nullptr);
@@ -0,0 +1,222 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <inttypes.h>
+#include <mutex>
+
+
+#include "amd/OclLib.h"
+#include "amd/OclProfiler.h"
+#include "common/log/Log.h"
+
+
+static const char *stageNames[] = {
+    "cn0", "cn00", "cn1", "cn2", "blake", "groestl", "jh", "skein", "write", "read"
+};
+
+
+static std::mutex mutex;
+static std::vector<OclProfiler::Device *> registry;
+
+
+// Histograms live as long as the process, several threads of the same GPU share one device entry
+static OclProfiler::Device *findDevice(size_t deviceIdx)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (OclProfiler::Device *device : registry) {
+        if (device->index == deviceIdx) {
+            return device;
+        }
+    }
+
+    OclProfiler::Device *device = new OclProfiler::Device();
+    device->index = deviceIdx;
+
+    for (OclProfiler::Histogram &histogram : device->stages) {
+        for (std::atomic<uint64_t> &bucket : histogram.buckets) {
+            bucket = 0;
+        }
+
+        histogram.count = 0;
+        histogram.max   = 0;
+        histogram.total = 0;
+    }
+
+    registry.push_back(device);
+
+    return device;
+}
+
+
+double OclProfiler::Histogram::average() const
+{
+    const uint64_t n = count.load(std::memory_order_relaxed);
+
+    return n ? total.load(std::memory_order_relaxed) / 1e6 / n : 0.0;
+}
+
+
+// Upper bound of the bucket holding the requested percentile, in milliseconds
+double OclProfiler::Histogram::percentile(double p) const
+{
+    const uint64_t n = count.load(std::memory_order_relaxed);
+    if (n == 0) {
+        return 0.0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(n * p);
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < kBuckets; ++i) {
+        sum += buckets[i].load(std::memory_order_relaxed);
+
+        if (sum > rank) {
+            return (2ULL << i) / 1000.0;
+        }
+    }
+
+    return max.load(std::memory_order_relaxed) / 1e6;
+}
+
+
+OclProfiler::OclProfiler(size_t deviceIdx) :
+    m_device(findDevice(deviceIdx)),
+    m_head(0),
+    m_tail(0)
+{
+}
+
+
+OclProfiler::~OclProfiler()
+{
+    for (; m_head != m_tail; ++m_head) {
+        OclLib::releaseEvent(m_pending[m_head % kPending].event);
+    }
+}
+
+
+// Slot for the event of the next command, nullptr (no profiling) if too many commands are still in flight
+cl_event *OclProfiler::event(Stage stage)
+{
+    if (m_tail - m_head == kPending) {
+        return nullptr;
+    }
+
+    Pending &pending = m_pending[m_tail++ % kPending];
+    pending.stage = stage;
+    pending.event = nullptr;
+
+    return &pending.event;
+}
+
+
+// Profile a command whose event is already owned by the caller
+void OclProfiler::add(Stage stage, cl_event event)
+{
+    cl_event *slot = this->event(stage);
+    if (slot && event && OclLib::retainEvent(event) == CL_SUCCESS) {
+        *slot = event;
+    }
+}
+
+
+// The queue is in-order, so stop at the first command that is not complete yet
+void OclProfiler::collect()
+{
+    while (m_head != m_tail) {
+        Pending &pending = m_pending[m_head % kPending];
+
+        if (pending.event) {
+            cl_int status = CL_COMPLETE;
+            if (OclLib::getEventInfo(pending.event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status) == CL_SUCCESS && status > CL_COMPLETE) {
+                return;
+            }
+
+            cl_ulong start = 0;
+            cl_ulong end   = 0;
+
+            if (status == CL_COMPLETE &&
+                OclLib::getEventProfilingInfo(pending.event, CL_PROFILING_COMMAND_START, sizeof(start), &start) == CL_SUCCESS &&
+                OclLib::getEventProfilingInfo(pending.event, CL_PROFILING_COMMAND_END, sizeof(end), &end) == CL_SUCCESS &&
+                end >= start) {
+                record(m_device->stages[pending.stage], end - start);
+            }
+
+            OclLib::releaseEvent(pending.event);
+        }
+
+        m_head++;
+    }
+}
+
+
+const char *OclProfiler::stageName(size_t stage)
+{
+    return stage < StageMax ? stageNames[stage] : "unknown";
+}
+
+
+std::vector<const OclProfiler::Device *> OclProfiler::devices()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return std::vector<const Device *>(registry.begin(), registry.end());
+}
+
+
+void OclProfiler::print()
+{
+    for (const Device *device : devices()) {
+        for (size_t i = 0; i < StageMax; ++i) {
+            const Histogram &histogram = device->stages[i];
+            const uint64_t count       = histogram.count.load(std::memory_order_relaxed);
+
+            if (count == 0) {
+                continue;
+            }
+
+            LOG_INFO(" GPU #%zu %-7s avg %8.3f ms | p50 %8.3f ms | p99 %8.3f ms | max %8.3f ms | %" PRIu64,
+                     device->index, stageNames[i], histogram.average(), histogram.percentile(0.5), histogram.percentile(0.99),
+                     histogram.max.load(std::memory_order_relaxed) / 1e6, count);
+        }
+    }
+}
+
+
+void OclProfiler::record(Histogram &histogram, uint64_t ns)
+{
+    size_t bucket = 0;
+    for (uint64_t us = ns / 1000; us > 1 && bucket < kBuckets - 1; us >>= 1) {
+        bucket++;
+    }
+
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.total.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t max = histogram.max.load(std::memory_order_relaxed);
+    while (ns > max && !histogram.max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
@@ -0,0 +1,109 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_OCLPROFILER_H
+#define XMRIG_OCLPROFILER_H
+
+
+#if defined(__APPLE__)
+#   include <OpenCL/cl.h>
+#else
+#   include "3rdparty/CL/cl.h"
+#endif
+
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+/* Collects OpenCL profiling events of one GPU thread into the latency histograms of its device */
+class OclProfiler
+{
+public:
+    enum Stage {
+        Cn0,
+        Cn00,
+        Cn1,
+        Cn2,
+        Blake,
+        Groestl,
+        JH,
+        Skein,
+        Write,
+        Read,
+        StageMax
+    };
+
+    constexpr static size_t kBuckets = 24;
+
+    // Bucket i counts commands that took [2^i, 2^(i+1)) microseconds, bucket 0 also holds anything below 1 us
+    struct Histogram
+    {
+        std::atomic<uint64_t> buckets[kBuckets];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> max;
+        std::atomic<uint64_t> total;
+
+        double average() const;
+        double percentile(double p) const;
+    };
+
+    struct Device
+    {
+        size_t index;
+        Histogram stages[StageMax];
+    };
+
+    OclProfiler(size_t deviceIdx);
+    ~OclProfiler();
+
+    cl_event *event(Stage stage);
+    void add(Stage stage, cl_event event);
+    void collect();
+
+    static const char *stageName(size_t stage);
+    static std::vector<const Device *> devices();
+    static void print();
+
+private:
+    constexpr static size_t kPending = 64;
+
+    struct Pending
+    {
+        Stage stage;
+        cl_event event;
+    };
+
+    static void record(Histogram &histogram, uint64_t ns);
+
+    Device *m_device;
+    Pending m_pending[kPending];
+    size_t m_head;
+    size_t m_tail;
+};
+
+
+#endif /* XMRIG_OCLPROFILER_H */
@@ -22,6 +22,7 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <math.h>
 #include <string.h>
 #include <uv.h>
@@ -33,6 +34,8 @@
 #endif
 
 
+#include "amd/GpuSensors.h"
+#include "amd/OclProfiler.h"
 #include "api/ApiRouter.h"
 #include "common/api/HttpReply.h"
 #include "common/api/HttpRequest.h"
@@ -46,6 +49,7 @@
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 #include "version.h"
 #include "workers/Hashrate.h"
 #include "workers/Workers.h"
@@ -68,6 +72,7 @@ ApiRouter::ApiRouter(xmrig::Controller *controller) :
 
     setWorkerId(controller->config()->apiWorkerId());
     genId(controller->config()->apiId());
+    updateSummary();
 }
 
 
@@ -79,6 +84,7 @@ ApiRouter::~ApiRouter()
 void ApiRouter::ApiRouter::get(const xmrig::HttpRequest &req, xmrig::HttpReply &reply) const
 {
     rapidjson::Document doc;
+    const bool pretty = req.isPretty();
 
     if (req.match("/1/config")) {
         if (req.isRestricted()) {
@@ -88,24 +94,32 @@ void ApiRouter::ApiRouter::get(const xmrig::HttpRequest &req, xmrig::HttpReply &
 
         m_controller->config()->getJSON(doc);
 
-        return finalize(reply, doc);
+        return finalize(reply, doc, pretty);
     }
 
     if (req.match("/1/threads")) {
         getThreads(doc);
 
-        return finalize(reply, doc);
+        return finalize(reply, doc, pretty);
     }
 
-    doc.SetObject();
+    if (req.match("/1/profile")) {
+        getProfile(doc);
+
+        return finalize(reply, doc, pretty);
+    }
+
+    if (req.match("/metrics")) {
+        return getMetrics(reply);
+    }
 
-    getIdentify(doc);
-    getMiner(doc);
-    getHashrate(doc);
-    getResults(doc);
-    getConnection(doc);
+    if (req.match("/1/gpus")) {
+        getGpus(doc);
 
-    return finalize(reply, doc);
+        return finalize(reply, doc, pretty);
+    }
+
+    return getSummary(reply, pretty);
 }
 
 
@@ -116,6 +130,15 @@ void ApiRouter::exec(const xmrig::HttpRequest &req, xmrig::HttpReply &reply)
         return;
     }
 
+    if (req.method() == xmrig::HttpRequest::Put && req.match("/1/autotune")) {
+        Workers::requestAutotune();
+        return;
+    }
+
+    if (req.method() == xmrig::HttpRequest::Put && req.match("/1/intensity")) {
+        return setIntensity(req, reply);
+    }
+
     reply.status = 404;
 }
 
@@ -123,25 +146,45 @@ void ApiRouter::exec(const xmrig::HttpRequest &req, xmrig::HttpReply &reply)
 void ApiRouter::tick(const xmrig::NetworkState &network)
 {
     m_network = network;
+
+    updateSummary();
 }
 
 
 void ApiRouter::onConfigChanged(xmrig::Config *config, xmrig::Config *previousConfig)
 {
     updateWorkerId(config->apiWorkerId(), previousConfig->apiWorkerId());
+    updateSummary();
 }
 
 
-void ApiRouter::finalize(xmrig::HttpReply &reply, rapidjson::Document &doc) const
+// The reply owns its memory, m_buffer keeps its capacity for the next request
+void ApiRouter::finalize(xmrig::HttpReply &reply) const
 {
-    rapidjson::StringBuffer buffer(nullptr, 4096);
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-    writer.SetMaxDecimalPlaces(10);
-    doc.Accept(writer);
-
     reply.status = 200;
-    reply.buf    = strdup(buffer.GetString());
-    reply.size   = buffer.GetSize();
+    reply.buf    = static_cast<char *>(malloc(m_buffer.GetSize()));
+    reply.size   = m_buffer.GetSize();
+
+    memcpy(reply.buf, m_buffer.GetString(), reply.size);
+}
+
+
+void ApiRouter::finalize(xmrig::HttpReply &reply, rapidjson::Document &doc, bool pretty) const
+{
+    m_buffer.Clear();
+
+    if (pretty) {
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(m_buffer);
+        writer.SetMaxDecimalPlaces(10);
+        doc.Accept(writer);
+    }
+    else {
+        rapidjson::Writer<rapidjson::StringBuffer> writer(m_buffer);
+        writer.SetMaxDecimalPlaces(10);
+        doc.Accept(writer);
+    }
+
+    finalize(reply);
 }
 
 
@@ -185,103 +228,182 @@ void ApiRouter::genId(const char *id)
 }
 
 
-void ApiRouter::getConnection(rapidjson::Document &doc) const
-{
-    auto &allocator = doc.GetAllocator();
 
-    rapidjson::Value connection(rapidjson::kObjectType);
-    connection.AddMember("pool",      rapidjson::StringRef(m_network.pool), allocator);
-    connection.AddMember("uptime",    m_network.connectionTime(), allocator);
-    connection.AddMember("ping",      m_network.latency(), allocator);
-    connection.AddMember("failures",  m_network.failures, allocator);
-    connection.AddMember("error_log", rapidjson::Value(rapidjson::kArrayType), allocator);
-
-    doc.AddMember("connection", connection, allocator);
-}
+// Per card sensor means and efficiency over the same 10s/60s/15m windows as the hashrate
+void ApiRouter::getGpus(rapidjson::Document &doc) const
+{
+    using namespace rapidjson;
 
+    static const size_t intervals[] = { Hashrate::ShortInterval, Hashrate::MediumInterval, Hashrate::LargeInterval };
 
-void ApiRouter::getHashrate(rapidjson::Document &doc) const
-{
+    doc.SetObject();
     auto &allocator = doc.GetAllocator();
+    const Hashrate *hr = Workers::hashrate();
+    const std::vector<xmrig::IThread *> &threads = m_controller->config()->threads();
 
-    rapidjson::Value hashrate(rapidjson::kObjectType);
-    rapidjson::Value total(rapidjson::kArrayType);
-    rapidjson::Value threads(rapidjson::kArrayType);
+    std::vector<size_t> devices;
+    for (const xmrig::IThread *thread : threads) {
+        if (std::find(devices.begin(), devices.end(), thread->index()) == devices.end()) {
+            devices.push_back(thread->index());
+        }
+    }
 
-    const Hashrate *hr = Workers::hashrate();
+    Value list(kArrayType);
+
+    for (size_t device : devices) {
+        Value gpu(kObjectType);
+        Value ids(kArrayType);
+        Value hashrate(kArrayType);
+        Value temperature(kArrayType);
+        Value fan(kArrayType);
+        Value power(kArrayType);
+        Value busy(kArrayType);
+        Value perWatt(kArrayType);
+        Value perBusy(kArrayType);
+
+        for (size_t i = 0; i < threads.size(); ++i) {
+            if (threads[i]->index() == device) {
+                ids.PushBack(static_cast<uint64_t>(i), allocator);
+            }
+        }
 
-    total.PushBack(normalize(hr->calc(Hashrate::ShortInterval)),  allocator);
-    total.PushBack(normalize(hr->calc(Hashrate::MediumInterval)), allocator);
-    total.PushBack(normalize(hr->calc(Hashrate::LargeInterval)),  allocator);
+        for (size_t ms : intervals) {
+            double total = 0.0;
+            for (size_t i = 0; i < threads.size(); ++i) {
+                const double data = threads[i]->index() == device ? hr->calc(i, ms) : 0.0;
+                if (isnormal(data)) {
+                    total += data;
+                }
+            }
+
+            GpuSensors::Average average = { nan(""), nan(""), nan(""), nan("") };
+            GpuSensors::average(device, ms, average);
+
+            hashrate.PushBack(normalize(total), allocator);
+            temperature.PushBack(normalize(average.temperature), allocator);
+            fan.PushBack(normalize(average.fan), allocator);
+            power.PushBack(normalize(average.power), allocator);
+            busy.PushBack(normalize(average.busy), allocator);
+            perWatt.PushBack(normalize(total / average.power), allocator);
+            perBusy.PushBack(normalize(total / average.busy), allocator);
+        }
 
-    for (size_t i = 0; i < Workers::threads(); i++) {
-        rapidjson::Value thread(rapidjson::kArrayType);
-        thread.PushBack(normalize(hr->calc(i, Hashrate::ShortInterval)),  allocator);
-        thread.PushBack(normalize(hr->calc(i, Hashrate::MediumInterval)), allocator);
-        thread.PushBack(normalize(hr->calc(i, Hashrate::LargeInterval)),  allocator);
+        Value efficiency(kObjectType);
+        efficiency.AddMember("hashes_per_watt", perWatt, allocator);
+        efficiency.AddMember("hashes_per_busy", perBusy, allocator);
 
-        threads.PushBack(thread, allocator);
+        gpu.AddMember("index",       static_cast<uint64_t>(device), allocator);
+        gpu.AddMember("threads",     ids, allocator);
+        gpu.AddMember("hashrate",    hashrate, allocator);
+        gpu.AddMember("temperature", temperature, allocator);
+        gpu.AddMember("fan",         fan, allocator);
+        gpu.AddMember("power",       power, allocator);
+        gpu.AddMember("busy",        busy, allocator);
+        gpu.AddMember("efficiency",  efficiency, allocator);
+
+        list.PushBack(gpu, allocator);
     }
 
-    hashrate.AddMember("total",   total, allocator);
-    hashrate.AddMember("highest", normalize(hr->highest()), allocator);
-    hashrate.AddMember("threads", threads, allocator);
-    doc.AddMember("hashrate", hashrate, allocator);
+    doc.AddMember("gpus", list, allocator);
 }
 
 
-void ApiRouter::getIdentify(rapidjson::Document &doc) const
-{
-    doc.AddMember("id",        rapidjson::StringRef(m_id),       doc.GetAllocator());
-    doc.AddMember("worker_id", rapidjson::StringRef(m_workerId), doc.GetAllocator());
-}
 
 
-void ApiRouter::getMiner(rapidjson::Document &doc) const
+void ApiRouter::getMetrics(xmrig::HttpReply &reply) const
 {
-    using namespace xmrig;
-    auto &allocator = doc.GetAllocator();
+    size_t size     = 0;
+    const char *buf = m_metrics.render(m_network, m_controller->config()->threads(), size);
+
+    reply.status      = 200;
+    reply.contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    reply.buf         = static_cast<char *>(malloc(size));
+    reply.size        = size;
 
-    rapidjson::Value cpu(rapidjson::kObjectType);
-    cpu.AddMember("brand",   rapidjson::StringRef(Cpu::info()->brand()), allocator);
-    cpu.AddMember("aes",     Cpu::info()->hasAES(), allocator);
-    cpu.AddMember("x64",     Cpu::info()->isX64(), allocator);
-    cpu.AddMember("sockets", Cpu::info()->sockets(), allocator);
-
-    doc.AddMember("version",      APP_VERSION, allocator);
-    doc.AddMember("kind",         APP_KIND, allocator);
-    doc.AddMember("ua",           rapidjson::StringRef(Platform::userAgent()), allocator);
-    doc.AddMember("cpu",          cpu, allocator);
-    doc.AddMember("algo",         rapidjson::StringRef(m_controller->config()->algorithm().name()), allocator);
-    doc.AddMember("hugepages",    Workers::hugePages() > 0, allocator);
-    doc.AddMember("donate_level", m_controller->config()->donateLevel(), allocator);
-    doc.AddMember("max-gpu-temp", m_controller->config()->maxtemp(), allocator);
-    doc.AddMember("gpu-temp-falloff", m_controller->config()->falloff(), allocator);
-    doc.AddMember("gpu-fan-level", m_controller->config()->fanlevel(), allocator);
+    memcpy(reply.buf, buf, size);
 }
 
 
-void ApiRouter::getResults(rapidjson::Document &doc) const
+
+// Per device latency histograms of every kernel and transfer, empty unless opencl-profiling is enabled
+void ApiRouter::getProfile(rapidjson::Document &doc) const
 {
+    doc.SetObject();
     auto &allocator = doc.GetAllocator();
 
-    rapidjson::Value results(rapidjson::kObjectType);
+    rapidjson::Value devices(rapidjson::kArrayType);
 
-    results.AddMember("diff_current",  m_network.diff, allocator);
-    results.AddMember("shares_good",   m_network.accepted, allocator);
-    results.AddMember("shares_total",  m_network.accepted + m_network.rejected, allocator);
-    results.AddMember("avg_time",      m_network.avgTime(), allocator);
-    results.AddMember("hashes_total",  m_network.total, allocator);
+    for (const OclProfiler::Device *device : OclProfiler::devices()) {
+        rapidjson::Value stages(rapidjson::kObjectType);
 
-    rapidjson::Value best(rapidjson::kArrayType);
-    for (size_t i = 0; i < m_network.topDiff.size(); ++i) {
-        best.PushBack(m_network.topDiff[i], allocator);
+        for (size_t i = 0; i < OclProfiler::StageMax; ++i) {
+            const OclProfiler::Histogram &histogram = device->stages[i];
+            const uint64_t count = histogram.count.load(std::memory_order_relaxed);
+
+            if (count == 0) {
+                continue;
+            }
+
+            rapidjson::Value buckets(rapidjson::kArrayType);
+            for (const std::atomic<uint64_t> &bucket : histogram.buckets) {
+                buckets.PushBack(bucket.load(std::memory_order_relaxed), allocator);
+            }
+
+            rapidjson::Value stage(rapidjson::kObjectType);
+            stage.AddMember("count",   count, allocator);
+            stage.AddMember("avg",     normalize(histogram.average()), allocator);
+            stage.AddMember("p50",     normalize(histogram.percentile(0.5)), allocator);
+            stage.AddMember("p99",     normalize(histogram.percentile(0.99)), allocator);
+            stage.AddMember("max",     normalize(histogram.max.load(std::memory_order_relaxed) / 1e6), allocator);
+            stage.AddMember("buckets", buckets, allocator);
+
+            stages.AddMember(rapidjson::StringRef(OclProfiler::stageName(i)), stage, allocator);
+        }
+
+        rapidjson::Value value(rapidjson::kObjectType);
+        value.AddMember("index",  static_cast<uint64_t>(device->index), allocator);
+        value.AddMember("stages", stages, allocator);
+
+        devices.PushBack(value, allocator);
     }
 
-    results.AddMember("best",      best, allocator);
-    results.AddMember("error_log", rapidjson::Value(rapidjson::kArrayType), allocator);
+    doc.AddMember("enabled", m_controller->config()->isOclProfiling(), allocator);
+    doc.AddMember("unit",    "ms", allocator);
+    doc.AddMember("devices", devices, allocator);
+}
+
+
+
+// Compact output is the cached head, the live hashrate and the cached tail, pretty output is written in full
+void ApiRouter::getSummary(xmrig::HttpReply &reply, bool pretty) const
+{
+    m_buffer.Clear();
+
+    if (pretty) {
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(m_buffer);
+        writer.SetMaxDecimalPlaces(10);
+
+        writer.StartObject();
+        writeIdentify(writer);
+        writeMiner(writer);
+        writer.Key("hashrate");
+        writeHashrate(writer);
+        writeResults(writer);
+        writeConnection(writer);
+        writer.EndObject();
+
+        return finalize(reply);
+    }
+
+    memcpy(m_buffer.Push(m_summaryHead.size()), m_summaryHead.data(), m_summaryHead.size());
+
+    rapidjson::Writer<rapidjson::StringBuffer> writer(m_buffer);
+    writer.SetMaxDecimalPlaces(10);
+    writeHashrate(writer);
+
+    memcpy(m_buffer.Push(m_summaryTail.size()), m_summaryTail.data(), m_summaryTail.size());
 
-    doc.AddMember("results", results, allocator);
+    finalize(reply);
 }
 
 
@@ -305,6 +427,19 @@ void ApiRouter::getThreads(rapidjson::Document &doc) const
         hashrate.PushBack(normalize(hr->calc(i, Hashrate::MediumInterval)), allocator);
         hashrate.PushBack(normalize(hr->calc(i, Hashrate::LargeInterval)),  allocator);
 
+        value.AddMember("current_intensity", static_cast<uint64_t>(Workers::intensity(i)), allocator);
+
+        GpuSensors::Sample sample;
+        if (GpuSensors::read(thread->index(), sample)) {
+            rapidjson::Value sensors(rapidjson::kObjectType);
+            sensors.AddMember("temperature", sample.temperature, allocator);
+            sensors.AddMember("fan",         sample.fan, allocator);
+            sensors.AddMember("power",       sample.power, allocator);
+            sensors.AddMember("busy",        sample.busy, allocator);
+
+            value.AddMember("sensors", sensors, allocator);
+        }
+
         i++;
 
         value.AddMember("hashrate", hashrate, allocator);
@@ -315,6 +450,31 @@ void ApiRouter::getThreads(rapidjson::Document &doc) const
 }
 
 
+// {"intensity": N} for all threads or {"thread": I, "intensity": N} for one, 0 restores the configured intensity
+void ApiRouter::setIntensity(const xmrig::HttpRequest &req, xmrig::HttpReply &reply) const
+{
+    rapidjson::Document doc;
+    if (!req.body() || doc.Parse(req.body()).HasParseError() || !doc.IsObject() || !doc.HasMember("intensity") || !doc["intensity"].IsUint()) {
+        reply.status = 400;
+        return;
+    }
+
+    const size_t intensity = doc["intensity"].GetUint();
+
+    if (doc.HasMember("thread")) {
+        if (!doc["thread"].IsUint() || !Workers::setIntensity(doc["thread"].GetUint(), intensity)) {
+            reply.status = 404;
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < Workers::threads(); ++i) {
+        Workers::setIntensity(i, intensity);
+    }
+}
+
+
 void ApiRouter::setWorkerId(const char *id)
 {
     memset(m_workerId, 0, sizeof(m_workerId));
@@ -328,6 +488,42 @@ void ApiRouter::setWorkerId(const char *id)
 }
 
 
+// Everything in the summary except the hashrate only changes on tick or on a config change
+void ApiRouter::updateSummary()
+{
+    rapidjson::StringBuffer buffer(nullptr, 1024);
+
+    {
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.SetMaxDecimalPlaces(10);
+
+        writer.StartObject();
+        writeIdentify(writer);
+        writeMiner(writer);
+        writer.Key("hashrate");
+
+        // the writer emits the name separator as a prefix of the next value, which is written later by another writer
+        m_summaryHead.assign(buffer.GetString(), buffer.GetSize());
+        m_summaryHead.push_back(':');
+    }
+
+    buffer.Clear();
+
+    {
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.SetMaxDecimalPlaces(10);
+
+        writer.StartObject();
+        writeResults(writer);
+        writeConnection(writer);
+        writer.EndObject();
+
+        m_summaryTail.assign(1, ',');
+        m_summaryTail.append(buffer.GetString() + 1, buffer.GetSize() - 1);
+    }
+}
+
+
 void ApiRouter::updateWorkerId(const char *id, const char *previousId)
 {
     if (id == previousId) {
@@ -340,3 +536,133 @@ void ApiRouter::updateWorkerId(const char *id, const char *previousId)
 
     setWorkerId(id);
 }
+
+
+template<typename T>
+void ApiRouter::writeConnection(T &writer) const
+{
+    writer.Key("connection");
+    writer.StartObject();
+    writer.Key("pool");
+    writer.String(m_network.pool);
+    writer.Key("uptime");
+    writer.Int(m_network.connectionTime());
+    writer.Key("ping");
+    writer.Uint(m_network.latency());
+    writer.Key("failures");
+    writer.Uint64(m_network.failures);
+    writer.Key("error_log");
+    writer.StartArray();
+    writer.EndArray();
+    writer.EndObject();
+}
+
+
+// Writes only the value, the caller writes the "hashrate" key
+template<typename T>
+void ApiRouter::writeHashrate(T &writer) const
+{
+    const Hashrate *hr = Workers::hashrate();
+
+    writer.StartObject();
+    writer.Key("total");
+    writer.StartArray();
+    writer.Double(normalize(hr->calc(Hashrate::ShortInterval)));
+    writer.Double(normalize(hr->calc(Hashrate::MediumInterval)));
+    writer.Double(normalize(hr->calc(Hashrate::LargeInterval)));
+    writer.EndArray();
+
+    writer.Key("highest");
+    writer.Double(normalize(hr->highest()));
+
+    writer.Key("threads");
+    writer.StartArray();
+    for (size_t i = 0; i < Workers::threads(); i++) {
+        writer.StartArray();
+        writer.Double(normalize(hr->calc(i, Hashrate::ShortInterval)));
+        writer.Double(normalize(hr->calc(i, Hashrate::MediumInterval)));
+        writer.Double(normalize(hr->calc(i, Hashrate::LargeInterval)));
+        writer.EndArray();
+    }
+    writer.EndArray();
+    writer.EndObject();
+}
+
+
+template<typename T>
+void ApiRouter::writeIdentify(T &writer) const
+{
+    writer.Key("id");
+    writer.String(m_id);
+    writer.Key("worker_id");
+    writer.String(m_workerId);
+}
+
+
+template<typename T>
+void ApiRouter::writeMiner(T &writer) const
+{
+    using namespace xmrig;
+
+    writer.Key("version");
+    writer.String(APP_VERSION);
+    writer.Key("kind");
+    writer.String(APP_KIND);
+    writer.Key("ua");
+    writer.String(Platform::userAgent());
+
+    writer.Key("cpu");
+    writer.StartObject();
+    writer.Key("brand");
+    writer.String(Cpu::info()->brand());
+    writer.Key("aes");
+    writer.Bool(Cpu::info()->hasAES());
+    writer.Key("x64");
+    writer.Bool(Cpu::info()->isX64());
+    writer.Key("sockets");
+    writer.Int(Cpu::info()->sockets());
+    writer.EndObject();
+
+    writer.Key("algo");
+    writer.String(m_controller->config()->algorithm().name());
+    writer.Key("hugepages");
+    writer.Bool(Workers::hugePages() > 0);
+    writer.Key("donate_level");
+    writer.Int(m_controller->config()->donateLevel());
+    writer.Key("max-gpu-temp");
+    writer.Int(m_controller->config()->maxtemp());
+    writer.Key("gpu-temp-falloff");
+    writer.Int(m_controller->config()->falloff());
+    writer.Key("gpu-fan-level");
+    writer.Int(m_controller->config()->fanlevel());
+}
+
+
+template<typename T>
+void ApiRouter::writeResults(T &writer) const
+{
+    writer.Key("results");
+    writer.StartObject();
+    writer.Key("diff_current");
+    writer.Uint(m_network.diff);
+    writer.Key("shares_good");
+    writer.Uint64(m_network.accepted);
+    writer.Key("shares_total");
+    writer.Uint64(m_network.accepted + m_network.rejected);
+    writer.Key("avg_time");
+    writer.Uint(m_network.avgTime());
+    writer.Key("hashes_total");
+    writer.Uint64(m_network.total);
+
+    writer.Key("best");
+    writer.StartArray();
+    for (size_t i = 0; i < m_network.topDiff.size(); ++i) {
+        writer.Uint64(m_network.topDiff[i]);
+    }
+    writer.EndArray();
+
+    writer.Key("error_log");
+    writer.StartArray();
+    writer.EndArray();
+    writer.EndObject();
+}
@@ -26,9 +26,14 @@
 #define XMRIG_APIROUTER_H
 
 
+#include <string>
+
+
+#include "api/Metrics.h"
 #include "api/NetworkState.h"
 #include "common/interfaces/IControllerListener.h"
 #include "rapidjson/fwd.h"
+#include "rapidjson/stringbuffer.h"
 
 
 class Hashrate;
@@ -56,19 +61,31 @@ protected:
     void onConfigChanged(xmrig::Config *config, xmrig::Config *previousConfig) override;
 
 private:
-    void finalize(xmrig::HttpReply &reply, rapidjson::Document &doc) const;
+    template<typename T> void writeConnection(T &writer) const;
+    template<typename T> void writeHashrate(T &writer) const;
+    template<typename T> void writeIdentify(T &writer) const;
+    template<typename T> void writeMiner(T &writer) const;
+    template<typename T> void writeResults(T &writer) const;
+
+    void finalize(xmrig::HttpReply &reply) const;
+    void finalize(xmrig::HttpReply &reply, rapidjson::Document &doc, bool pretty) const;
     void genId(const char *id);
-    void getConnection(rapidjson::Document &doc) const;
-    void getHashrate(rapidjson::Document &doc) const;
-    void getIdentify(rapidjson::Document &doc) const;
-    void getMiner(rapidjson::Document &doc) const;
-    void getResults(rapidjson::Document &doc) const;
+    void getGpus(rapidjson::Document &doc) const;
+    void getMetrics(xmrig::HttpReply &reply) const;
+    void getProfile(rapidjson::Document &doc) const;
+    void getSummary(xmrig::HttpReply &reply, bool pretty) const;
     void getThreads(rapidjson::Document &doc) const;
+    void setIntensity(const xmrig::HttpRequest &req, xmrig::HttpReply &reply) const;
     void setWorkerId(const char *id);
+    void updateSummary();
     void updateWorkerId(const char *id, const char *previousId);
 
     char m_id[32];
     char m_workerId[128];
+    mutable Metrics m_metrics;
+    mutable rapidjson::StringBuffer m_buffer;
+    std::string m_summaryHead;
+    std::string m_summaryTail;
     xmrig::NetworkState m_network;
     xmrig::Controller *m_controller;
 };
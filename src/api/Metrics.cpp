@@ -0,0 +1,242 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+
+#include "amd/GpuSensors.h"
+#include "amd/OclProfiler.h"
+#include "api/Metrics.h"
+#include "api/NetworkState.h"
+#include "common/utils/timestamp.h"
+#include "interfaces/IThread.h"
+#include "workers/Hashrate.h"
+#include "workers/Workers.h"
+
+
+static const struct {
+    size_t ms;
+    const char *name;
+} windows[] = {
+    { Hashrate::ShortInterval,  "10s" },
+    { Hashrate::MediumInterval, "60s" },
+    { Hashrate::LargeInterval,  "15m" }
+};
+
+
+// Same as the JSON API, a window that is not covered yet reads 0
+static inline double normalize(double d)
+{
+    return isnormal(d) ? d : 0.0;
+}
+
+
+Metrics::Metrics() :
+    m_size(0),
+    m_buffer(16 * 1024)
+{
+}
+
+
+// Called for every scrape, only walks counters that are already aggregated, nothing is allocated once the buffer has grown
+const char *Metrics::render(const xmrig::NetworkState &network, const std::vector<xmrig::IThread *> &threads, size_t &size)
+{
+    m_size = 0;
+
+    std::vector<size_t> devices;
+    for (const xmrig::IThread *thread : threads) {
+        bool found = false;
+        for (size_t device : devices) {
+            found = found || device == thread->index();
+        }
+
+        if (!found) {
+            devices.push_back(thread->index());
+        }
+    }
+
+    const Hashrate *hr = Workers::hashrate();
+
+    family("xmrig_thread_hashrate_hashes_per_second", "gauge", "Hashrate of a GPU thread");
+    for (size_t i = 0; i < threads.size(); ++i) {
+        for (const auto &w : windows) {
+            write("xmrig_thread_hashrate_hashes_per_second{thread=\"%zu\",gpu=\"%zu\",window=\"%s\"} %.2f\n", i, threads[i]->index(), w.name, hr ? normalize(hr->calc(i, w.ms)) : 0.0);
+        }
+    }
+
+    family("xmrig_gpu_hashrate_hashes_per_second", "gauge", "Hashrate of all threads of a GPU");
+    for (size_t device : devices) {
+        for (const auto &w : windows) {
+            double total = 0.0;
+            for (size_t i = 0; i < threads.size(); ++i) {
+                const double data = hr && threads[i]->index() == device ? hr->calc(i, w.ms) : 0.0;
+                if (isnormal(data)) {
+                    total += data;
+                }
+            }
+
+            write("xmrig_gpu_hashrate_hashes_per_second{gpu=\"%zu\",window=\"%s\"} %.2f\n", device, w.name, total);
+        }
+    }
+
+    family("xmrig_shares_accepted", "counter", "Shares accepted by the pool");
+    write("xmrig_shares_accepted_total %" PRIu64 "\n", network.accepted);
+
+    family("xmrig_shares_rejected", "counter", "Shares rejected by the pool");
+    write("xmrig_shares_rejected_total %" PRIu64 "\n", network.rejected);
+
+    family("xmrig_thread_shares_accepted", "counter", "Shares of a GPU thread accepted by the pool");
+    for (size_t i = 0; i < threads.size(); ++i) {
+        write("xmrig_thread_shares_accepted_total{thread=\"%zu\"} %" PRIu64 "\n", i, i < network.threadAccepted.size() ? network.threadAccepted[i] : 0);
+    }
+
+    family("xmrig_thread_shares_rejected", "counter", "Shares of a GPU thread rejected by the pool");
+    for (size_t i = 0; i < threads.size(); ++i) {
+        write("xmrig_thread_shares_rejected_total{thread=\"%zu\"} %" PRIu64 "\n", i, i < network.threadRejected.size() ? network.threadRejected[i] : 0);
+    }
+
+    family("xmrig_share_latency_seconds", "histogram", "Time from submit to pool response", "seconds");
+    uint64_t count = 0;
+    for (size_t i = 0; i < xmrig::NetworkState::kLatencyBuckets; ++i) {
+        count += network.latencyBuckets[i];
+
+        if (i + 1 < xmrig::NetworkState::kLatencyBuckets) {
+            write("xmrig_share_latency_seconds_bucket{le=\"%.3f\"} %" PRIu64 "\n", xmrig::NetworkState::latencyBounds[i] / 1000.0, count);
+        }
+        else {
+            write("xmrig_share_latency_seconds_bucket{le=\"+Inf\"} %" PRIu64 "\n", count);
+        }
+    }
+    write("xmrig_share_latency_seconds_count %" PRIu64 "\n", count);
+    write("xmrig_share_latency_seconds_sum %.3f\n", network.latencySum / 1000.0);
+
+    family("xmrig_job_age_seconds", "gauge", "Time since the current job arrived", "seconds");
+    if (Workers::jobTimestamp() > 0) {
+        write("xmrig_job_age_seconds %.3f\n", (xmrig::steadyTimestamp() - Workers::jobTimestamp()) / 1000.0);
+    }
+
+    family("xmrig_job_switch_latency_seconds", "gauge", "Time from reading the current job off the socket to publishing it to the GPU threads", "seconds");
+    if (Workers::jobLatency() > 0) {
+        write("xmrig_job_switch_latency_seconds %.6f\n", Workers::jobLatency() / 1e9);
+    }
+
+    // Empty unless --opencl-profiling is enabled, bucket i of a profiler histogram ends at 2^(i+1) us
+    family("xmrig_kernel_duration_seconds", "histogram", "Duration of OpenCL commands per stage", "seconds");
+    for (const OclProfiler::Device *device : OclProfiler::devices()) {
+        for (size_t stage = 0; stage < OclProfiler::StageMax; ++stage) {
+            const OclProfiler::Histogram &histogram = device->stages[stage];
+            const char *name                        = OclProfiler::stageName(stage);
+
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < OclProfiler::kBuckets; ++i) {
+                cumulative += histogram.buckets[i].load(std::memory_order_relaxed);
+
+                if (i + 1 < OclProfiler::kBuckets) {
+                    write("xmrig_kernel_duration_seconds_bucket{gpu=\"%zu\",stage=\"%s\",le=\"%g\"} %" PRIu64 "\n", device->index, name, static_cast<double>(2ull << i) / 1e6, cumulative);
+                }
+                else {
+                    write("xmrig_kernel_duration_seconds_bucket{gpu=\"%zu\",stage=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", device->index, name, cumulative);
+                }
+            }
+
+            write("xmrig_kernel_duration_seconds_count{gpu=\"%zu\",stage=\"%s\"} %" PRIu64 "\n", device->index, name, cumulative);
+            write("xmrig_kernel_duration_seconds_sum{gpu=\"%zu\",stage=\"%s\"} %.6f\n", device->index, name, histogram.total.load(std::memory_order_relaxed) / 1e9);
+        }
+    }
+
+    family("xmrig_gpu_temperature_celsius", "gauge", "GPU temperature", "celsius");
+    for (size_t device : devices) {
+        GpuSensors::Sample sample;
+        if (GpuSensors::read(device, sample)) {
+            write("xmrig_gpu_temperature_celsius{gpu=\"%zu\"} %d\n", device, sample.temperature);
+        }
+    }
+
+    family("xmrig_gpu_fan_percent", "gauge", "GPU fan speed");
+    for (size_t device : devices) {
+        GpuSensors::Sample sample;
+        if (GpuSensors::read(device, sample)) {
+            write("xmrig_gpu_fan_percent{gpu=\"%zu\"} %d\n", device, sample.fan);
+        }
+    }
+
+    family("xmrig_gpu_power_watts", "gauge", "GPU power draw", "watts");
+    for (size_t device : devices) {
+        GpuSensors::Sample sample;
+        if (GpuSensors::read(device, sample)) {
+            write("xmrig_gpu_power_watts{gpu=\"%zu\"} %d\n", device, sample.power);
+        }
+    }
+
+    family("xmrig_gpu_busy_percent", "gauge", "GPU busy");
+    for (size_t device : devices) {
+        GpuSensors::Sample sample;
+        if (GpuSensors::read(device, sample)) {
+            write("xmrig_gpu_busy_percent{gpu=\"%zu\"} %d\n", device, sample.busy);
+        }
+    }
+
+    write("# EOF\n");
+
+    size = m_size;
+    return m_buffer.data();
+}
+
+
+void Metrics::family(const char *name, const char *type, const char *help, const char *unit)
+{
+    write("# TYPE %s %s\n", name, type);
+
+    if (unit) {
+        write("# UNIT %s %s\n", name, unit);
+    }
+
+    write("# HELP %s %s.\n", name, help);
+}
+
+
+void Metrics::write(const char *format, ...)
+{
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        const int size = vsnprintf(m_buffer.data() + m_size, m_buffer.size() - m_size, format, args);
+        va_end(args);
+
+        if (size < 0) {
+            return;
+        }
+
+        if (m_size + size < m_buffer.size()) {
+            m_size += size;
+            return;
+        }
+
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+}
@@ -23,6 +23,7 @@
 
 
 #include <algorithm>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <uv.h>
@@ -32,12 +33,16 @@
 #include "common/net/SubmitResult.h"
 
 
+const uint32_t xmrig::NetworkState::latencyBounds[kLatencyBuckets] = { 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, UINT32_MAX };
+
+
 xmrig::NetworkState::NetworkState() :
     diff(0),
     accepted(0),
     failures(0),
     rejected(0),
     total(0),
+    latencySum(0),
     m_active(false)
 {
     memset(pool, 0, sizeof(pool));
@@ -76,6 +81,24 @@ uint32_t xmrig::NetworkState::latency() const
 
 void xmrig::NetworkState::add(const SubmitResult &result, const char *error)
 {
+    size_t bucket = 0;
+    while (bucket + 1 < kLatencyBuckets && result.elapsed > latencyBounds[bucket]) {
+        bucket++;
+    }
+
+    latencyBuckets[bucket]++;
+    latencySum += result.elapsed;
+
+    if (result.threadId >= 0) {
+        const size_t threadId = static_cast<size_t>(result.threadId);
+        if (threadId >= threadAccepted.size()) {
+            threadAccepted.resize(threadId + 1, 0);
+            threadRejected.resize(threadId + 1, 0);
+        }
+
+        (error ? threadRejected : threadAccepted)[threadId]++;
+    }
+
     if (error) {
         rejected++;
         return;
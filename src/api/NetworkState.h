@@ -39,6 +39,11 @@ class SubmitResult;
 class NetworkState
 {
 public:
+    constexpr static size_t kLatencyBuckets = 10;
+
+    // Upper bounds in ms of the share latency histogram, the last bucket is unbounded
+    static const uint32_t latencyBounds[kLatencyBuckets];
+
     NetworkState();
 
     int connectionTime() const;
@@ -56,6 +61,12 @@ public:
     uint64_t rejected;
     uint64_t total;
 
+    // Cumulative since start, never reset on reconnect
+    std::array<uint64_t, kLatencyBuckets> latencyBuckets { { } };
+    uint64_t latencySum;
+    std::vector<uint64_t> threadAccepted;
+    std::vector<uint64_t> threadRejected;
+
 private:
     bool m_active;
     std::vector<uint16_t> m_latency;
@@ -66,6 +66,15 @@ xmrig::HttpRequest::~HttpRequest()
 }
 
 
+// Responses are compact unless asked for with ?pretty=1
+bool xmrig::HttpRequest::isPretty() const
+{
+    const char *pretty = MHD_lookup_connection_value(m_connection, MHD_GET_ARGUMENT_KIND, "pretty");
+
+    return pretty && strcmp(pretty, "0") != 0 && strcmp(pretty, "false") != 0;
+}
+
+
 bool xmrig::HttpRequest::match(const char *path) const
 {
     return strcmp(m_url, path) == 0;
@@ -131,20 +140,20 @@ const char *xmrig::HttpRequest::body() const
 int xmrig::HttpRequest::end(const HttpReply &reply)
 {
     if (reply.buf) {
-        return end(reply.status, MHD_create_response_from_buffer(reply.size ? reply.size : strlen(reply.buf), (void*) reply.buf, MHD_RESPMEM_MUST_FREE));
+        return end(reply.status, MHD_create_response_from_buffer(reply.size ? reply.size : strlen(reply.buf), (void*) reply.buf, MHD_RESPMEM_MUST_FREE), reply.contentType);
     }
 
-    return end(reply.status, nullptr);
+    return end(reply.status, nullptr, reply.contentType);
 }
 
 
-int xmrig::HttpRequest::end(int status, MHD_Response *rsp)
+int xmrig::HttpRequest::end(int status, MHD_Response *rsp, const char *contentType)
 {
     if (!rsp) {
         rsp = MHD_create_response_from_buffer(0, nullptr, MHD_RESPMEM_PERSISTENT);
     }
 
-    MHD_add_response_header(rsp, "Content-Type", "application/json");
+    MHD_add_response_header(rsp, "Content-Type", contentType);
     MHD_add_response_header(rsp, "Access-Control-Allow-Origin", "*");
     MHD_add_response_header(rsp, "Access-Control-Allow-Methods", "GET, PUT");
     MHD_add_response_header(rsp, "Access-Control-Allow-Headers", "Authorization, Content-Type");
@@ -57,11 +57,12 @@ public:
     inline bool isRestricted() const { return m_restricted; }
     inline Method method() const     { return m_method; }
 
+    bool isPretty() const;
     bool match(const char *path) const;
     bool process(const char *accessToken, bool restricted, xmrig::HttpReply &reply);
     const char *body() const;
     int end(const HttpReply &reply);
-    int end(int status, MHD_Response *rsp);
+    int end(int status, MHD_Response *rsp, const char *contentType = "application/json");
 
 private:
     int auth(const char *accessToken);
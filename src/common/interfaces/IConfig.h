@@ -74,6 +74,9 @@ public:
         MaxTempKey        = 7001,
         FalloffKey        = 7002,
         FanlevelKey       = 7003, 
+        VerifyThreadsKey  = 7004,
+        SysfsRootKey      = 7005,
+        PoolStandbyKey    = 7006,
 
         // xmrig common
         CPUPriorityKey    = 1021,
@@ -103,6 +106,10 @@ public:
         OclMemChunkKey    = 1408,
         OclUnrollKey      = 1409,
         OclCompModeKey    = 1410,
+        OclPipelineKey    = 1411,
+        OclDeviceDispatchKey = 1412,
+        OclProfilingKey   = 1413,
+        OclAutotuneKey    = 1414,
 
         // xmrig-proxy
         AccessLogFileKey   = 'A',
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <iterator>
 #include <stdio.h>
 #include <string.h>
@@ -42,7 +43,6 @@
 #include "common/net/Client.h"
 #include "net/JobResult.h"
 #include "rapidjson/document.h"
-#include "rapidjson/error/en.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 
@@ -55,7 +55,9 @@
 namespace xmrig {
 
 int64_t Client::m_sequence = 1;
+std::vector<uintptr_t> Client::m_flushKeys;
 Storage<Client> Client::m_storage;
+uv_check_t Client::m_flushCheck;
 
 } /* namespace xmrig */
 
@@ -71,7 +73,36 @@ static const char *states[] = {
 #endif
 
 
+static inline char *append(char *out, const char *data, size_t size)
+{
+    memcpy(out, data, size);
+
+    return out + size;
+}
+
+
+static inline char *writeInt(char *out, int64_t value)
+{
+    char buf[24];
+    char *p = buf + sizeof(buf);
+    uint64_t v = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    return append(out, p, static_cast<size_t>(buf + sizeof(buf) - p));
+}
+
+
 xmrig::Client::Client(int id, const char *agent, IClientListener *listener) :
+    m_congested(false),
+    m_flushPending(false),
     m_ipv6(false),
     m_nicehash(false),
     m_quiet(false),
@@ -82,12 +113,13 @@ xmrig::Client::Client(int id, const char *agent, IClientListener *listener) :
     m_retries(5),
     m_retryPause(5000),
     m_failures(0),
-    m_recvBufPos(0),
+    m_submitTemplateSize(0),
     m_state(UnconnectedState),
     m_tls(nullptr),
     m_expire(0),
     m_jobs(0),
     m_keepAlive(0),
+    m_readTime(0),
     m_key(0),
     m_stream(nullptr),
     m_socket(nullptr)
@@ -98,18 +130,21 @@ xmrig::Client::Client(int id, const char *agent, IClientListener *listener) :
     memset(&m_hints, 0, sizeof(m_hints));
 
     m_resolver.data = m_storage.ptr(m_key);
+    m_write.data    = m_storage.ptr(m_key);
 
     m_hints.ai_family   = AF_UNSPEC;
     m_hints.ai_socktype = SOCK_STREAM;
     m_hints.ai_protocol = IPPROTO_TCP;
 
-    m_recvBuf.base = m_buf;
-    m_recvBuf.len  = sizeof(m_buf);
 }
 
 
 xmrig::Client::~Client()
 {
+    if (m_flushPending) {
+        m_flushKeys.erase(std::remove(m_flushKeys.begin(), m_flushKeys.end(), m_key), m_flushKeys.end());
+    }
+
     delete m_socket;
 }
 
@@ -223,48 +258,47 @@ int64_t xmrig::Client::submit(const JobResult &result)
     }
 #   endif
 
-    using namespace rapidjson;
+    // {"id":<seq>,"jsonrpc":"2.0","method":"submit","params":{"id":"<rpc id>","job_id":"<job id>","nonce":"<hex>","result":"<hex>"}}
+    // every part has a fixed upper bound, the line always fits in m_sendBuf
+    char *out = writeInt(append(m_sendBuf, "{\"id\":", 6), m_sequence);
+
+    memcpy(out, m_submitTemplate, m_submitTemplateSize);
+    out += m_submitTemplateSize;
+
+    out = append(out, result.jobId.data(), strlen(result.jobId.data()));
+    out = append(out, "\",\"nonce\":\"", 11);
 
 #   ifdef XMRIG_PROXY_PROJECT
-    const char *nonce = result.nonce;
-    const char *data  = result.result;
+    out = append(out, result.nonce, strlen(result.nonce));
+    out = append(out, "\",\"result\":\"", 12);
+    out = append(out, result.result, strlen(result.result));
 #   else
-    char *nonce = m_sendBuf;
-    char *data  = m_sendBuf + 16;
-
-    Job::toHex(reinterpret_cast<const unsigned char*>(&result.nonce), 4, nonce);
-    nonce[8] = '\0';
+    Job::toHex(reinterpret_cast<const unsigned char*>(&result.nonce), 4, out);
+    out = append(out + 8, "\",\"result\":\"", 12);
 
-    Job::toHex(result.result, 32, data);
-    data[64] = '\0';
+    Job::toHex(result.result, 32, out);
+    out += 64;
 #   endif
 
-    Document doc(kObjectType);
-    auto &allocator = doc.GetAllocator();
-
-    doc.AddMember("id",      m_sequence, allocator);
-    doc.AddMember("jsonrpc", "2.0", allocator);
-    doc.AddMember("method",  "submit", allocator);
-
-    Value params(kObjectType);
-    params.AddMember("id",     StringRef(m_rpcId.data()), allocator);
-    params.AddMember("job_id", StringRef(result.jobId.data()), allocator);
-    params.AddMember("nonce",  StringRef(nonce), allocator);
-    params.AddMember("result", StringRef(data), allocator);
-
     if (m_extensions & AlgoExt) {
-        params.AddMember("algo", StringRef(result.algorithm.shortName()), allocator);
+        const char *algo = result.algorithm.shortName();
+
+        out = append(out, "\",\"algo\":\"", 10);
+        out = append(out, algo, strlen(algo));
     }
 
-    doc.AddMember("params", params, allocator);
+    out = append(out, "\"}}\n", 4);
+    *out = '\0';
 
 #   ifdef XMRIG_PROXY_PROJECT
-    m_results[m_sequence] = SubmitResult(m_sequence, result.diff, result.actualDiff(), result.id);
+    const SubmitResult submit(m_sequence, result.diff, result.actualDiff(), result.id);
 #   else
-    m_results[m_sequence] = SubmitResult(m_sequence, result.diff, result.actualDiff());
+    const SubmitResult submit(m_sequence, result.diff, result.actualDiff(), 0, result.threadId);
 #   endif
 
-    return send(doc);
+    m_results.insert(submit);
+
+    return send(static_cast<size_t>(out - m_sendBuf));
 }
 
 
@@ -320,51 +354,44 @@ bool xmrig::Client::isTLS() const
 }
 
 
-bool xmrig::Client::parseJob(const rapidjson::Value &params, int *code)
+bool xmrig::Client::parseJob(const StratumMessage &msg, int *code)
 {
-    if (!params.IsObject()) {
+    if (!msg.hasJob()) {
         *code = 2;
         return false;
     }
 
+    const StratumMessage::JobParams &params = msg.job();
     Job job(m_id, m_nicehash, m_pool.algorithm(), m_rpcId);
 
-    if (!job.setId(params["job_id"].GetString())) {
+    if (!job.setId(params.id)) {
         *code = 3;
         return false;
     }
 
-    if (!job.setBlob(params["blob"].GetString())) {
+    if (!job.setBlob(params.blob)) {
         *code = 4;
         return false;
     }
 
-    if (!job.setTarget(params["target"].GetString())) {
+    if (!job.setTarget(params.target)) {
         *code = 5;
         return false;
     }
 
-    if (params.HasMember("algo")) {
-        job.setAlgorithm(params["algo"].GetString());
+    if (params.algo) {
+        job.setAlgorithm(params.algo);
     }
 
-    if (params.HasMember("variant")) {
-        const rapidjson::Value &variant = params["variant"];
-
-        if (variant.IsInt()) {
-            job.setVariant(variant.GetInt());
-        }
-        else if (variant.IsString()){
-            job.setVariant(variant.GetString());
-        }
+    if (params.variant) {
+        job.setVariant(params.variant);
+    }
+    else if (params.variantId != -1) {
+        job.setVariant(params.variantId);
     }
 
-    if (params.HasMember("height")) {
-        const rapidjson::Value &variant = params["height"];
-
-        if (variant.IsUint64()) {
-            job.setHeight(variant.GetUint64());
-        }
+    if (params.height) {
+        job.setHeight(params.height);
     }
 
     if (!verifyAlgorithm(job.algorithm())) {
@@ -374,6 +401,7 @@ bool xmrig::Client::parseJob(const rapidjson::Value &params, int *code)
         return false;
     }
 
+    job.setReceived(m_readTime);
     m_job.setClientId(m_rpcId);
 
     if (m_job != job) {
@@ -395,20 +423,18 @@ bool xmrig::Client::parseJob(const rapidjson::Value &params, int *code)
 }
 
 
-bool xmrig::Client::parseLogin(const rapidjson::Value &result, int *code)
+bool xmrig::Client::parseLogin(const StratumMessage &msg, int *code)
 {
-    if (!m_rpcId.setId(result["id"].GetString())) {
+    if (!m_rpcId.setId(msg.loginId())) {
         *code = 1;
         return false;
     }
 
     m_nicehash = m_pool.isNicehash();
+    setSubmitTemplate();
+    parseExtensions(msg);
 
-    if (result.HasMember("extensions")) {
-        parseExtensions(result["extensions"]);
-    }
-
-    const bool rc = parseJob(result["job"], code);
+    const bool rc = parseJob(msg, code);
     m_jobs = 0;
 
     return rc;
@@ -429,11 +455,10 @@ bool xmrig::Client::send(BIO *bio)
 
     bool result = false;
     if (state() == ConnectedState && uv_is_writable(m_stream)) {
-        result = uv_try_write(m_stream, &buf, 1) > 0;
+        m_queue.push(buf.base, buf.len);
+        write();
 
-        if (!result) {
-            close();
-        }
+        result = m_state == ConnectedState;
     }
     else {
         LOG_DEBUG_ERR("[%s] send failed, invalid state: %d", m_pool.url(), m_state);
@@ -479,8 +504,8 @@ int xmrig::Client::resolve(const char *host)
 {
     setState(HostLookupState);
 
-    m_expire     = 0;
-    m_recvBufPos = 0;
+    m_expire = 0;
+    m_recv.reset();
 
     if (m_failures == -1) {
         m_failures = 0;
@@ -525,28 +550,29 @@ int64_t xmrig::Client::send(size_t size)
 {
     LOG_DEBUG("[%s] send (%d bytes): \"%s\"", m_pool.url(), size, m_sendBuf);
 
+    if (state() != ConnectedState || !uv_is_writable(m_stream)) {
+        LOG_DEBUG_ERR("[%s] send failed, invalid state: %d", m_pool.url(), m_state);
+        return -1;
+    }
+
 #   ifndef XMRIG_NO_TLS
     if (isTLS()) {
-        if (!m_tls->send(m_sendBuf, size)) {
-            return -1;
-        }
+        m_tlsPending.insert(m_tlsPending.end(), m_sendBuf, m_sendBuf + size);
     }
     else
 #   endif
     {
-        if (state() != ConnectedState || !uv_is_writable(m_stream)) {
-            LOG_DEBUG_ERR("[%s] send failed, invalid state: %d", m_pool.url(), m_state);
-            return -1;
-        }
+        m_queue.push(m_sendBuf, size);
+    }
 
-        uv_buf_t buf = uv_buf_init(m_sendBuf, (unsigned int) size);
+    if (!m_congested && m_queue.size() > kMaxQueueSize) {
+        m_congested = true;
 
-        if (uv_try_write(m_stream, &buf, 1) < 0) {
-            close();
-            return -1;
-        }
+        LOG_WARN("[%s] pool is reading slowly, %zu KB waiting to be sent", m_pool.url(), m_queue.size() / 1024);
     }
 
+    flushLater();
+
     m_expire = uv_now(uv_default_loop()) + kResponseTimeout;
     return m_sequence++;
 }
@@ -593,6 +619,46 @@ void xmrig::Client::connect(sockaddr *addr)
 }
 
 
+// Runs once per loop iteration after all I/O callbacks, so every line queued by that batch leaves in one write
+void xmrig::Client::flush()
+{
+    m_flushPending = false;
+
+    if (m_state != ConnectedState) {
+        return;
+    }
+
+#   ifndef XMRIG_NO_TLS
+    if (!m_tlsPending.empty()) {
+        m_tls->send(m_tlsPending.data(), m_tlsPending.size());
+        m_tlsPending.clear();
+    }
+#   endif
+
+    write();
+}
+
+
+void xmrig::Client::flushLater()
+{
+    if (m_flushPending) {
+        return;
+    }
+
+    if (m_flushCheck.loop == nullptr) {
+        uv_check_init(uv_default_loop(), &m_flushCheck);
+        uv_unref(reinterpret_cast<uv_handle_t*>(&m_flushCheck));
+    }
+
+    if (m_flushKeys.empty()) {
+        uv_check_start(&m_flushCheck, Client::onFlush);
+    }
+
+    m_flushPending = true;
+    m_flushKeys.push_back(m_key);
+}
+
+
 void xmrig::Client::handshake()
 {
 #   ifndef XMRIG_NO_TLS
@@ -653,6 +719,10 @@ void xmrig::Client::onClose()
 {
     delete m_socket;
 
+    m_queue.clear();
+    m_tlsPending.clear();
+    m_congested = false;
+
     m_stream = nullptr;
     m_socket = nullptr;
     setState(UnconnectedState);
@@ -684,48 +754,37 @@ void xmrig::Client::parse(char *line, size_t len)
         return;
     }
 
-    rapidjson::Document doc;
-    if (doc.ParseInsitu(line).HasParseError()) {
+    StratumMessage msg;
+    if (!msg.parse(line)) {
         if (!isQuiet()) {
-            LOG_ERR("[%s] JSON decode failed: \"%s\"", m_pool.url(), rapidjson::GetParseError_En(doc.GetParseError()));
+            LOG_ERR("[%s] JSON decode failed: \"%s\"", m_pool.url(), msg.error());
         }
 
         return;
     }
 
-    if (!doc.IsObject()) {
-        return;
-    }
-
-    const rapidjson::Value &id = doc["id"];
-    if (id.IsInt64()) {
-        parseResponse(id.GetInt64(), doc["result"], doc["error"]);
+    if (msg.isResponse()) {
+        parseResponse(msg);
     }
     else {
-        parseNotification(doc["method"].GetString(), doc["params"], doc["error"]);
+        parseNotification(msg);
     }
 }
 
 
-void xmrig::Client::parseExtensions(const rapidjson::Value &value)
+void xmrig::Client::parseExtensions(const StratumMessage &msg)
 {
     m_extensions = 0;
 
-    if (!value.IsArray()) {
-        return;
-    }
-
-    for (const rapidjson::Value &ext : value.GetArray()) {
-        if (!ext.IsString()) {
-            continue;
-        }
+    for (size_t i = 0; i < msg.extensions(); ++i) {
+        const char *ext = msg.extension(i);
 
-        if (strcmp(ext.GetString(), "algo") == 0) {
+        if (strcmp(ext, "algo") == 0) {
             m_extensions |= AlgoExt;
             continue;
         }
 
-        if (strcmp(ext.GetString(), "nicehash") == 0) {
+        if (strcmp(ext, "nicehash") == 0) {
             m_extensions |= NicehashExt;
             m_nicehash = true;
             continue;
@@ -734,22 +793,23 @@ void xmrig::Client::parseExtensions(const rapidjson::Value &value)
 }
 
 
-void xmrig::Client::parseNotification(const char *method, const rapidjson::Value &params, const rapidjson::Value &error)
+void xmrig::Client::parseNotification(const StratumMessage &msg)
 {
-    if (error.IsObject()) {
+    if (msg.hasError()) {
         if (!isQuiet()) {
-            LOG_ERR("[%s] error: \"%s\", code: %d", m_pool.url(), error["message"].GetString(), error["code"].GetInt());
+            LOG_ERR("[%s] error: \"%s\", code: %d", m_pool.url(), msg.errorMessage(), msg.errorCode());
         }
         return;
     }
 
+    const char *method = msg.method();
     if (!method) {
         return;
     }
 
     if (strcmp(method, "job") == 0) {
         int code = -1;
-        if (parseJob(params, &code)) {
+        if (parseJob(msg, &code)) {
             m_listener->onJobReceived(this, m_job);
         }
 
@@ -760,19 +820,20 @@ void xmrig::Client::parseNotification(const char *method, const rapidjson::Value
 }
 
 
-void xmrig::Client::parseResponse(int64_t id, const rapidjson::Value &result, const rapidjson::Value &error)
+void xmrig::Client::parseResponse(const StratumMessage &msg)
 {
-    if (error.IsObject()) {
-        const char *message = error["message"].GetString();
-
-        auto it = m_results.find(id);
-        if (it != m_results.end()) {
-            it->second.done();
-            m_listener->onResultAccepted(this, it->second, message);
-            m_results.erase(it);
+    const int64_t id = msg.id();
+
+    if (msg.hasError()) {
+        const char *message = msg.errorMessage();
+
+        SubmitResult submit;
+        if (m_results.take(id, submit)) {
+            submit.done();
+            m_listener->onResultAccepted(this, submit, message);
         }
         else if (!isQuiet()) {
-            LOG_ERR("[%s] error: \"%s\", code: %d", m_pool.url(), message, error["code"].GetInt());
+            LOG_ERR("[%s] error: \"%s\", code: %d", m_pool.url(), message, msg.errorCode());
         }
 
         if (isCriticalError(message)) {
@@ -782,13 +843,13 @@ void xmrig::Client::parseResponse(int64_t id, const rapidjson::Value &result, co
         return;
     }
 
-    if (!result.IsObject()) {
+    if (!msg.hasResult()) {
         return;
     }
 
     if (id == 1) {
         int code = -1;
-        if (!parseLogin(result, &code)) {
+        if (!parseLogin(msg, &code)) {
             if (!isQuiet()) {
                 LOG_ERR("[%s] login error code: %d", m_pool.url(), code);
             }
@@ -803,47 +864,33 @@ void xmrig::Client::parseResponse(int64_t id, const rapidjson::Value &result, co
         return;
     }
 
-    auto it = m_results.find(id);
-    if (it != m_results.end()) {
-        it->second.done();
-        m_listener->onResultAccepted(this, it->second, nullptr);
-        m_results.erase(it);
+    SubmitResult submit;
+    if (m_results.take(id, submit)) {
+        submit.done();
+        m_listener->onResultAccepted(this, submit, nullptr);
     }
 }
 
 
+// A keepalive can only add to a backlog, the pool has not even read what is already queued
 void xmrig::Client::ping()
 {
+    if (m_queue.size() > 0) {
+        return;
+    }
+
     send(snprintf(m_sendBuf, sizeof(m_sendBuf), "{\"id\":%" PRId64 ",\"jsonrpc\":\"2.0\",\"method\":\"keepalived\",\"params\":{\"id\":\"%s\"}}\n", m_sequence, m_rpcId.data()));
 }
 
 
 void xmrig::Client::read()
 {
-    char* end;
-    char* start = m_recvBuf.base;
-    size_t remaining = m_recvBufPos;
+    char *line;
+    size_t size = 0;
 
-    while ((end = static_cast<char*>(memchr(start, '\n', remaining))) != nullptr) {
-        end++;
-        size_t len = end - start;
-        parse(start, len);
-
-        remaining -= len;
-        start = end;
+    while ((line = m_recv.line(size)) != nullptr) {
+        parse(line, size);
     }
-
-    if (remaining == 0) {
-        m_recvBufPos = 0;
-        return;
-    }
-
-    if (start == m_recvBuf.base) {
-        return;
-    }
-
-    memcpy(m_recvBuf.base, start, remaining);
-    m_recvBufPos = remaining;
 }
 
 
@@ -882,6 +929,13 @@ void xmrig::Client::setState(SocketState state)
 }
 
 
+// The part of a submit line between the sequence and the job id only changes with the rpc id, so once per login
+void xmrig::Client::setSubmitTemplate()
+{
+    m_submitTemplateSize = static_cast<size_t>(snprintf(m_submitTemplate, sizeof(m_submitTemplate), ",\"jsonrpc\":\"2.0\",\"method\":\"submit\",\"params\":{\"id\":\"%s\",\"job_id\":\"", m_rpcId.data()));
+}
+
+
 void xmrig::Client::startTimeout()
 {
     m_expire = 0;
@@ -892,6 +946,27 @@ void xmrig::Client::startTimeout()
 }
 
 
+// Starts a scatter/gather write of the queued buffers unless one is already in flight, onWrite() picks up the rest,
+// a socket that cannot keep up only makes the queue longer, nothing is dropped
+void xmrig::Client::write()
+{
+    if (m_queue.isWriting() || !m_queue.isPending() || m_state != ConnectedState) {
+        return;
+    }
+
+    const size_t count = m_queue.start(m_writeBufs);
+    const int rc       = uv_write(&m_write, m_stream, m_writeBufs, static_cast<unsigned int>(count), Client::onWrite);
+
+    if (rc < 0) {
+        LOG_ERR("[%s] write error: \"%s\"", m_pool.url(), uv_strerror(rc));
+
+        m_queue.finish();
+        close();
+    }
+}
+
+
+// Plain connections read straight into the line buffer, TLS records go to m_buf and are decrypted into it
 void xmrig::Client::onAllocBuffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
 {
     auto client = getClient(handle->data);
@@ -899,8 +974,17 @@ void xmrig::Client::onAllocBuffer(uv_handle_t *handle, size_t suggested_size, uv
         return;
     }
 
-    buf->base = &client->m_recvBuf.base[client->m_recvBufPos];
-    buf->len  = client->m_recvBuf.len - client->m_recvBufPos;
+#   ifndef XMRIG_NO_TLS
+    if (client->isTLS()) {
+        buf->base = client->m_buf;
+        buf->len  = sizeof(client->m_buf);
+        return;
+    }
+#   endif
+
+    size_t size = 0;
+    buf->base   = client->m_recv.reserve(size);
+    buf->len    = size;
 }
 
 
@@ -944,6 +1028,17 @@ void xmrig::Client::onConnect(uv_connect_t *req, int status)
 }
 
 
+void xmrig::Client::onFlush(uv_check_t *handle)
+{
+    for (size_t i = 0; i < m_flushKeys.size(); ++i) {
+        m_storage.get(m_flushKeys[i])->flush();
+    }
+
+    m_flushKeys.clear();
+    uv_check_stop(handle);
+}
+
+
 void xmrig::Client::onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
 {
     auto client = getClient(stream->data);
@@ -960,28 +1055,23 @@ void xmrig::Client::onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *b
         return;
     }
 
-    if ((size_t) nread > (sizeof(m_buf) - 8 - client->m_recvBufPos)) {
-        client->close();
-        return;
-    }
-
     assert(client->m_listener != nullptr);
     if (!client->m_listener) {
         return client->reconnect();
     }
 
-    client->m_recvBufPos += nread;
+    client->m_readTime = uv_hrtime();
 
 #   ifndef XMRIG_NO_TLS
     if (client->isTLS()) {
         LOG_DEBUG("[%s] TLS received (%d bytes)", client->m_pool.url(), static_cast<int>(nread));
 
-        client->m_tls->read(client->m_recvBuf.base, client->m_recvBufPos);
-        client->m_recvBufPos = 0;
+        client->m_tls->read(buf->base, static_cast<size_t>(nread));
     }
     else
 #   endif
     {
+        client->m_recv.commit(static_cast<size_t>(nread));
         client->read();
     }
 }
@@ -1035,3 +1125,36 @@ void xmrig::Client::onResolved(uv_getaddrinfo_t *req, int status, struct addrinf
     client->connect(ipv4, ipv6);
     uv_freeaddrinfo(res);
 }
+
+
+void xmrig::Client::onWrite(uv_write_t *req, int status)
+{
+    auto client = getClient(req->data);
+    if (!client) {
+        return;
+    }
+
+    client->m_queue.finish();
+
+    if (status < 0) {
+        if (status != UV_ECANCELED) {
+            LOG_ERR("[%s] write error: \"%s\"", client->m_pool.url(), uv_strerror(status));
+            client->close();
+        }
+
+        return;
+    }
+
+    // A request only starts waiting for its response once it has left the queue
+    if (client->m_expire) {
+        client->m_expire = uv_now(uv_default_loop()) + kResponseTimeout;
+    }
+
+    if (client->m_congested && client->m_queue.size() < kMaxQueueSize / 2) {
+        client->m_congested = false;
+
+        LOG_INFO("[%s] send queue drained", client->m_pool.url());
+    }
+
+    client->write();
+}
@@ -26,7 +26,6 @@
 #define XMRIG_CLIENT_H
 
 
-#include <map>
 #include <uv.h>
 #include <vector>
 
@@ -35,8 +34,12 @@
 #include "common/crypto/Algorithm.h"
 #include "common/net/Id.h"
 #include "common/net/Job.h"
+#include "common/net/RecvBuffer.h"
 #include "common/net/Storage.h"
+#include "common/net/StratumMessage.h"
 #include "common/net/SubmitResult.h"
+#include "common/net/SubmitTable.h"
+#include "common/net/WriteQueue.h"
 #include "rapidjson/fwd.h"
 
 
@@ -62,6 +65,7 @@ public:
     };
 
     constexpr static int kResponseTimeout = 20 * 1000;
+    constexpr static size_t kMaxQueueSize = 256 * 1024;
 
 #   ifndef XMRIG_NO_TLS
     constexpr static int kInputBufferSize = 1024 * 16;
@@ -106,8 +110,8 @@ private:
     bool close();
     bool isCriticalError(const char *message);
     bool isTLS() const;
-    bool parseJob(const rapidjson::Value &params, int *code);
-    bool parseLogin(const rapidjson::Value &result, int *code);
+    bool parseJob(const StratumMessage &msg, int *code);
+    bool parseLogin(const StratumMessage &msg, int *code);
     bool send(BIO *bio);
     bool verifyAlgorithm(const Algorithm &algorithm) const;
     int resolve(const char *host);
@@ -115,36 +119,47 @@ private:
     int64_t send(size_t size);
     void connect(const std::vector<addrinfo*> &ipv4, const std::vector<addrinfo*> &ipv6);
     void connect(sockaddr *addr);
+    void flush();
+    void flushLater();
     void handshake();
     void login();
     void onClose();
     void parse(char *line, size_t len);
-    void parseExtensions(const rapidjson::Value &value);
-    void parseNotification(const char *method, const rapidjson::Value &params, const rapidjson::Value &error);
-    void parseResponse(int64_t id, const rapidjson::Value &result, const rapidjson::Value &error);
+    void parseExtensions(const StratumMessage &msg);
+    void parseNotification(const StratumMessage &msg);
+    void parseResponse(const StratumMessage &msg);
     void ping();
     void read();
     void reconnect();
     void setState(SocketState state);
+    void setSubmitTemplate();
     void startTimeout();
+    void write();
 
     inline bool isQuiet() const { return m_quiet || m_failures >= m_retries; }
 
     static void onAllocBuffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf);
     static void onClose(uv_handle_t *handle);
     static void onConnect(uv_connect_t *req, int status);
+    static void onFlush(uv_check_t *handle);
     static void onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
     static void onResolved(uv_getaddrinfo_t *req, int status, struct addrinfo *res);
+    static void onWrite(uv_write_t *req, int status);
 
     static inline Client *getClient(void *data) { return m_storage.get(data); }
 
     addrinfo m_hints;
+    bool m_congested;
+    bool m_flushPending;
     bool m_ipv6;
     bool m_nicehash;
     bool m_quiet;
+#   ifndef XMRIG_NO_TLS
     char m_buf[kInputBufferSize];
+#   endif
     char m_ip[46];
     char m_sendBuf[2048];
+    char m_submitTemplate[160];
     const char *m_agent;
     IClientListener *m_listener;
     int m_extensions;
@@ -154,22 +169,29 @@ private:
     int64_t m_failures;
     Job m_job;
     Pool m_pool;
-    size_t m_recvBufPos;
+    RecvBuffer<kInputBufferSize> m_recv;
+    std::vector<char> m_tlsPending;
+    size_t m_submitTemplateSize;
     SocketState m_state;
-    std::map<int64_t, SubmitResult> m_results;
+    SubmitTable m_results;
     Tls *m_tls;
     uint64_t m_expire;
     uint64_t m_jobs;
     uint64_t m_keepAlive;
+    uint64_t m_readTime;
     uintptr_t m_key;
-    uv_buf_t m_recvBuf;
+    uv_buf_t m_writeBufs[WriteQueue::kMaxBufs];
     uv_getaddrinfo_t m_resolver;
     uv_stream_t *m_stream;
     uv_tcp_t *m_socket;
+    uv_write_t m_write;
     Id m_rpcId;
+    WriteQueue m_queue;
 
     static int64_t m_sequence;
+    static std::vector<uintptr_t> m_flushKeys;
     static Storage<Client> m_storage;
+    static uv_check_t m_flushCheck;
 };
 
 
@@ -28,6 +28,11 @@
 #include <string.h>
 
 
+#ifndef XMRIG_ARM
+#   include <emmintrin.h>
+#endif
+
+
 #include "common/net/Job.h"
 
 
@@ -67,7 +72,8 @@ xmrig::Job::Job() :
     m_diff(0),
     m_target(0),
     m_blob(),
-    m_height(0)
+    m_height(0),
+    m_received(0)
 {
 }
 
@@ -82,6 +88,7 @@ xmrig::Job::Job(int poolId, bool nicehash, const Algorithm &algorithm, const Id
     m_target(0),
     m_blob(),
     m_height(0),
+    m_received(0),
     m_algorithm(algorithm),
     m_clientId(clientId)
 {
@@ -212,10 +219,41 @@ void xmrig::Job::setHeight(uint64_t height)
 }
 
 
+// Decodes 16 characters per step with SSE2, digits and letters of either case are classified with two range checks
+// and each pair of nibbles is merged inside a 16 bit lane before packing, the tail goes through the scalar loop
 bool xmrig::Job::fromHex(const char* in, unsigned int len, unsigned char* out)
 {
+    unsigned int i = 0;
+
+#   ifndef XMRIG_ARM
+    const __m128i zero   = _mm_set1_epi8('0');
+    const __m128i lower  = _mm_set1_epi8('a');
+    const __m128i case20 = _mm_set1_epi8(0x20);
+    const __m128i ten    = _mm_set1_epi8(10);
+    const __m128i six    = _mm_set1_epi8(6);
+    const __m128i minus1 = _mm_set1_epi8(-1);
+    const __m128i low    = _mm_set1_epi16(0x00FF);
+
+    for (; i + 16 <= len; i += 16) {
+        const __m128i chars  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i digit  = _mm_sub_epi8(chars, zero);
+        const __m128i alpha  = _mm_sub_epi8(_mm_or_si128(chars, case20), lower);
+        const __m128i isDig  = _mm_and_si128(_mm_cmpgt_epi8(digit, minus1), _mm_cmplt_epi8(digit, ten));
+        const __m128i isAlp  = _mm_and_si128(_mm_cmpgt_epi8(alpha, minus1), _mm_cmplt_epi8(alpha, six));
+
+        if (_mm_movemask_epi8(_mm_or_si128(isDig, isAlp)) != 0xFFFF) {
+            return false;
+        }
+
+        const __m128i nibbles = _mm_or_si128(_mm_and_si128(isDig, digit), _mm_and_si128(isAlp, _mm_add_epi8(alpha, ten)));
+        const __m128i bytes   = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, low), 4), _mm_srli_epi16(nibbles, 8));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i / 2), _mm_packus_epi16(bytes, bytes));
+    }
+#   endif
+
     bool error = false;
-    for (unsigned int i = 0; i < len; i += 2) {
+    for (; i < len; i += 2) {
         out[i / 2] = (hf_hex2bin(in[i], error) << 4) | hf_hex2bin(in[i + 1], error);
 
         if (error) {
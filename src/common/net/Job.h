@@ -70,9 +70,11 @@ public:
     inline uint32_t diff() const                      { return static_cast<uint32_t>(m_diff); }
     inline uint64_t target() const                    { return m_target; }
     inline uint64_t height() const                    { return m_height; }
+    inline uint64_t received() const                  { return m_received; }
     inline void reset()                               { m_size = 0; m_diff = 0; }
     inline void setClientId(const Id &id)             { m_clientId = id; }
     inline void setPoolId(int poolId)                 { m_poolId = poolId; }
+    inline void setReceived(uint64_t received)        { m_received = received; }
     inline void setThreadId(int threadId)             { m_threadId = threadId; }
     inline void setVariant(const char *variant)       { m_algorithm.parseVariant(variant); }
     inline void setVariant(int variant)               { m_algorithm.parseVariant(variant); }
@@ -106,6 +108,7 @@ private:
     uint64_t m_target;
     uint8_t m_blob[kMaxBlobSize];
     uint64_t m_height;
+    uint64_t m_received;
     xmrig::Algorithm m_algorithm;
     xmrig::Id m_clientId;
     xmrig::Id m_id;
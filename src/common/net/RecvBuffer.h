@@ -0,0 +1,102 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_RECVBUFFER_H
+#define XMRIG_RECVBUFFER_H
+
+
+#include <stddef.h>
+#include <string.h>
+
+
+namespace xmrig {
+
+
+/* Receive side of a line based socket, reads land behind the unparsed data and complete lines are handed out
+ * in place, a partial line is only moved back to the front once the free space behind it gets short */
+template <size_t SIZE>
+class RecvBuffer
+{
+public:
+    inline RecvBuffer() :
+        m_head(0),
+        m_scan(0),
+        m_tail(0)
+    {
+    }
+
+
+    inline char *reserve(size_t &size)
+    {
+        if (m_head > 0 && (SIZE - m_tail) < SIZE / 4) {
+            memmove(m_data, m_data + m_head, m_tail - m_head);
+
+            m_scan -= m_head;
+            m_tail -= m_head;
+            m_head  = 0;
+        }
+
+        size = SIZE - m_tail;
+
+        return m_data + m_tail;
+    }
+
+
+    // Next complete line including its '\n', the memory stays valid until the following reserve()
+    inline char *line(size_t &size)
+    {
+        char *end = static_cast<char *>(memchr(m_data + m_scan, '\n', m_tail - m_scan));
+        if (!end) {
+            m_scan = m_tail;
+            return nullptr;
+        }
+
+        char *start = m_data + m_head;
+        size        = static_cast<size_t>(end - start) + 1;
+        m_head     += size;
+        m_scan      = m_head;
+
+        if (m_head == m_tail) {
+            m_head = m_scan = m_tail = 0;
+        }
+
+        return start;
+    }
+
+
+    inline void commit(size_t size) { m_tail += size; }
+    inline void reset()             { m_head = m_scan = m_tail = 0; }
+
+private:
+    char m_data[SIZE];
+    size_t m_head;
+    size_t m_scan;
+    size_t m_tail;
+};
+
+
+} /* namespace xmrig */
+
+
+#endif /* XMRIG_RECVBUFFER_H */
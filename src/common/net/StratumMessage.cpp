@@ -0,0 +1,325 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "common/net/StratumMessage.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/reader.h"
+
+
+namespace xmrig {
+
+
+/* Tracks where the parser is with one field tag per open container, values are kept only when the tag
+ * path matches something the miner reads, everything else is skipped without being stored */
+class StratumMessage::Handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler>
+{
+public:
+    enum Field {
+        Root,
+        Other,
+        Id,
+        Method,
+        Error,
+        Result,
+        Params,
+        Message,
+        Code,
+        LoginId,
+        Job,
+        Extensions,
+        JobId,
+        Blob,
+        Target,
+        Algo,
+        Variant,
+        Height
+    };
+
+    enum {
+        kMaxDepth = 16
+    };
+
+    inline Handler(StratumMessage &msg) :
+        m_depth(0),
+        m_key(Root),
+        m_msg(msg)
+    {
+    }
+
+
+    bool Int(int i)         { return Int64(i); }
+    bool Uint(unsigned u)   { return Uint64(u); }
+    bool Null()             { return true; }
+    bool Bool(bool)         { return true; }
+    bool Double(double)     { return true; }
+
+
+    bool Int64(int64_t i)
+    {
+        switch (m_key) {
+        case Id:
+            if (m_depth == 1) {
+                m_msg.m_id         = i;
+                m_msg.m_isResponse = true;
+            }
+            break;
+
+        case Code:
+            m_msg.m_errorCode = static_cast<int>(i);
+            break;
+
+        case Variant:
+            m_msg.m_job.variantId = static_cast<int>(i);
+            break;
+
+        case Height:
+            if (i >= 0) {
+                m_msg.m_job.height = static_cast<uint64_t>(i);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+
+    bool Uint64(uint64_t u)
+    {
+        if (m_key == Height) {
+            m_msg.m_job.height = u;
+            return true;
+        }
+
+        // Ids above INT64_MAX are not responses, the same as rapidjson::Value::IsInt64()
+        return u <= static_cast<uint64_t>(INT64_MAX) ? Int64(static_cast<int64_t>(u)) : true;
+    }
+
+
+    bool String(const char *str, rapidjson::SizeType, bool)
+    {
+        switch (m_key) {
+        case Method:
+            m_msg.m_method = str;
+            break;
+
+        case Message:
+            m_msg.m_errorMessage = str;
+            break;
+
+        case LoginId:
+            m_msg.m_loginId = str;
+            break;
+
+        case Extensions:
+            if (m_msg.m_extensionsCount < kMaxExtensions) {
+                m_msg.m_extensions[m_msg.m_extensionsCount++] = str;
+            }
+            break;
+
+        case JobId:
+            m_msg.m_job.id = str;
+            break;
+
+        case Blob:
+            m_msg.m_job.blob = str;
+            break;
+
+        case Target:
+            m_msg.m_job.target = str;
+            break;
+
+        case Algo:
+            m_msg.m_job.algo = str;
+            break;
+
+        case Variant:
+            m_msg.m_job.variant = str;
+            break;
+
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+
+    bool Key(const char *str, rapidjson::SizeType, bool)
+    {
+        m_key = field(m_depth > 0 ? m_scope[m_depth - 1] : Root, str);
+
+        return true;
+    }
+
+
+    bool StartObject()
+    {
+        if (m_depth == kMaxDepth) {
+            return false;
+        }
+
+        const Field scope = m_depth == 0 ? Root : m_key;
+        m_scope[m_depth++] = scope;
+
+        if (scope == Error) {
+            m_msg.m_hasError     = true;
+            m_msg.m_errorMessage = "";
+        }
+        else if (scope == Result) {
+            m_msg.m_hasResult = true;
+        }
+        else if (scope == Params || scope == Job) {
+            m_msg.m_hasJob = true;
+        }
+
+        return true;
+    }
+
+
+    bool StartArray()
+    {
+        if (m_depth == kMaxDepth) {
+            return false;
+        }
+
+        const Field scope = m_depth == 0 ? Root : m_key;
+        m_scope[m_depth++] = scope;
+
+        return true;
+    }
+
+
+    // Leaving a container makes its own tag current again, so the elements of an array are matched against the array
+    bool EndObject(rapidjson::SizeType) { return end(); }
+    bool EndArray(rapidjson::SizeType)  { return end(); }
+
+private:
+    inline bool end()
+    {
+        m_key = m_scope[--m_depth];
+
+        return true;
+    }
+
+
+    static Field field(Field scope, const char *key)
+    {
+        switch (scope) {
+        case Root:
+            if (strcmp(key, "id") == 0)     { return Id; }
+            if (strcmp(key, "method") == 0) { return Method; }
+            if (strcmp(key, "error") == 0)  { return Error; }
+            if (strcmp(key, "result") == 0) { return Result; }
+            if (strcmp(key, "params") == 0) { return Params; }
+            break;
+
+        case Error:
+            if (strcmp(key, "message") == 0) { return Message; }
+            if (strcmp(key, "code") == 0)    { return Code; }
+            break;
+
+        case Result:
+            if (strcmp(key, "id") == 0)         { return LoginId; }
+            if (strcmp(key, "job") == 0)        { return Job; }
+            if (strcmp(key, "extensions") == 0) { return Extensions; }
+            break;
+
+        case Params:
+        case Job:
+            if (strcmp(key, "job_id") == 0)  { return JobId; }
+            if (strcmp(key, "blob") == 0)    { return Blob; }
+            if (strcmp(key, "target") == 0)  { return Target; }
+            if (strcmp(key, "algo") == 0)    { return Algo; }
+            if (strcmp(key, "variant") == 0) { return Variant; }
+            if (strcmp(key, "height") == 0)  { return Height; }
+            break;
+
+        default:
+            break;
+        }
+
+        return Other;
+    }
+
+
+    Field m_scope[kMaxDepth];
+    size_t m_depth;
+    Field m_key;
+    StratumMessage &m_msg;
+};
+
+
+} /* namespace xmrig */
+
+
+xmrig::StratumMessage::StratumMessage() :
+    m_parseError(0)
+{
+    reset();
+}
+
+
+// Parses in place, the line must be null terminated and is modified
+bool xmrig::StratumMessage::parse(char *line)
+{
+    using namespace rapidjson;
+
+    reset();
+
+    Handler handler(*this);
+    Reader reader;
+    InsituStringStream stream(line);
+
+    const ParseResult result = reader.Parse<kParseInsituFlag>(stream, handler);
+    m_parseError             = result.Code();
+
+    return !result.IsError();
+}
+
+
+const char *xmrig::StratumMessage::error() const
+{
+    return rapidjson::GetParseError_En(static_cast<rapidjson::ParseErrorCode>(m_parseError));
+}
+
+
+void xmrig::StratumMessage::reset()
+{
+    m_hasError        = false;
+    m_hasJob          = false;
+    m_hasResult       = false;
+    m_isResponse      = false;
+    m_errorMessage    = nullptr;
+    m_loginId         = nullptr;
+    m_method          = nullptr;
+    m_errorCode       = 0;
+    m_id              = 0;
+    m_extensionsCount = 0;
+    m_job             = JobParams();
+    m_job.variantId   = -1;
+}
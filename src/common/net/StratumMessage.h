@@ -0,0 +1,98 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_STRATUMMESSAGE_H
+#define XMRIG_STRATUMMESSAGE_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace xmrig {
+
+
+/* One stratum line parsed in place by a SAX handler that keeps only the members the miner uses,
+ * strings point into the line and are valid until the receive buffer is reused */
+class StratumMessage
+{
+public:
+    enum {
+        kMaxExtensions = 8
+    };
+
+    struct JobParams
+    {
+        const char *algo;
+        const char *blob;
+        const char *id;
+        const char *target;
+        const char *variant;
+        int variantId;
+        uint64_t height;
+    };
+
+    StratumMessage();
+
+    bool parse(char *line);
+    const char *error() const;
+
+    inline bool hasError() const                 { return m_hasError; }
+    inline bool hasJob() const                   { return m_hasJob; }
+    inline bool hasResult() const                { return m_hasResult; }
+    inline bool isResponse() const               { return m_isResponse; }
+    inline const char *errorMessage() const      { return m_errorMessage; }
+    inline const char *extension(size_t i) const { return m_extensions[i]; }
+    inline const char *loginId() const           { return m_loginId; }
+    inline const char *method() const            { return m_method; }
+    inline const JobParams &job() const          { return m_job; }
+    inline int errorCode() const                 { return m_errorCode; }
+    inline int64_t id() const                    { return m_id; }
+    inline size_t extensions() const             { return m_extensionsCount; }
+
+private:
+    class Handler;
+
+    void reset();
+
+    bool m_hasError;
+    bool m_hasJob;
+    bool m_hasResult;
+    bool m_isResponse;
+    const char *m_errorMessage;
+    const char *m_extensions[kMaxExtensions];
+    const char *m_loginId;
+    const char *m_method;
+    int m_errorCode;
+    int m_parseError;
+    int64_t m_id;
+    JobParams m_job;
+    size_t m_extensionsCount;
+};
+
+
+} /* namespace xmrig */
+
+
+#endif /* XMRIG_STRATUMMESSAGE_H */
@@ -29,9 +29,10 @@
 #include "common/net/SubmitResult.h"
 
 
-xmrig::SubmitResult::SubmitResult(int64_t seq, uint32_t diff, uint64_t actualDiff, int64_t reqId) :
+xmrig::SubmitResult::SubmitResult(int64_t seq, uint32_t diff, uint64_t actualDiff, int64_t reqId, int threadId) :
     reqId(reqId),
     seq(seq),
+    threadId(threadId),
     diff(diff),
     actualDiff(actualDiff),
     elapsed(0)
@@ -0,0 +1,125 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "common/net/SubmitTable.h"
+
+
+xmrig::SubmitTable::SubmitTable() :
+    m_size(0),
+    m_slots(kInitialCapacity)
+{
+}
+
+
+// Backward shift deletion, entries after the removed one move up if the gap is between them and their home slot
+bool xmrig::SubmitTable::take(int64_t seq, SubmitResult &result)
+{
+    size_t i = home(seq);
+    while (m_slots[i].used && m_slots[i].result.seq != seq) {
+        i = next(i);
+    }
+
+    if (!m_slots[i].used) {
+        return false;
+    }
+
+    result = m_slots[i].result;
+    m_slots[i].used = false;
+    m_size--;
+
+    size_t j = i;
+    for (;;) {
+        j = next(j);
+        if (!m_slots[j].used) {
+            return true;
+        }
+
+        const size_t h = home(m_slots[j].result.seq);
+        const bool keep = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+        if (keep) {
+            continue;
+        }
+
+        m_slots[i]      = m_slots[j];
+        m_slots[j].used = false;
+        i = j;
+    }
+}
+
+
+// Keeps the slots a backlog has grown to, a reconnect to the same slow pool would need them again
+void xmrig::SubmitTable::clear()
+{
+    for (Slot &slot : m_slots) {
+        slot.used = false;
+    }
+
+    m_size = 0;
+}
+
+
+// Sequences grow by one per request, so outstanding submits land in consecutive slots and probing is rare,
+// a sequence that is already there is replaced, the same way std::map::operator[] did. At most half of the
+// slots are used, so every probe ends at a free slot
+void xmrig::SubmitTable::insert(const SubmitResult &result)
+{
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    size_t i = home(result.seq);
+    while (m_slots[i].used) {
+        if (m_slots[i].result.seq == result.seq) {
+            m_slots[i].result = result;
+            return;
+        }
+
+        i = next(i);
+    }
+
+    m_slots[i].used   = true;
+    m_slots[i].result = result;
+    m_size++;
+}
+
+
+void xmrig::SubmitTable::grow()
+{
+    std::vector<Slot> slots(m_slots.size() * 2);
+    m_slots.swap(slots);
+
+    for (const Slot &slot : slots) {
+        if (!slot.used) {
+            continue;
+        }
+
+        size_t i = home(slot.result.seq);
+        while (m_slots[i].used) {
+            i = next(i);
+        }
+
+        m_slots[i] = slot;
+    }
+}
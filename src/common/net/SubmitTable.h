@@ -0,0 +1,80 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_SUBMITTABLE_H
+#define XMRIG_SUBMITTABLE_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+#include "common/net/SubmitResult.h"
+
+
+namespace xmrig {
+
+
+/* Submits waiting for a pool response, keyed by sequence, open addressing with linear probing in a power of two array
+ * that doubles whenever it becomes more than half full, so a backlog to a slow pool never loses a result */
+class SubmitTable
+{
+public:
+    enum {
+        kInitialCapacity = 256
+    };
+
+    SubmitTable();
+
+    bool take(int64_t seq, SubmitResult &result);
+    void clear();
+    void insert(const SubmitResult &result);
+
+    inline size_t capacity() const { return m_slots.size(); }
+    inline size_t size() const     { return m_size; }
+
+private:
+    struct Slot
+    {
+        inline Slot() : used(false) {}
+
+        bool used;
+        SubmitResult result;
+    };
+
+    inline size_t home(int64_t seq) const   { return static_cast<size_t>(seq) & (m_slots.size() - 1); }
+    inline size_t next(size_t i) const      { return (i + 1) & (m_slots.size() - 1); }
+
+    void grow();
+
+    size_t m_size;
+    std::vector<Slot> m_slots;
+};
+
+
+} /* namespace xmrig */
+
+
+#endif /* XMRIG_SUBMITTABLE_H */
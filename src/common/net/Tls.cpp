@@ -39,7 +39,6 @@
 
 xmrig::Client::Tls::Tls(Client *client) :
     m_ready(false),
-    m_buf(),
     m_fingerprint(),
     m_client(client),
     m_ssl(nullptr)
@@ -132,9 +131,23 @@ void xmrig::Client::Tls::read(const char *data, size_t size)
       return;
     }
 
-    int bytes_read = 0;
-    while ((bytes_read = SSL_read(m_ssl, m_buf, sizeof(m_buf))) > 0) {
-        m_client->parse(m_buf, bytes_read);
+    // Records are decrypted straight into the client's line buffer, so a line split across records is still parsed whole
+    while (true) {
+        size_t size = 0;
+        char *buf   = m_client->m_recv.reserve(size);
+
+        if (size == 0) {
+            m_client->close();
+            return;
+        }
+
+        const int bytes_read = SSL_read(m_ssl, buf, static_cast<int>(size));
+        if (bytes_read <= 0) {
+            return;
+        }
+
+        m_client->m_recv.commit(static_cast<size_t>(bytes_read));
+        m_client->read();
     }
 }
 
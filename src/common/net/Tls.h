@@ -55,7 +55,6 @@ private:
     BIO *m_readBio;
     BIO *m_writeBio;
     bool m_ready;
-    char m_buf[1024 * 2];
     char m_fingerprint[32 * 2 + 8];
     Client *m_client;
     SSL *m_ssl;
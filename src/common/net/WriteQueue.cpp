@@ -0,0 +1,124 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "common/net/WriteQueue.h"
+
+
+xmrig::WriteQueue::WriteQueue() :
+    m_size(0),
+    m_writingSize(0)
+{
+    m_pool.reserve(kMaxBufs);
+    m_writing.reserve(kMaxBufs);
+}
+
+
+xmrig::WriteQueue::~WriteQueue()
+{
+    clear();
+
+    for (Buffer *buffer : m_pool) {
+        delete buffer;
+    }
+}
+
+
+// Moves the oldest pending buffers in flight and describes them for uv_write, the caller must not start
+// another write before finish()
+size_t xmrig::WriteQueue::start(uv_buf_t *bufs)
+{
+    while (!m_pending.empty() && m_writing.size() < kMaxBufs) {
+        Buffer *buffer = m_pending.front();
+        m_pending.pop_front();
+
+        bufs[m_writing.size()] = uv_buf_init(buffer->data(), static_cast<unsigned int>(buffer->size()));
+        m_writing.push_back(buffer);
+        m_writingSize += buffer->size();
+    }
+
+    return m_writing.size();
+}
+
+
+void xmrig::WriteQueue::clear()
+{
+    finish();
+
+    for (Buffer *buffer : m_pending) {
+        release(buffer);
+    }
+
+    m_pending.clear();
+    m_size = 0;
+}
+
+
+void xmrig::WriteQueue::finish()
+{
+    for (Buffer *buffer : m_writing) {
+        release(buffer);
+    }
+
+    m_writing.clear();
+    m_size       -= m_writingSize;
+    m_writingSize = 0;
+}
+
+
+// Back-to-back lines share the tail buffer while it has room, so a batch of submits usually goes out as one iovec
+void xmrig::WriteQueue::push(const char *data, size_t size)
+{
+    Buffer *tail = m_pending.empty() ? nullptr : m_pending.back();
+    if (!tail || (tail->size() + size) > tail->capacity()) {
+        tail = get();
+        m_pending.push_back(tail);
+    }
+
+    tail->insert(tail->end(), data, data + size);
+    m_size += size;
+}
+
+
+xmrig::WriteQueue::Buffer *xmrig::WriteQueue::get()
+{
+    if (m_pool.empty()) {
+        Buffer *buffer = new Buffer();
+        buffer->reserve(kBufferSize);
+
+        return buffer;
+    }
+
+    Buffer *buffer = m_pool.back();
+    m_pool.pop_back();
+
+    return buffer;
+}
+
+
+void xmrig::WriteQueue::release(Buffer *buffer)
+{
+    buffer->clear();
+    m_pool.push_back(buffer);
+}
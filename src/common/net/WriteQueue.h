@@ -0,0 +1,77 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_WRITEQUEUE_H
+#define XMRIG_WRITEQUEUE_H
+
+
+#include <deque>
+#include <stddef.h>
+#include <uv.h>
+#include <vector>
+
+
+namespace xmrig {
+
+
+/* Outbound bytes for one socket: pending lines are packed into pooled buffers, a flush hands
+ * up to kMaxBufs of them to a single uv_write and they return to the pool when it completes */
+class WriteQueue
+{
+public:
+    enum {
+        kBufferSize = 4096,
+        kMaxBufs    = 16
+    };
+
+    WriteQueue();
+    ~WriteQueue();
+
+    size_t start(uv_buf_t *bufs);
+    void clear();
+    void finish();
+    void push(const char *data, size_t size);
+
+    inline bool isPending() const { return !m_pending.empty(); }
+    inline bool isWriting() const { return !m_writing.empty(); }
+    inline size_t size() const    { return m_size; }
+
+private:
+    typedef std::vector<char> Buffer;
+
+    Buffer *get();
+    void release(Buffer *buffer);
+
+    size_t m_size;
+    size_t m_writingSize;
+    std::deque<Buffer *> m_pending;
+    std::vector<Buffer *> m_pool;
+    std::vector<Buffer *> m_writing;
+};
+
+
+} /* namespace xmrig */
+
+
+#endif /* XMRIG_WRITEQUEUE_H */
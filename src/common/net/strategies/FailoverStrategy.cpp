@@ -23,19 +23,28 @@
  */
 
 
+#include <algorithm>
+
+
 #include "common/interfaces/IStrategyListener.h"
+#include "common/log/Log.h"
 #include "common/net/Client.h"
 #include "common/net/strategies/FailoverStrategy.h"
 #include "common/Platform.h"
 
 
-xmrig::FailoverStrategy::FailoverStrategy(const std::vector<Pool> &pools, int retryPause, int retries, IStrategyListener *listener, bool quiet) :
+xmrig::FailoverStrategy::FailoverStrategy(const std::vector<Pool> &pools, int retryPause, int retries, IStrategyListener *listener, bool quiet, int standby) :
     m_quiet(quiet),
     m_retries(retries),
     m_retryPause(retryPause),
+    m_standby(standby),
     m_active(-1),
     m_index(0),
-    m_listener(listener)
+    m_takeOverFrom(-1),
+    m_listener(listener),
+    m_idleAvoided(0),
+    m_takeOverEstimate(0),
+    m_takeOverTime(0)
 {
     for (const Pool &pool : pools) {
         add(pool);
@@ -43,13 +52,18 @@ xmrig::FailoverStrategy::FailoverStrategy(const std::vector<Pool> &pools, int re
 }
 
 
-xmrig::FailoverStrategy::FailoverStrategy(int retryPause, int retries, IStrategyListener *listener, bool quiet) :
+xmrig::FailoverStrategy::FailoverStrategy(int retryPause, int retries, IStrategyListener *listener, bool quiet, int standby) :
     m_quiet(quiet),
     m_retries(retries),
     m_retryPause(retryPause),
+    m_standby(standby),
     m_active(-1),
     m_index(0),
-    m_listener(listener)
+    m_takeOverFrom(-1),
+    m_listener(listener),
+    m_idleAvoided(0),
+    m_takeOverEstimate(0),
+    m_takeOverTime(0)
 {
 }
 
@@ -62,15 +76,25 @@ xmrig::FailoverStrategy::~FailoverStrategy()
 }
 
 
+// Standby pools always heartbeat, an idle connection that nobody pings is the one found dead at failover time
 void xmrig::FailoverStrategy::add(const Pool &pool)
 {
-    Client *client = new Client(static_cast<int>(m_pools.size()), Platform::userAgent(), this);
-    client->setPool(pool);
+    const int id = static_cast<int>(m_pools.size());
+
+    Pool copy(pool);
+    if (id > 0 && id <= m_standby && copy.keepAlive() == 0) {
+        copy.setKeepAlive(true);
+    }
+
+    Client *client = new Client(id, Platform::userAgent(), this);
+    client->setPool(copy);
     client->setRetries(m_retries);
     client->setRetryPause(m_retryPause * 1000);
     client->setQuiet(m_quiet);
 
     m_pools.push_back(client);
+    m_connectTime.push_back(0);
+    m_loginTime.push_back(0);
 }
 
 
@@ -84,9 +108,14 @@ int64_t xmrig::FailoverStrategy::submit(const JobResult &result)
 }
 
 
+// With hot standby the primary and the next m_standby pools are logged in together, the rest stay cold
 void xmrig::FailoverStrategy::connect()
 {
-    m_pools[static_cast<size_t>(m_index)]->connect();
+    m_index = std::min(m_standby, static_cast<int>(m_pools.size()) - 1);
+
+    for (int i = 0; i <= m_index; ++i) {
+        connect(static_cast<size_t>(i));
+    }
 }
 
 
@@ -117,6 +146,10 @@ void xmrig::FailoverStrategy::stop()
     m_index  = 0;
     m_active = -1;
 
+    if (m_takeOverTime) {
+        finishTakeOver(std::min(uv_now(uv_default_loop()) - m_takeOverTime, m_takeOverEstimate));
+    }
+
     m_listener->onPause(this);
 }
 
@@ -126,6 +159,10 @@ void xmrig::FailoverStrategy::tick(uint64_t now)
     for (Client *client : m_pools) {
         client->tick(now);
     }
+
+    if (m_takeOverTime && (now - m_takeOverTime) >= m_takeOverEstimate) {
+        finishTakeOver(m_takeOverEstimate);
+    }
 }
 
 
@@ -137,15 +174,18 @@ void xmrig::FailoverStrategy::onClose(Client *client, int failures)
 
     if (m_active == client->id()) {
         m_active = -1;
-        m_listener->onPause(this);
+
+        if (!takeOver(client->id())) {
+            m_listener->onPause(this);
+        }
     }
 
-    if (m_index == 0 && failures < m_retries) {
+    if (isActive() || (m_index == 0 && failures < m_retries)) {
         return;
     }
 
     if (m_index == client->id() && (m_pools.size() - static_cast<size_t>(m_index)) > 1) {
-        m_pools[static_cast<size_t>(++m_index)]->connect();
+        connect(static_cast<size_t>(++m_index));
     }
 }
 
@@ -158,22 +198,36 @@ void xmrig::FailoverStrategy::onJobReceived(Client *client, const Job &job)
 }
 
 
+// A pool with higher priority than the active one takes over again as soon as it is logged in
 void xmrig::FailoverStrategy::onLoginSuccess(Client *client)
 {
+    const size_t index = static_cast<size_t>(client->id());
+    const uint64_t now = uv_now(uv_default_loop());
+
+    if (m_connectTime[index]) {
+        m_loginTime[index]   = now - m_connectTime[index];
+        m_connectTime[index] = 0;
+    }
+
+    if (client->id() == m_takeOverFrom) {
+        finishTakeOver(std::min(now - m_takeOverTime, m_takeOverEstimate));
+    }
+
     int active = m_active;
 
-    if (client->id() == 0 || !isActive()) {
+    if (!isActive() || client->id() < m_active) {
         active = client->id();
     }
 
-    for (size_t i = 1; i < m_pools.size(); ++i) {
+    for (size_t i = static_cast<size_t>(m_standby) + 1; i < m_pools.size(); ++i) {
         if (active != static_cast<int>(i)) {
             m_pools[i]->disconnect();
         }
     }
 
     if (active >= 0 && active != m_active) {
-        m_index = m_active = active;
+        m_active = active;
+        m_index  = std::max(active, std::min(m_standby, static_cast<int>(m_pools.size()) - 1));
         m_listener->onActive(this, client);
     }
 }
@@ -183,3 +237,61 @@ void xmrig::FailoverStrategy::onResultAccepted(Client *client, const SubmitResul
 {
     m_listener->onResultAccepted(this, client, result, error);
 }
+
+
+// Hands mining to the highest priority standby that is logged in and has a job, the GPUs keep running.
+// Without standby the GPUs would idle until the failed pool is back, or for the primary until its retries
+// run out and the backup has logged in, that is what gets counted as avoided
+bool xmrig::FailoverStrategy::takeOver(int failed)
+{
+    if (m_standby == 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_pools.size(); ++i) {
+        Client *client = m_pools[i];
+        if (static_cast<int>(i) == failed || !client->isReady() || !client->job().isValid()) {
+            continue;
+        }
+
+        if (m_takeOverTime) {
+            finishTakeOver(std::min(uv_now(uv_default_loop()) - m_takeOverTime, m_takeOverEstimate));
+        }
+
+        m_takeOverFrom     = failed;
+        m_takeOverTime     = uv_now(uv_default_loop());
+        m_takeOverEstimate = (failed == 0 ? static_cast<uint64_t>(m_retries) * m_retryPause * 1000 : 0) + m_loginTime[i];
+
+        LOG_WARN("[%s] hot standby %s:%d takes over, no pause for the GPUs", m_pools[static_cast<size_t>(failed)]->host(), client->host(), client->port());
+
+        m_active = static_cast<int>(i);
+        m_listener->onActive(this, client);
+        m_listener->onJob(this, client, client->job());
+
+        return true;
+    }
+
+    return false;
+}
+
+
+void xmrig::FailoverStrategy::connect(size_t index)
+{
+    m_connectTime[index] = uv_now(uv_default_loop());
+    m_pools[index]->connect();
+}
+
+
+void xmrig::FailoverStrategy::finishTakeOver(uint64_t avoided)
+{
+    m_idleAvoided     += avoided;
+    m_takeOverFrom     = -1;
+    m_takeOverTime     = 0;
+    m_takeOverEstimate = 0;
+
+    if (avoided == 0) {
+        return;
+    }
+
+    LOG_INFO("hot standby avoided %.1f s of GPU idle time, %.1f s in total", avoided / 1000.0, m_idleAvoided / 1000.0);
+}
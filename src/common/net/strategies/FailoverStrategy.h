@@ -44,8 +44,8 @@ class IStrategyListener;
 class FailoverStrategy : public IStrategy, public IClientListener
 {
 public:
-    FailoverStrategy(const std::vector<Pool> &pool, int retryPause, int retries, IStrategyListener *listener, bool quiet = false);
-    FailoverStrategy(int retryPause, int retries, IStrategyListener *listener, bool quiet = false);
+    FailoverStrategy(const std::vector<Pool> &pool, int retryPause, int retries, IStrategyListener *listener, bool quiet = false, int standby = 0);
+    FailoverStrategy(int retryPause, int retries, IStrategyListener *listener, bool quiet = false, int standby = 0);
     ~FailoverStrategy() override;
 
     void add(const Pool &pool);
@@ -69,13 +69,24 @@ protected:
 private:
     inline Client *active() const { return m_pools[static_cast<size_t>(m_active)]; }
 
+    bool takeOver(int failed);
+    void connect(size_t index);
+    void finishTakeOver(uint64_t avoided);
+
     const bool m_quiet;
     const int m_retries;
     const int m_retryPause;
+    const int m_standby;
     int m_active;
     int m_index;
+    int m_takeOverFrom;
     IStrategyListener *m_listener;
     std::vector<Client*> m_pools;
+    std::vector<uint64_t> m_connectTime;
+    std::vector<uint64_t> m_loginTime;
+    uint64_t m_idleAvoided;
+    uint64_t m_takeOverEstimate;
+    uint64_t m_takeOverTime;
 };
 
 
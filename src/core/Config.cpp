@@ -54,9 +54,14 @@ static const char *vendors[] = {
 
 xmrig::Config::Config() : xmrig::CommonConfig(),
     m_autoConf(false),
+    m_autotune(false),
     m_cache(true),
+    m_deviceDispatch(false),
+    m_pipeline(false),
+    m_profiling(false),
     m_shouldSave(false),
     m_platformIndex(0),
+    m_verifyThreads(0),
 #   if defined(__APPLE__)
     m_loader("/System/Library/Frameworks/OpenCL.framework/OpenCL"),
 #   elif defined(_WIN32)
@@ -64,6 +69,7 @@ xmrig::Config::Config() : xmrig::CommonConfig(),
 #   else
     m_loader("libOpenCL.so"),
 #   endif
+    m_sysfsRoot("/sys"),
     m_vendor(xmrig::OCL_VENDOR_AMD)
 {    
 }
@@ -153,10 +159,15 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
     doc.AddMember("log-file",        logFile() ? Value(StringRef(logFile())).Move() : Value(kNullType).Move(), allocator);
     doc.AddMember("opencl-platform", vendor() == OCL_VENDOR_MANUAL ? Value(platformIndex()).Move() : Value(StringRef(vendorName(vendor()))).Move(), allocator);
     doc.AddMember("opencl-loader",   StringRef(loader()), allocator);
+    doc.AddMember("opencl-pipeline", isOclPipeline(), allocator);
+    doc.AddMember("opencl-device-dispatch", isOclDeviceDispatch(), allocator);
+    doc.AddMember("opencl-profiling", isOclProfiling(), allocator);
+    doc.AddMember("opencl-autotune", isOclAutotune(), allocator);
     doc.AddMember("pools",           m_pools.toJSON(doc), allocator);
     doc.AddMember("print-time",      printTime(), allocator);
     doc.AddMember("retries",         m_pools.retries(), allocator);
     doc.AddMember("retry-pause",     m_pools.retryPause(), allocator);
+    doc.AddMember("pool-standby",    m_pools.standby(), allocator);
 
     Value threads(kArrayType);
     for (const IThread *thread : m_threads) {
@@ -166,6 +177,8 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
 
     doc.AddMember("user-agent", userAgent() ? Value(StringRef(userAgent())).Move() : Value(kNullType).Move(), allocator);
     doc.AddMember("syslog",     isSyslog(), allocator);
+    doc.AddMember("sysfs-root", StringRef(sysfsRoot()), allocator);
+    doc.AddMember("verify-threads", m_verifyThreads, allocator);
     doc.AddMember("watch",      m_watch, allocator);
 }
 
@@ -211,6 +224,22 @@ bool xmrig::Config::parseBoolean(int key, bool enable)
         m_cache = enable;
         break;
 
+    case OclPipelineKey: /* opencl-pipeline */
+        m_pipeline = enable;
+        break;
+
+    case OclDeviceDispatchKey: /* opencl-device-dispatch */
+        m_deviceDispatch = enable;
+        break;
+
+    case OclProfilingKey: /* opencl-profiling */
+        m_profiling = enable;
+        break;
+
+    case OclAutotuneKey: /* opencl-autotune */
+        m_autotune = enable;
+        break;
+
     default:
         break;
     }
@@ -257,6 +286,18 @@ bool xmrig::Config::parseString(int key, const char *arg)
     case OclCacheKey: /* --no-cache */
         return parseBoolean(key, false);
 
+    case OclPipelineKey: /* --opencl-pipeline */
+        return parseBoolean(key, true);
+
+    case OclDeviceDispatchKey: /* --opencl-device-dispatch */
+        return parseBoolean(key, true);
+
+    case OclProfilingKey: /* --opencl-profiling */
+        return parseBoolean(key, true);
+
+    case OclAutotuneKey: /* --opencl-autotune */
+        return parseBoolean(key, true);
+
     case OclPrintKey: /* --print-platforms */
         if (OclLib::init(loader())) {
             printPlatforms();
@@ -271,6 +312,14 @@ bool xmrig::Config::parseString(int key, const char *arg)
         m_loader = arg;
         break;
 
+    case VerifyThreadsKey: /* --verify-threads */
+    case PoolStandbyKey:   /* --pool-standby */
+        return parseUint64(key, strtol(arg, nullptr, 10));
+
+    case SysfsRootKey: /* --sysfs-root */
+        m_sysfsRoot = arg;
+        break;
+
     default:
         break;
     }
@@ -290,6 +339,16 @@ bool xmrig::Config::parseUint64(int key, uint64_t arg)
         setPlatformIndex(static_cast<int>(arg));
         break;
 
+    case VerifyThreadsKey: /* --verify-threads */
+        if (arg <= 64) {
+            m_verifyThreads = static_cast<int>(arg);
+        }
+        break;
+
+    case PoolStandbyKey: /* --pool-standby */
+        m_pools.setStandby(static_cast<int>(arg));
+        break;
+
     default:
         break;
     }
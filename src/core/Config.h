@@ -55,11 +55,18 @@ public:
 
     void getJSON(rapidjson::Document &doc) const override;
 
+    inline bool isOclAutotune() const                    { return m_autotune; }
     inline bool isOclCache() const                       { return m_cache; }
+    inline bool isOclDeviceDispatch() const              { return m_deviceDispatch; }
+    inline bool isOclPipeline() const                    { return m_pipeline; }
+    inline bool isOclProfiling() const                   { return m_profiling; }
     inline bool isShouldSave() const                     { return m_shouldSave && isAutoSave(); }
     inline const char *loader() const                    { return m_loader.data(); }
     inline const std::vector<IThread *> &threads() const { return m_threads; }
     inline int platformIndex() const                     { return m_platformIndex; }
+    inline const char *sysfsRoot() const                 { return m_sysfsRoot.data(); }
+    inline void setShouldSave(bool shouldSave)           { m_shouldSave = shouldSave; }
+    inline int verifyThreads() const                     { return m_verifyThreads; }
     inline xmrig::OclVendor vendor() const               { return m_vendor; }
 
     static Config *load(Process *process, IConfigListener *listener);
@@ -79,12 +86,18 @@ private:
     void setPlatformIndex(int index);
 
     bool m_autoConf;
+    bool m_autotune;
     bool m_cache;
+    bool m_deviceDispatch;
+    bool m_pipeline;
+    bool m_profiling;
     bool m_shouldSave;
     int m_platformIndex;
+    int m_verifyThreads;
     OclCLI m_oclCLI;
     std::vector<IThread *> m_threads;
     xmrig::String m_loader;
+    xmrig::String m_sysfsRoot;
     xmrig::OclVendor m_vendor;
 };
 
@@ -64,9 +64,12 @@ Options:\n\
       --tls-fingerprint=F      pool TLS certificate fingerprint, if set enable strict certificate pinning\n\
   -r, --retries=N              number of times to retry before switch to backup server (default: 5)\n\
   -R, --retry-pause=N          time to pause between retries (default: 5)\n\
+      --pool-standby=N         keep N backup pools logged in for instant failover (default: 0)\n\
       --max-gpu-temp=N         Maximum temperature a GPU may reach before its cooled down (default 75)\n\
       --gpu-temp-falloff=N     Amount of temperature to cool off before mining starts again (default 10)\n\
       --gpu-fan-level=N        -1 disabled||0 automatic (default)||1..100 Fan speed in percent\n\
+      --verify-threads=N       maximum number of shares verified on the CPU at once (default 0, auto)\n\
+      --sysfs-root=PATH        sysfs mount point used for GPU sensors (default /sys)\n\
       --opencl-devices=N       list of OpenCL devices to use.\n\
       --opencl-launch=IxW      list of launch config, intensity and worksize\n\
       --opencl-strided-index=N list of strided_index option values for each thread\n\
@@ -75,6 +78,10 @@ Options:\n\
       --opencl-affinity=N      list of affinity GPU threads to a CPU\n\
       --opencl-platform=N      OpenCL platform index\n\
       --opencl-loader=N        path to OpenCL-ICD-Loader (OpenCL.dll or libOpenCL.so)\n\
+      --opencl-pipeline        overlap GPU batches with result readback (double-buffered)\n\
+      --opencl-device-dispatch let branch kernels read nonce counts on the GPU, no host round trip\n\
+      --opencl-profiling       record OpenCL profiling events, per kernel latency histograms\n\
+      --opencl-autotune        tune intensity, worksize, strided index and unroll at startup, save the result\n\
       --print-platforms        print available OpenCL platforms and exit\n\
       --no-cache               disable OpenCL cache\n\
       --no-color               disable colored output\n\
@@ -117,6 +124,9 @@ static struct option const options[] = {
     { "max-gpu-temp",         1, nullptr, xmrig::IConfig::MaxTempKey        },
     { "gpu-temp-falloff",     1, nullptr, xmrig::IConfig::FalloffKey        },
     { "gpu-fan-level",        1, nullptr, xmrig::IConfig::FanlevelKey       },
+    { "verify-threads",       1, nullptr, xmrig::IConfig::VerifyThreadsKey  },
+    { "sysfs-root",           1, nullptr, xmrig::IConfig::SysfsRootKey      },
+    { "pool-standby",         1, nullptr, xmrig::IConfig::PoolStandbyKey    },
     { "dry-run",              0, nullptr, xmrig::IConfig::DryRunKey         },
     { "keepalive",            0, nullptr, xmrig::IConfig::KeepAliveKey      },
     { "log-file",             1, nullptr, xmrig::IConfig::LogFileKey        },
@@ -148,6 +158,10 @@ static struct option const options[] = {
     { "no-cache",             0, nullptr, xmrig::IConfig::OclCacheKey       },
     { "print-platforms",      0, nullptr, xmrig::IConfig::OclPrintKey       },
     { "opencl-loader",        1, nullptr, xmrig::IConfig::OclLoaderKey      },
+    { "opencl-pipeline",      0, nullptr, xmrig::IConfig::OclPipelineKey    },
+    { "opencl-device-dispatch", 0, nullptr, xmrig::IConfig::OclDeviceDispatchKey },
+    { "opencl-profiling",     0, nullptr, xmrig::IConfig::OclProfilingKey   },
+    { "opencl-autotune",      0, nullptr, xmrig::IConfig::OclAutotuneKey    },
     { nullptr,                0, nullptr, 0 }
 };
 
@@ -160,6 +174,9 @@ static struct option const config_options[] = {
     { "max-gpu-temp",      1, nullptr, xmrig::IConfig::MaxTempKey     },
     { "gpu-temp-falloff",  1, nullptr, xmrig::IConfig::FalloffKey     },
     { "gpu-fan-level",     1, nullptr, xmrig::IConfig::FanlevelKey    },
+    { "verify-threads",    1, nullptr, xmrig::IConfig::VerifyThreadsKey },
+    { "sysfs-root",        1, nullptr, xmrig::IConfig::SysfsRootKey     },
+    { "pool-standby",      1, nullptr, xmrig::IConfig::PoolStandbyKey   },
     { "dry-run",           0, nullptr, xmrig::IConfig::DryRunKey      },
     { "log-file",          1, nullptr, xmrig::IConfig::LogFileKey     },
     { "print-time",        1, nullptr, xmrig::IConfig::PrintTimeKey   },
@@ -171,6 +188,10 @@ static struct option const config_options[] = {
     { "opencl-platform",   1, nullptr, xmrig::IConfig::OclPlatformKey },
     { "cache",             0, nullptr, xmrig::IConfig::OclCacheKey    },
     { "opencl-loader",     1, nullptr, xmrig::IConfig::OclLoaderKey   },
+    { "opencl-pipeline",   0, nullptr, xmrig::IConfig::OclPipelineKey },
+    { "opencl-device-dispatch", 0, nullptr, xmrig::IConfig::OclDeviceDispatchKey },
+    { "opencl-profiling",  0, nullptr, xmrig::IConfig::OclProfilingKey },
+    { "opencl-autotune",   0, nullptr, xmrig::IConfig::OclAutotuneKey  },
     { "autosave",          0, nullptr, xmrig::IConfig::AutoSaveKey    },
     { nullptr,             0, nullptr, 0 }
 };
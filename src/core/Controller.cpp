@@ -36,6 +36,7 @@
 #include "core/Config.h"
 #include "core/Controller.h"
 #include "net/Network.h"
+#include "workers/Workers.h"
 
 
 #ifdef HAVE_SYSLOG_H
@@ -110,6 +111,8 @@ int xmrig::Controller::init()
         return 1;
     }
 
+    Workers::initThreadpool(config()->verifyThreads());
+
     Log::init();
     Platform::init(config()->userAgent());
 
@@ -57,6 +57,7 @@ Options:\n\
       --tls-fingerprint=F      pool TLS certificate fingerprint, if set enable strict certificate pinning\n\
   -r, --retries=N              number of times to retry before switch to backup server (default: 5)\n\
   -R, --retry-pause=N          time to pause between retries (default: 5)\n\
+      --pool-standby=N         keep N backup pools logged in for instant failover (default: 0)\n\
       --opencl-devices=N       list of OpenCL devices to use.\n\
       --opencl-launch=IxW      list of launch config, intensity and worksize\n\
       --opencl-strided-index=N list of strided_index option values for each thread\n\
@@ -65,6 +66,12 @@ Options:\n\
       --opencl-affinity=N      list of affinity GPU threads to a CPU\n\
       --opencl-platform=N      OpenCL platform index\n\
       --opencl-loader=N        path to OpenCL-ICD-Loader (OpenCL.dll or libOpenCL.so)\n\
+      --opencl-pipeline        overlap GPU batches with result readback (double-buffered)\n\
+      --opencl-device-dispatch let branch kernels read nonce counts on the GPU, no host round trip\n\
+      --opencl-profiling       record OpenCL profiling events, per kernel latency histograms\n\
+      --opencl-autotune        tune intensity, worksize, strided index and unroll at startup, save the result\n\
+      --verify-threads=N       maximum number of shares verified on the CPU at once (default 0, auto)\n\
+      --sysfs-root=PATH        sysfs mount point used for GPU sensors (default /sys)\n\
       --print-platforms        print available OpenCL platforms and exit\n\
       --no-cache               disable OpenCL cache\n\
       --no-color               disable colored output\n\
@@ -28,16 +28,33 @@
 #include <stdint.h>
 
 
+struct GpuSettings;
+
+
 class IWorker
 {
 public:
+    enum ReconfigureState {
+        ReconfigureIdle,
+        ReconfigurePending,
+        ReconfigureDone,
+        ReconfigureFailed
+    };
+
     virtual ~IWorker() {}
 
-    virtual bool selfTest()            = 0;
-    virtual size_t id() const          = 0;
-    virtual uint64_t hashCount() const = 0;
-    virtual uint64_t timestamp() const = 0;
-    virtual void start()               = 0;
+    virtual bool isDisabled() const                        = 0;
+    virtual bool selfTest()                                = 0;
+    virtual int reconfigureState() const                   = 0;
+    virtual size_t id() const                              = 0;
+    virtual size_t intensity() const                       = 0;
+    virtual uint64_t hashCount() const                     = 0;
+    virtual uint64_t latency() const                       = 0;
+    virtual uint64_t timestamp() const                     = 0;
+    virtual void reconfigure(const GpuSettings &settings)  = 0;
+    virtual void setIntensity(size_t intensity)            = 0;
+    virtual void setThermalLimit(size_t intensity, uint64_t gap) = 0;
+    virtual void start()                                   = 0;
 };
 
 
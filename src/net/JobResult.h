@@ -40,12 +40,13 @@ namespace xmrig {
 class JobResult
 {
 public:
-    inline JobResult() : poolId(0), diff(0), nonce(0) {}
+    inline JobResult() : poolId(0), threadId(-1), diff(0), nonce(0) {}
     inline JobResult(int poolId, const Id &jobId, const Id &clientId, uint32_t nonce, const uint8_t *result, uint32_t diff, const Algorithm &algorithm) :
         algorithm(algorithm),
         clientId(clientId),
         jobId(jobId),
         poolId(poolId),
+        threadId(-1),
         diff(diff),
         nonce(nonce)
     {
@@ -53,11 +54,12 @@ public:
     }
 
 
-    inline JobResult(const Job &job) : poolId(0), diff(0), nonce(0)
+    inline JobResult(const Job &job) : poolId(0), threadId(-1), diff(0), nonce(0)
     {
         jobId     = job.id();
         clientId  = job.clientId();
         poolId    = job.poolId();
+        threadId  = job.threadId();
         diff      = job.diff();
         nonce     = *job.nonce();
         algorithm = job.algorithm();
@@ -74,6 +76,7 @@ public:
     Id clientId;
     Id jobId;
     int poolId;
+    int threadId;
     uint32_t diff;
     uint32_t nonce;
     uint8_t result[32];
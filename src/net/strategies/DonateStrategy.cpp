@@ -25,6 +25,7 @@
 
 #include "common/crypto/keccak.h"
 #include "common/interfaces/IStrategyListener.h"
+#include "common/log/Log.h"
 #include "common/net/Client.h"
 #include "common/net/Job.h"
 #include "common/net/strategies/FailoverStrategy.h"
@@ -41,6 +42,9 @@ static inline float randomf(float min, float max) {
 
 xmrig::DonateStrategy::DonateStrategy(int level, const char *user, Algo algo, IStrategyListener *listener) :
     m_active(false),
+    m_warming(false),
+    m_window(false),
+    m_client(nullptr),
     m_donateTime(level * 60 * 1000),
     m_idleTime((100 - level) * 60 * 1000),
     m_strategy(nullptr),
@@ -113,6 +117,9 @@ void xmrig::DonateStrategy::stop()
 {
     uv_timer_stop(&m_timer);
     m_strategy->stop();
+
+    m_warming = false;
+    m_window  = false;
 }
 
 
@@ -131,25 +138,38 @@ void xmrig::DonateStrategy::tick(uint64_t now)
 
 void xmrig::DonateStrategy::onActive(IStrategy *strategy, Client *client)
 {
-    if (!isActive()) {
-        uv_timer_start(&m_timer, DonateStrategy::onTimer, m_donateTime, 0);
+    m_client = client;
+
+    if (isActive()) {
+        m_listener->onActive(this, client);
+        return;
     }
 
-    m_active = true;
-    m_listener->onActive(this, client);
+    activate();
 }
 
 
+// Jobs that arrive during the warm up are kept, so the window can start on the spot
 void xmrig::DonateStrategy::onJob(IStrategy *strategy, Client *client, const Job &job)
 {
+    m_client = client;
+    m_job    = job;
+
     if (isActive()) {
         m_listener->onJob(this, client, job);
+        return;
     }
+
+    activate();
 }
 
 
 void xmrig::DonateStrategy::onPause(IStrategy *strategy)
 {
+    if (!isActive()) {
+        m_client = nullptr;
+        m_job.reset();
+    }
 }
 
 
@@ -159,9 +179,28 @@ void xmrig::DonateStrategy::onResultAccepted(IStrategy *strategy, Client *client
 }
 
 
+// Starts the window once it is due and the warmed up client has a job, the user pool keeps the GPUs until then
+void xmrig::DonateStrategy::activate()
+{
+    if (!m_window || !m_client || !m_job.isValid()) {
+        return;
+    }
+
+    m_window  = false;
+    m_warming = false;
+    m_active  = true;
+
+    uv_timer_start(&m_timer, DonateStrategy::onTimer, m_donateTime, 0);
+
+    m_listener->onActive(this, m_client);
+    m_listener->onJob(this, m_client, m_job);
+}
+
+
+// The connection is opened kWarmupTime ahead of the window, DNS, TLS and login are not on the switch path
 void xmrig::DonateStrategy::idle(uint64_t timeout)
 {
-    uv_timer_start(&m_timer, DonateStrategy::onTimer, timeout, 0);
+    uv_timer_start(&m_timer, DonateStrategy::onTimer, timeout > kWarmupTime ? timeout - kWarmupTime : 0, 0);
 }
 
 
@@ -174,6 +213,8 @@ void xmrig::DonateStrategy::suspend()
 #   endif
 
     m_active = false;
+    m_client = nullptr;
+    m_job.reset();
     m_listener->onPause(this);
 
     idle(m_idleTime);
@@ -184,9 +225,23 @@ void xmrig::DonateStrategy::onTimer(uv_timer_t *handle)
 {
     auto strategy = static_cast<DonateStrategy*>(handle->data);
 
-    if (!strategy->isActive()) {
-        return strategy->connect();
+    if (strategy->isActive()) {
+        return strategy->suspend();
+    }
+
+    if (!strategy->m_warming) {
+        strategy->m_warming = true;
+        strategy->connect();
+
+        uv_timer_start(&strategy->m_timer, DonateStrategy::onTimer, kWarmupTime, 0);
+        return;
+    }
+
+    strategy->m_window = true;
+
+    if (!strategy->m_job.isValid()) {
+        LOG_WARN("dev donate pool is not ready yet, the window starts with its first job");
     }
 
-    strategy->suspend();
+    strategy->activate();
 }
@@ -34,6 +34,7 @@
 #include "common/interfaces/IClientListener.h"
 #include "common/interfaces/IStrategy.h"
 #include "common/interfaces/IStrategyListener.h"
+#include "common/net/Job.h"
 
 
 namespace xmrig {
@@ -46,6 +47,8 @@ class IStrategyListener;
 class DonateStrategy : public IStrategy, public IStrategyListener
 {
 public:
+    constexpr static uint64_t kWarmupTime = 30 * 1000;
+
     DonateStrategy(int level, const char *user, Algo algo, IStrategyListener *listener);
     ~DonateStrategy() override;
 
@@ -66,16 +69,21 @@ protected:
     void onResultAccepted(IStrategy *strategy, Client *client, const SubmitResult &result, const char *error) override;
 
 private:
+    void activate();
     void idle(uint64_t timeout);
     void suspend();
 
     static void onTimer(uv_timer_t *handle);
 
     bool m_active;
+    bool m_warming;
+    bool m_window;
+    Client *m_client;
     const uint64_t m_donateTime;
     const uint64_t m_idleTime;
     IStrategy *m_strategy;
     IStrategyListener *m_listener;
+    Job m_job;
     std::vector<Pool> m_pools;
     uint64_t m_now;
     uint64_t m_stop;
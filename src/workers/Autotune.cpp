@@ -0,0 +1,379 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+
+
+#include "common/log/Log.h"
+#include "common/utils/timestamp.h"
+#include "core/Config.h"
+#include "core/Controller.h"
+#include "crypto/CryptoNight_constants.h"
+#include "interfaces/IWorker.h"
+#include "workers/Autotune.h"
+#include "workers/Handle.h"
+#include "workers/Hashrate.h"
+
+
+static const int64_t kWarmup  = 5000;
+static const int64_t kMeasure = 11000;
+static const double kMinGain  = 1.01;
+
+
+static const double kIntensityFactors[] = { 0.75, 0.875, 1.125, 1.25 };
+static const size_t kWorksizes[]        = { 8, 16, 32, 64 };
+static const int kStridedIndexes[]      = { 0, 1, 2 };
+static const int kMemChunks[]           = { 1, 2, 3 };
+static const int kUnrollFactors[]       = { 1, 2, 4, 8 };
+
+
+static const char *paramName(int param)
+{
+    static const char *names[] = { "baseline", "intensity", "worksize", "strided_index", "mem_chunk", "unroll", "final" };
+
+    return names[param];
+}
+
+
+Autotune::Autotune(xmrig::Controller *controller, Hashrate *hashrate, const std::vector<Handle *> &workers) :
+    m_hashrate(hashrate),
+    m_tested(0),
+    m_controller(controller)
+{
+    const int64_t now = xmrig::steadyTimestamp();
+
+    for (Handle *handle : workers) {
+        if (!handle->worker()) {
+            continue;
+        }
+
+        auto it = std::find_if(m_lanes.begin(), m_lanes.end(), [handle](const Lane *lane) { return lane->device == handle->ctx()->deviceIdx; });
+        if (it != m_lanes.end()) {
+            (*it)->handles.push_back(handle);
+            continue;
+        }
+
+        Lane *lane     = new Lane();
+        lane->device   = handle->ctx()->deviceIdx;
+        lane->thread   = 0;
+        lane->finished = false;
+        lane->handles.push_back(handle);
+
+        m_lanes.push_back(lane);
+    }
+
+    for (Lane *lane : m_lanes) {
+        begin(*lane, now);
+    }
+
+    LOG_INFO(controller->config()->isColors() ? "autotune started for " WHITE_BOLD("%zu") " GPU(s), each candidate runs for " WHITE_BOLD("%.0fs")
+                                              : "autotune started for %zu GPU(s), each candidate runs for %.0fs",
+             m_lanes.size(), (kWarmup + kMeasure) / 1000.0);
+}
+
+
+Autotune::~Autotune()
+{
+    for (Lane *lane : m_lanes) {
+        delete lane;
+    }
+}
+
+
+// Called from the main loop timer, returns true once every GPU is done and the result is saved
+bool Autotune::tick(bool paused)
+{
+    const int64_t now = xmrig::steadyTimestamp();
+    bool finished     = true;
+
+    for (Lane *lane : m_lanes) {
+        step(*lane, paused, now);
+
+        finished &= lane->finished;
+    }
+
+    if (!finished) {
+        return false;
+    }
+
+    LOG_INFO(m_controller->config()->isColors() ? "autotune finished, " WHITE_BOLD("%zu") " candidates tested" : "autotune finished, %zu candidates tested", m_tested);
+
+    m_controller->config()->setShouldSave(true);
+    m_controller->save();
+
+    return true;
+}
+
+
+// All threads of the GPU share its memory and compute units, the score is the GPU total rather than the tuned thread alone
+double Autotune::score(const Lane &lane) const
+{
+    double score = 0.0;
+
+    for (const Handle *handle : lane.handles) {
+        const double hashrate = m_hashrate->calc(handle->threadId(), Hashrate::ShortInterval);
+        if (std::isnormal(hashrate)) {
+            score += hashrate;
+        }
+    }
+
+    return score;
+}
+
+
+// Same budget as the automatic configuration, minus what the other threads of the GPU already allocated
+size_t Autotune::maxIntensity(const Lane &lane) const
+{
+    constexpr const size_t byteToMiB = 1024u * 1024u;
+
+    const GpuContext *ctx  = lane.handles[lane.thread]->ctx();
+    const size_t perThread = xmrig::cn_select_memory(m_controller->config()->algorithm().algo()) + 224u;
+
+    if (ctx->freeMem <= 128u * byteToMiB || ctx->globalMem <= 128u * byteToMiB) {
+        return 0;
+    }
+
+    size_t others = 0;
+    for (size_t i = 0; i < lane.handles.size(); ++i) {
+        if (i != lane.thread) {
+            others += lane.handles[i]->ctx()->configuredIntensity();
+        }
+    }
+
+    const size_t total = (ctx->globalMem - 128u * byteToMiB) / perThread;
+    if (total <= others) {
+        return 0;
+    }
+
+    return std::min((ctx->freeMem - 128u * byteToMiB) / perThread, total - others);
+}
+
+
+// Coordinate descent, once a parameter is done the next one starts from the best settings found so far
+void Autotune::advance(Lane &lane, int64_t now)
+{
+    if (++lane.candidate < lane.candidates.size()) {
+        return request(lane, now);
+    }
+
+    lane.candidate = 0;
+    lane.candidates.clear();
+
+    while (lane.candidates.empty()) {
+        if (++lane.param == Final) {
+            lane.candidates.push_back(lane.best);
+            break;
+        }
+
+        candidates(lane);
+    }
+
+    request(lane, now);
+}
+
+
+// The first candidate of every thread is its current settings, measured without reconfiguring
+void Autotune::begin(Lane &lane, int64_t now)
+{
+    const GpuContext *ctx = lane.handles[lane.thread]->ctx();
+
+    lane.param     = Baseline;
+    lane.candidate = 0;
+    lane.best      = ctx->settings();
+    lane.baseline  = 0.0;
+    lane.bestScore = 0.0;
+    lane.started   = now;
+    lane.waiting   = false;
+
+    lane.candidates.assign(1, lane.best);
+}
+
+
+void Autotune::candidates(Lane &lane) const
+{
+    const GpuSettings &best = lane.best;
+
+    auto add = [&lane](const GpuSettings &settings) {
+        if (settings.intensity > 0 && settings.intensity % settings.worksize == 0) {
+            lane.candidates.push_back(settings);
+        }
+    };
+
+    switch (lane.param) {
+    case Intensity: {
+        const size_t max = maxIntensity(lane);
+
+        for (double factor : kIntensityFactors) {
+            GpuSettings settings = best;
+            settings.intensity   = static_cast<size_t>(best.intensity * factor) / best.worksize * best.worksize;
+
+            if (settings.intensity != best.intensity && settings.intensity <= max &&
+                (lane.candidates.empty() || lane.candidates.back().intensity != settings.intensity)) {
+                add(settings);
+            }
+        }
+        break;
+    }
+
+    case Worksize:
+        for (size_t worksize : kWorksizes) {
+            GpuSettings settings = best;
+            settings.worksize    = worksize;
+            settings.intensity   = best.intensity / worksize * worksize;
+
+            if (worksize != best.worksize) {
+                add(settings);
+            }
+        }
+        break;
+
+    case StridedIndex:
+        for (int stridedIndex : kStridedIndexes) {
+            GpuSettings settings  = best;
+            settings.stridedIndex = stridedIndex;
+
+            if (stridedIndex != best.stridedIndex && !(stridedIndex == 1 && m_controller->config()->isCNv2())) {
+                add(settings);
+            }
+        }
+        break;
+
+    case MemChunk:
+        if (best.stridedIndex != 2) {
+            break;
+        }
+
+        for (int memChunk : kMemChunks) {
+            GpuSettings settings = best;
+            settings.memChunk    = memChunk;
+
+            if (memChunk != best.memChunk) {
+                add(settings);
+            }
+        }
+        break;
+
+    case Unroll:
+        for (int unrollFactor : kUnrollFactors) {
+            GpuSettings settings  = best;
+            settings.unrollFactor = unrollFactor;
+
+            if (unrollFactor != best.unrollFactor) {
+                add(settings);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void Autotune::record(Lane &lane, double score, int64_t now)
+{
+    const GpuSettings &settings = lane.candidates[lane.candidate];
+    const bool isColors         = m_controller->config()->isColors();
+
+    m_tested++;
+
+    LOG_INFO(isColors ? "autotune GPU " WHITE_BOLD("#%zu") " thread " WHITE_BOLD("#%zu") " %-13s i:" WHITE_BOLD("%zu") " w:" WHITE_BOLD("%zu") " si:" WHITE_BOLD("%d/%d") " u:" WHITE_BOLD("%d") " " CYAN_BOLD("%.1f H/s")
+                      : "autotune GPU #%zu thread #%zu %-13s i:%zu w:%zu si:%d/%d u:%d %.1f H/s",
+             lane.device, lane.handles[lane.thread]->threadId(), paramName(lane.param),
+             settings.intensity, settings.worksize, settings.stridedIndex, settings.memChunk, settings.unrollFactor, score);
+
+    if (lane.param == Baseline) {
+        lane.baseline  = score;
+        lane.bestScore = score;
+    }
+    else if (score > lane.bestScore * kMinGain) {
+        lane.best      = settings;
+        lane.bestScore = score;
+    }
+
+    advance(lane, now);
+}
+
+
+void Autotune::request(Lane &lane, int64_t now)
+{
+    lane.handles[lane.thread]->worker()->reconfigure(lane.candidates[lane.candidate]);
+
+    lane.started = now;
+    lane.waiting = true;
+}
+
+
+void Autotune::step(Lane &lane, bool paused, int64_t now)
+{
+    if (lane.finished) {
+        return;
+    }
+
+    if (lane.waiting) {
+        const int state = lane.handles[lane.thread]->worker()->reconfigureState();
+        if (state == IWorker::ReconfigurePending) {
+            return;
+        }
+
+        lane.waiting = false;
+        lane.started = now;
+
+        if (lane.param == Final) {
+            const GpuSettings &best = lane.best;
+
+            LOG_INFO(m_controller->config()->isColors() ? "autotune GPU " WHITE_BOLD("#%zu") " thread " WHITE_BOLD("#%zu") " done, i:" WHITE_BOLD("%zu") " w:" WHITE_BOLD("%zu") " si:" WHITE_BOLD("%d/%d") " u:" WHITE_BOLD("%d") ", " CYAN_BOLD("%.1f") " -> " CYAN_BOLD("%.1f H/s")
+                                                        : "autotune GPU #%zu thread #%zu done, i:%zu w:%zu si:%d/%d u:%d, %.1f -> %.1f H/s",
+                     lane.device, lane.handles[lane.thread]->threadId(), best.intensity, best.worksize, best.stridedIndex, best.memChunk, best.unrollFactor,
+                     lane.baseline, lane.bestScore);
+
+            if (++lane.thread == lane.handles.size()) {
+                lane.finished = true;
+                return;
+            }
+
+            return begin(lane, now);
+        }
+
+        if (state == IWorker::ReconfigureFailed) {
+            record(lane, 0.0, now);
+        }
+
+        return;
+    }
+
+    // Without a job the GPU idles, measure again from the start once mining resumes
+    if (paused) {
+        lane.started = now;
+        return;
+    }
+
+    if (now - lane.started < kWarmup + kMeasure) {
+        return;
+    }
+
+    record(lane, score(lane), now);
+}
@@ -0,0 +1,97 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XMRIG_AUTOTUNE_H
+#define XMRIG_AUTOTUNE_H
+
+
+#include <stdint.h>
+#include <vector>
+
+
+#include "amd/GpuContext.h"
+
+
+class Handle;
+class Hashrate;
+
+
+namespace xmrig {
+    class Controller;
+}
+
+
+/* Closed loop tuning of launch settings, every GPU is tuned in parallel, threads of the same GPU one after another */
+class Autotune
+{
+public:
+    Autotune(xmrig::Controller *controller, Hashrate *hashrate, const std::vector<Handle *> &workers);
+    ~Autotune();
+
+    bool tick(bool paused);
+
+private:
+    enum Param {
+        Baseline,
+        Intensity,
+        Worksize,
+        StridedIndex,
+        MemChunk,
+        Unroll,
+        Final
+    };
+
+    struct Lane
+    {
+        size_t device;
+        std::vector<Handle *> handles;
+        size_t thread;
+        int param;
+        std::vector<GpuSettings> candidates;
+        size_t candidate;
+        GpuSettings best;
+        double baseline;
+        double bestScore;
+        int64_t started;
+        bool waiting;
+        bool finished;
+    };
+
+    double score(const Lane &lane) const;
+    size_t maxIntensity(const Lane &lane) const;
+    void advance(Lane &lane, int64_t now);
+    void begin(Lane &lane, int64_t now);
+    void candidates(Lane &lane) const;
+    void record(Lane &lane, double score, int64_t now);
+    void request(Lane &lane, int64_t now);
+    void step(Lane &lane, bool paused, int64_t now);
+
+    Hashrate *m_hashrate;
+    size_t m_tested;
+    std::vector<Lane *> m_lanes;
+    xmrig::Controller *m_controller;
+};
+
+
+#endif /* XMRIG_AUTOTUNE_H */
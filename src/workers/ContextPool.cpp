@@ -0,0 +1,127 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "workers/ContextPool.h"
+
+
+ContextPool::ContextPool() :
+    m_total(0),
+    m_algo(xmrig::INVALID_ALGO)
+{
+}
+
+
+ContextPool::~ContextPool()
+{
+    release();
+}
+
+
+// Returns an idle scratchpad for the algorithm or allocates a new one
+ContextPool::Entry *ContextPool::checkout(xmrig::Algo algo)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        reset(algo);
+
+        if (!m_free.empty()) {
+            Entry *entry = m_free.back();
+            m_free.pop_back();
+
+            return entry;
+        }
+
+        m_total++;
+    }
+
+    Entry *entry = new Entry();
+    entry->algo  = algo;
+    entry->info  = Mem::create(&entry->ctx, algo, 1);
+
+    return entry;
+}
+
+
+size_t ContextPool::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_total;
+}
+
+
+void ContextPool::checkin(Entry *entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (entry->algo == m_algo) {
+            m_free.push_back(entry);
+            return;
+        }
+
+        m_total--;
+    }
+
+    destroy(entry);
+}
+
+
+void ContextPool::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    reset(xmrig::INVALID_ALGO);
+}
+
+
+void ContextPool::setAlgo(xmrig::Algo algo)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    reset(algo);
+}
+
+
+// Scratchpads still checked out are freed on checkin, their algorithm no longer matches
+void ContextPool::reset(xmrig::Algo algo)
+{
+    if (algo == m_algo) {
+        return;
+    }
+
+    for (Entry *entry : m_free) {
+        destroy(entry);
+    }
+
+    m_total -= m_free.size();
+    m_free.clear();
+    m_algo = algo;
+}
+
+
+void ContextPool::destroy(Entry *entry)
+{
+    Mem::release(&entry->ctx, 1, entry->info);
+    delete entry;
+}
@@ -0,0 +1,72 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XMRIG_CONTEXTPOOL_H
+#define XMRIG_CONTEXTPOOL_H
+
+
+#include <mutex>
+#include <vector>
+
+
+#include "common/xmrig.h"
+#include "Mem.h"
+
+
+struct cryptonight_ctx;
+
+
+/* Scratchpads for CPU share verification, allocated on first use and kept until the algorithm changes */
+class ContextPool
+{
+public:
+    struct Entry
+    {
+        cryptonight_ctx *ctx;
+        MemInfo info;
+        xmrig::Algo algo;
+    };
+
+    ContextPool();
+    ~ContextPool();
+
+    Entry *checkout(xmrig::Algo algo);
+    size_t size() const;
+    void checkin(Entry *entry);
+    void release();
+    void setAlgo(xmrig::Algo algo);
+
+private:
+    static void destroy(Entry *entry);
+
+    void reset(xmrig::Algo algo);
+
+    mutable std::mutex m_mutex;
+    size_t m_total;
+    std::vector<Entry *> m_free;
+    xmrig::Algo m_algo;
+};
+
+
+#endif /* XMRIG_CONTEXTPOOL_H */
@@ -26,6 +26,7 @@
 
 
 #include <assert.h>
+#include <atomic>
 #include <stdint.h>
 #include <uv.h>
 
@@ -45,16 +46,16 @@ public:
     void start(void (*callback) (void *));
 
     inline GpuContext *ctx() const         { return m_ctx; }
-    inline IWorker *worker() const         { return m_worker; }
+    inline IWorker *worker() const         { return m_worker.load(std::memory_order_acquire); }
     inline size_t threadId() const         { return m_threadId; }
     inline size_t totalWays() const        { return m_totalWays; }
     inline uint32_t offset() const         { return m_offset; }
-    inline void setWorker(IWorker *worker) { assert(worker != nullptr); m_worker = worker; }
+    inline void setWorker(IWorker *worker) { assert(worker != nullptr); m_worker.store(worker, std::memory_order_release); }
     inline xmrig::IThread *config() const  { return m_config; }
 
 private:
     GpuContext *m_ctx;
-    IWorker *m_worker;
+    std::atomic<IWorker *> m_worker;
     size_t m_threadId;
     size_t m_totalWays;
     uint32_t m_offset;
@@ -35,6 +35,19 @@
 #include "workers/Hashrate.h"
 
 
+// Samples arrive every 500 ms, the fine series covers 17 minutes and the coarse one, every 128th sample, 36 hours
+static const struct {
+    size_t ms;
+    bool coarse;
+} windows[] = {
+    { Hashrate::ShortInterval,  false },
+    { Hashrate::MediumInterval, false },
+    { Hashrate::LargeInterval,  false },
+    { Hashrate::HourInterval,   true  },
+    { Hashrate::DayInterval,    true  }
+};
+
+
 inline static const char *format(double h, char *buf, size_t size)
 {
     if (isnormal(h)) {
@@ -51,14 +64,21 @@ Hashrate::Hashrate(size_t threads, xmrig::Controller *controller) :
     m_threads(threads),
     m_controller(controller)
 {
-    m_counts     = new uint64_t*[threads];
-    m_timestamps = new uint64_t*[threads];
-    m_top        = new uint32_t[threads];
+    static_assert(sizeof(windows) / sizeof(windows[0]) == kWindows, "Hashrate windows mismatch");
+
+    m_series = new Series[threads];
 
     for (size_t i = 0; i < threads; i++) {
-        m_counts[i]     = new uint64_t[kBucketSize]();
-        m_timestamps[i] = new uint64_t[kBucketSize]();
-        m_top[i]        = 0;
+        Series &series = m_series[i];
+
+        series.fineTop   = 0;
+        series.coarseTop = 0;
+        series.timestamp = 0;
+
+        for (size_t w = 0; w < kWindows; ++w) {
+            series.tail[w] = 0;
+            series.rate[w] = nan("");
+        }
     }
 
     const int printTime = controller->config()->printTime();
@@ -91,64 +111,66 @@ double Hashrate::calc(size_t ms) const
 double Hashrate::calc(size_t threadId, size_t ms) const
 {
     assert(threadId < m_threads);
-    if (threadId >= m_threads) {
+    const int w = window(ms);
+
+    if (threadId >= m_threads || w < 0) {
         return nan("");
     }
 
     using namespace std::chrono;
     const uint64_t now = time_point_cast<milliseconds>(high_resolution_clock::now()).time_since_epoch().count();
 
-    uint64_t earliestHashCount = 0;
-    uint64_t earliestStamp     = 0;
-    uint64_t lastestStamp      = 0;
-    uint64_t lastestHashCnt    = 0;
-    bool haveFullSet           = false;
+    const Series &series = m_series[threadId];
+    const uint64_t timestamp = series.timestamp.load(std::memory_order_acquire);
 
-    for (size_t i = 1; i < kBucketSize; i++) {
-        const size_t idx = (m_top[threadId] - i) & kBucketMask;
-
-        if (m_timestamps[threadId][idx] == 0) {
-            break;
-        }
+    if (timestamp == 0 || now - timestamp > ms) {
+        return nan("");
+    }
 
-        if (lastestStamp == 0) {
-            lastestStamp = m_timestamps[threadId][idx];
-            lastestHashCnt = m_counts[threadId][idx];
-        }
+    return series.rate[w].load(std::memory_order_relaxed);
+}
 
-        if (now - m_timestamps[threadId][idx] > ms) {
-            haveFullSet = true;
-            break;
-        }
 
-        earliestStamp = m_timestamps[threadId][idx];
-        earliestHashCount = m_counts[threadId][idx];
+// Rates are updated here for every window, the oldest sample of each window is tracked
+// by a cursor that only moves forward, so neither add() nor calc() scan the series
+void Hashrate::add(size_t threadId, uint64_t count, uint64_t timestamp)
+{
+    if (timestamp == 0) {
+        return;
     }
 
-    if (!haveFullSet || earliestStamp == 0 || lastestStamp == 0) {
-        return nan("");
-    }
+    Series &series = m_series[threadId];
 
-    if (lastestStamp - earliestStamp == 0) {
-        return nan("");
+    series.fine[series.fineTop & kSeriesMask] = { count, timestamp };
+    if ((series.fineTop++ % kCoarseStep) == 0) {
+        series.coarse[series.coarseTop++ & kSeriesMask] = { count, timestamp };
     }
 
-    double hashes, time;
-    hashes = (double) lastestHashCnt - earliestHashCount;
-    time   = (double) lastestStamp - earliestStamp;
-    time  /= 1000.0;
+    for (size_t w = 0; w < kWindows; ++w) {
+        const Sample *samples = windows[w].coarse ? series.coarse : series.fine;
+        const size_t top      = windows[w].coarse ? series.coarseTop : series.fineTop;
+        const uint64_t start  = timestamp - windows[w].ms;
+        size_t &tail          = series.tail[w];
 
-    return hashes / time;
-}
+        if (top - tail > kSeriesSize) {
+            tail = top - kSeriesSize;
+        }
 
+        while (tail + 1 < top && samples[(tail + 1) & kSeriesMask].timestamp <= start) {
+            tail++;
+        }
 
-void Hashrate::add(size_t threadId, uint64_t count, uint64_t timestamp)
-{
-    const size_t top = m_top[threadId];
-    m_counts[threadId][top]     = count;
-    m_timestamps[threadId][top] = timestamp;
+        const Sample &first = samples[tail & kSeriesMask];
+        double rate         = nan("");
+
+        if (first.timestamp <= start && first.timestamp < timestamp) {
+            rate = (count - first.count) * 1000.0 / (timestamp - first.timestamp);
+        }
 
-    m_top[threadId] = (top + 1) & kBucketMask;
+        series.rate[w].store(rate, std::memory_order_relaxed);
+    }
+
+    series.timestamp.store(timestamp, std::memory_order_release);
 }
 
 
@@ -190,6 +212,18 @@ const char *Hashrate::format(double h, char *buf, size_t size)
 }
 
 
+int Hashrate::window(size_t ms)
+{
+    for (size_t i = 0; i < kWindows; ++i) {
+        if (windows[i].ms == ms) {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+
 void Hashrate::onReport(uv_timer_t *handle)
 {
     static_cast<Hashrate*>(handle->data)->print();
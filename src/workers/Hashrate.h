@@ -25,6 +25,7 @@
 #define __HASHRATE_H__
 
 
+#include <atomic>
 #include <stdint.h>
 #include <uv.h>
 
@@ -40,7 +41,9 @@ public:
     enum Intervals {
         ShortInterval  = 10000,
         MediumInterval = 60000,
-        LargeInterval  = 900000
+        LargeInterval  = 900000,
+        HourInterval   = 3600000,
+        DayInterval    = 86400000
     };
 
     Hashrate(size_t threads, xmrig::Controller *controller);
@@ -57,16 +60,35 @@ public:
     static const char *format(double h, char *buf, size_t size);
 
 private:
-    static void onReport(uv_timer_t *handle);
+    constexpr static size_t kWindows     = 5;
+    constexpr static size_t kSeriesSize  = 2048;
+    constexpr static size_t kSeriesMask  = kSeriesSize - 1;
+    constexpr static size_t kCoarseStep  = 128;
+
+    struct Sample
+    {
+        uint64_t count;
+        uint64_t timestamp;
+    };
 
-    constexpr static size_t kBucketSize = 2 << 11;
-    constexpr static size_t kBucketMask = kBucketSize - 1;
+    // Written only from the uv loop by add(), readers only touch the atomics
+    struct Series
+    {
+        Sample fine[kSeriesSize];
+        Sample coarse[kSeriesSize];
+        size_t fineTop;
+        size_t coarseTop;
+        size_t tail[kWindows];
+        std::atomic<double> rate[kWindows];
+        std::atomic<uint64_t> timestamp;
+    };
+
+    static int window(size_t ms);
+    static void onReport(uv_timer_t *handle);
 
     double m_highest;
+    Series *m_series;
     size_t m_threads;
-    uint32_t* m_top;
-    uint64_t** m_counts;
-    uint64_t** m_timestamps;
     uv_timer_t m_timer;
     xmrig::Controller *m_controller;
 };
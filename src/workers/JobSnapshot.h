@@ -0,0 +1,66 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_JOBSNAPSHOT_H
+#define XMRIG_JOBSNAPSHOT_H
+
+
+#include <atomic>
+#include <stdint.h>
+
+
+#include "common/net/Job.h"
+
+
+/* Immutable, reference counted copy of the current job, tagged with the sequence it was published with */
+class JobSnapshot
+{
+public:
+    inline JobSnapshot(const xmrig::Job &job, uint64_t sequence, bool donate) : m_refs(1), m_sequence(sequence), m_job(job)
+    {
+        if (donate) {
+            m_job.setPoolId(-1);
+        }
+    }
+
+    inline const xmrig::Job &job() const { return m_job; }
+    inline uint64_t sequence() const     { return m_sequence; }
+    inline void retain() const           { m_refs.fetch_add(1, std::memory_order_relaxed); }
+
+    inline void release() const
+    {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+private:
+    inline ~JobSnapshot() {}
+
+    mutable std::atomic<int> m_refs;
+    const uint64_t m_sequence;
+    xmrig::Job m_job;
+};
+
+
+#endif /* XMRIG_JOBSNAPSHOT_H */
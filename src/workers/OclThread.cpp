@@ -131,7 +131,7 @@ int xmrig::OclThread::unrollFactor() const
 
 size_t xmrig::OclThread::intensity() const
 {
-    return m_ctx->rawIntensity;
+    return m_ctx->configuredIntensity();
 }
 
 
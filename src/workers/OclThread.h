@@ -28,8 +28,6 @@
 
 #include "common/xmrig.h"
 #include "interfaces/IThread.h"
-#include "amd/CoolingContext.h"
-//#include "amd/AdlUtils.h"
 
 
 struct GpuContext;
@@ -51,9 +49,7 @@ public:
     inline GpuContext *ctx() const  { return m_ctx; }
     inline void setAffinity(int64_t affinity) { m_affinity = affinity; }
 
-    inline void setCardId(int cardid) { m_cardId = cardid; }
     inline void setThreadId(int threadid) { m_threadId = threadid; }
-    inline int cardId() const { return m_cardId; }
     inline int threadId() const { return m_threadId; }
 
     inline void setPciBusID(uint32_t pciBusID) { m_pciBusID = pciBusID; }
@@ -88,9 +84,6 @@ public:
     void setUnrollFactor(int unrollFactor);
     void setWorksize(size_t worksize);
 
-    inline CoolingContext* cool() const { return m_cool; }
-    inline void setCoolingContext(CoolingContext *cool) {m_cool = cool; }
-
 protected:
 #   ifdef APP_DEBUG
     void print() const override;
@@ -107,14 +100,11 @@ private:
     int64_t m_affinity;
     xmrig::Algo m_algorithm;
 
-    int m_cardId;
     int m_threadId;
 
     uint32_t m_pciBusID;
     uint32_t m_pciDeviceID;
     uint32_t m_pciDomainID;
-
-    CoolingContext *m_cool;
 };
 
 
@@ -24,11 +24,13 @@
  */
 
 
+#include <algorithm>
 #include <inttypes.h>
 #include <mutex>
 #include <thread>
 
 
+#include "amd/OclError.h"
 #include "amd/OclGPU.h"
 #include "common/log/Log.h"
 #include "common/Platform.h"
@@ -36,13 +38,12 @@
 #include "core/Config.h"
 #include "crypto/CryptoNight.h"
 #include "workers/Handle.h"
+#include "workers/JobSnapshot.h"
 #include "workers/OclThread.h"
 #include "workers/OclWorker.h"
 #include "amd/OclCache.h"
 #include "workers/Workers.h"
 
-#include "amd/AdlUtils.h"
-
 #define MAX_DEVICE_COUNT 32
 
 
@@ -60,12 +61,25 @@ static struct SGPUThreadInterleaveData
 OclWorker::OclWorker(Handle *handle) :
     m_id(handle->threadId()),
     m_threads(handle->totalWays()),
+    m_disabled(false),
     m_ctx(handle->ctx()),
+    m_settings(handle->ctx()->settings()),
+    m_appliedTarget(0),
+    m_reconfigure(ReconfigureIdle),
+    m_intensity(handle->ctx()->rawIntensity),
+    m_targetIntensity(0),
+    m_thermalIntensity(0),
+    m_gap(0),
     m_hashCount(0),
+    m_latency(0),
     m_timestamp(0),
+    m_averageLatency(0),
     m_count(0),
+    m_epoch(0),
     m_sequence(0),
-    m_blob()
+    m_blob(),
+    m_pausedSnapshot(nullptr),
+    m_snapshot(nullptr)
 {
     const int64_t affinity = handle->config()->affinity();
     m_thread = static_cast<xmrig::OclThread *>(handle->config());
@@ -80,51 +94,32 @@ void OclWorker::start()
 {
     SGPUThreadInterleaveData& interleaveData = GPUThreadInterleaveData[m_ctx->deviceIdx % MAX_DEVICE_COUNT];
     cl_uint results[0x100];
-    bool IsCoolingEnabled = false;
-
-    CoolingContext cool;
-    cool.LastTick = AdlUtils::GetTickCount();
 
     m_thread->setThreadId(m_id);
-    m_thread->setCoolingContext(&cool);
-
-    cool.PciBus = m_ctx->device_pciBusID;
-    cool.Card = m_ctx->deviceIdx;
-
-    //Workers::addWorkercount();
-
-    //OclCache::sleep(50000);
-    
-    //LOG_INFO("m_thread->pciBusID() = %x, cool.pciBus = %x, m_thread->cardId = %i, cool.Card = %i", m_thread->pciBusID(), cool.pciBus, m_thread->cardId(), cool.Card);
-
-    IsCoolingEnabled = AdlUtils::InitADL(&cool);
-    if (IsCoolingEnabled == false) {
-        LOG_WARN("Cooling is disabled for thread %i!", id());
-    }
-    else {
-        IsCoolingEnabled = AdlUtils::Get_DeviceID_by_PCI(&cool, m_thread);
-        if (!IsCoolingEnabled) {
-            LOG_ERR("Failed get_deviceid_by_pci DeviceId %i pciDeviceID %02x pciBusID %02x pciDomainID %02x", cool.Card, m_thread->pciDeviceID(), m_thread->pciBusID(), m_thread->pciDomainID());
-        }
-        AdlUtils::GetMaxFanRpm(&cool);
-        m_thread->setCardId(cool.Card);
 
-    }
     //LOG_INFO("DEBUG 1");
 
     while (Workers::sequence() > 0) {
 
-        if (IsCoolingEnabled)
-            AdlUtils::DoCooling(m_ctx->DeviceID, m_ctx->deviceIdx, m_id, &cool);
-
         //LOG_INFO("DEBUG 2");
 
         while (!Workers::isOutdated(m_sequence)) {
 
             //LOG_INFO("DEBUG 3");
 
-            if (IsCoolingEnabled)
-                AdlUtils::DoCooling(m_ctx->DeviceID, m_ctx->deviceIdx, m_id, &cool);
+            if (m_reconfigure.load(std::memory_order_acquire) == ReconfigurePending) {
+                applySettings(results);
+            }
+
+            if (m_disabled) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+
+            const size_t target = targetIntensity();
+            if (target != m_appliedTarget) {
+                applyIntensity(target, results);
+            }
 
             memset(results, 0, sizeof(cl_uint) * (0x100));
             
@@ -144,17 +139,32 @@ void OclWorker::start()
 
             const int64_t t = xmrig::steadyTimestamp();
 
-            XMRRunJob(m_ctx, results, m_job.algorithm().variant());
-
-            for (size_t i = 0; i < results[0xFF]; i++) {
-                *m_job.nonce() = results[i];
-                Workers::submit(m_job);
+            if (m_ctx->pipeline) {
+                XMRRunJobPipelined(m_ctx, results, m_job.algorithm().variant());
+            }
+            else {
+                XMRRunJob(m_ctx, results, m_job.algorithm().variant());
             }
 
+            submit(results);
+
             storeStats(t);
+
+            const uint64_t gap = m_gap.load(std::memory_order_relaxed);
+            if (gap > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(gap));
+            }
+
             std::this_thread::yield();
         }
 
+        if (m_ctx->pipeline) {
+            drain(results);
+        }
+
+        const bool donate = m_job.poolId() == -1;
+        auto idle         = std::chrono::steady_clock::now();
+
         if (Workers::isPaused()) {
             {
                 std::lock_guard<std::mutex> g(interleaveData.m);
@@ -162,6 +172,10 @@ void OclWorker::start()
             }
 
             do {
+                if (m_reconfigure.load(std::memory_order_acquire) == ReconfigurePending) {
+                    applySettings(results);
+                }
+
                 std::this_thread::sleep_for(std::chrono::milliseconds(50));
             } while (Workers::isPaused());
 
@@ -177,21 +191,131 @@ void OclWorker::start()
 
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay));
             }
+
+            idle = std::chrono::steady_clock::now();
         }
 
         consumeJob();
+
+        // Only switches between the user and the donation pool are reported, a pause is not a switch
+        if (!m_disabled && m_job.isValid() && donate != (m_job.poolId() == -1)) {
+            Workers::addSwitchTime(m_epoch, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - idle).count());
+        }
+    }
+
+    if (m_snapshot) {
+        m_snapshot->release();
     }
-    AdlUtils::ReleaseADL(&cool, true);
+
+    if (m_pausedSnapshot) {
+        m_pausedSnapshot->release();
+    }
+
     LOG_WARN("Thread #%zu EXITED", m_id);
 }
 
 
+// Called from the main thread, the worker picks the settings up before its next batch
+void OclWorker::reconfigure(const GpuSettings &settings)
+{
+    if (m_reconfigure.load(std::memory_order_acquire) == ReconfigurePending) {
+        return;
+    }
+
+    m_settings = settings;
+    m_reconfigure.store(ReconfigurePending, std::memory_order_release);
+}
+
+
+// Only the NDRange shrinks, buffers keep the size they were allocated with, 0 restores the full intensity
+void OclWorker::applyIntensity(size_t target, cl_uint *results)
+{
+    m_appliedTarget = target;
+
+    size_t intensity = m_ctx->allocatedIntensity;
+    if (target > 0 && target < intensity) {
+        intensity = std::max(m_ctx->workSize, target / m_ctx->workSize * m_ctx->workSize);
+    }
+
+    if (intensity == m_ctx->rawIntensity) {
+        return;
+    }
+
+    if (m_ctx->pipeline) {
+        drain(results);
+    }
+
+    m_ctx->rawIntensity = intensity;
+    m_intensity.store(intensity, std::memory_order_relaxed);
+
+    if (m_job.isValid()) {
+        setJob();
+    }
+}
+
+
+// Settings the device rejects are rolled back, the thread only stops hashing if the previous ones fail too
+void OclWorker::applySettings(cl_uint *results)
+{
+    if (m_ctx->pipeline) {
+        drain(results);
+    }
+
+    const GpuSettings previous = m_ctx->settings();
+    xmrig::Config *config      = Workers::config();
+
+    const bool ok = ReconfigureOpenCLDevice(m_ctx, config, m_settings) == OCL_ERR_SUCCESS;
+    if (!ok) {
+        LOG_ERR("Thread #%zu rejected intensity %zu, worksize %zu, restoring previous settings", m_id, m_settings.intensity, m_settings.worksize);
+
+        m_disabled = ReconfigureOpenCLDevice(m_ctx, config, previous) != OCL_ERR_SUCCESS;
+        if (m_disabled) {
+            LOG_ERR("Thread #%zu cannot restore previous settings, thread disabled", m_id);
+        }
+    }
+    else {
+        m_disabled = false;
+    }
+
+    m_appliedTarget = 0;
+    m_intensity.store(m_ctx->rawIntensity, std::memory_order_relaxed);
+
+    if (!m_disabled && m_job.isValid()) {
+        setJob();
+    }
+
+    m_reconfigure.store(ok ? ReconfigureDone : ReconfigureFailed, std::memory_order_release);
+}
+
+
+// Batches still in flight belong to the job they were enqueued with, complete them before switching
+void OclWorker::drain(cl_uint *results)
+{
+    while (!XMRIsPipelineEmpty(m_ctx)) {
+        if (XMRFinishPipelined(m_ctx, results, m_job.algorithm().variant()) != OCL_ERR_SUCCESS) {
+            break;
+        }
+
+        if (Workers::sequence() > 0) {
+            submit(results);
+        }
+    }
+}
+
+
 bool OclWorker::resume(const xmrig::Job &job)
 {
     if (m_job.poolId() == -1 && job.poolId() >= 0 && job.id() == m_pausedJob.id()) {
         m_job        = m_pausedJob;
         m_ctx->Nonce = m_pausedNonce;
 
+        if (m_snapshot) {
+            m_snapshot->release();
+        }
+
+        m_snapshot       = m_pausedSnapshot;
+        m_pausedSnapshot = nullptr;
+
         return true;
     }
 
@@ -228,6 +352,20 @@ int64_t OclWorker::interleaveAdjustDelay() const
 }
 
 
+// The lower of the API and the thermal limits wins, 0 means no limit
+size_t OclWorker::targetIntensity() const
+{
+    const size_t target  = m_targetIntensity.load(std::memory_order_relaxed);
+    const size_t thermal = m_thermalIntensity.load(std::memory_order_relaxed);
+
+    if (target == 0 || thermal == 0) {
+        return std::max(target, thermal);
+    }
+
+    return std::min(target, thermal);
+}
+
+
 int64_t OclWorker::resumeDelay() const
 {
     SGPUThreadInterleaveData &data = GPUThreadInterleaveData[m_ctx->deviceIdx % MAX_DEVICE_COUNT];
@@ -252,20 +390,40 @@ int64_t OclWorker::resumeDelay() const
 
 void OclWorker::consumeJob()
 {
-    xmrig::Job job = Workers::job();
+    // Read the sequence first, a job published in between is then picked up on the next pass
     m_sequence = Workers::sequence();
+
+    const JobSnapshot *snapshot = Workers::snapshot();
+    if (snapshot->sequence() == m_epoch) {
+        snapshot->release();
+        return;
+    }
+
+    m_epoch = snapshot->sequence();
+
+    const xmrig::Job &job = snapshot->job();
     if (m_job.id() == job.id() && m_job.clientId() == job.clientId()) {
+        snapshot->release();
         return;
     }
 
     save(job);
 
     if (resume(job)) {
+        snapshot->release();
         setJob();
         return;
     }
 
-    m_job = std::move(job);
+    m_job = job;
+
+    // Keep the snapshot, found shares reference it instead of copying the job
+    if (m_snapshot) {
+        m_snapshot->release();
+    }
+
+    m_snapshot = snapshot;
+
     m_job.setThreadId(m_id);
 
     if (m_job.isNicehash()) {
@@ -284,6 +442,21 @@ void OclWorker::save(const xmrig::Job &job)
     if (job.poolId() == -1 && m_job.poolId() >= 0) {
         m_pausedJob   = m_job;
         m_pausedNonce = m_ctx->Nonce;
+
+        if (m_pausedSnapshot) {
+            m_pausedSnapshot->release();
+        }
+
+        m_pausedSnapshot = m_snapshot;
+        m_pausedSnapshot->retain();
+    }
+}
+
+
+void OclWorker::submit(const cl_uint *results)
+{
+    for (size_t i = 0; i < results[0xFF]; i++) {
+        Workers::submit(m_snapshot, results[i], m_id);
     }
 }
 
@@ -311,13 +484,17 @@ void OclWorker::storeStats(int64_t t)
     // averagingBias = 0.1 - the last delta time has 10% weight of all the previous ones combined
     const double averagingBias = 0.1;
 
-    {
-        int64_t t2 = xmrig::steadyTimestamp();
+    const int64_t t2 = xmrig::steadyTimestamp();
 
+    {
         std::lock_guard<std::mutex> g(data.m);
         data.averageRunTime = data.averageRunTime * (1.0 - averagingBias) + (t2 - t) * averagingBias;
     }
 
+    // Per thread batch latency in microseconds, allows to compare host and device side branch dispatch
+    m_averageLatency = m_averageLatency * (1.0 - averagingBias) + (t2 - t) * 1000.0 * averagingBias;
+    m_latency.store(static_cast<uint64_t>(m_averageLatency), std::memory_order_relaxed);
+
     const uint64_t timestamp = static_cast<uint64_t>(xmrig::currentMSecsSinceEpoch());
     m_hashCount.store(m_count, std::memory_order_relaxed);
     m_timestamp.store(timestamp, std::memory_order_relaxed);
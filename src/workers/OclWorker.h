@@ -38,6 +38,7 @@
 
 
 class Handle;
+class JobSnapshot;
 
 
 class OclWorker : public IWorker
@@ -46,31 +47,56 @@ public:
     OclWorker(Handle *handle);
 
 protected:
+    inline int reconfigureState() const override { return m_reconfigure.load(std::memory_order_acquire); }
     inline uint64_t hashCount() const override { return m_hashCount.load(std::memory_order_relaxed); }
+    inline uint64_t latency() const override   { return m_latency.load(std::memory_order_relaxed); }
     inline uint64_t timestamp() const override { return m_timestamp.load(std::memory_order_relaxed); }
+    inline bool isDisabled() const override    { return m_disabled.load(std::memory_order_relaxed); }
     inline bool selfTest() override            { return true; }
     inline size_t id() const override          { return m_id; }
+    inline size_t intensity() const override   { return m_intensity.load(std::memory_order_relaxed); }
+    inline void setIntensity(size_t intensity) override { m_targetIntensity.store(intensity, std::memory_order_relaxed); }
+    inline void setThermalLimit(size_t intensity, uint64_t gap) override { m_thermalIntensity.store(intensity, std::memory_order_relaxed); m_gap.store(gap, std::memory_order_relaxed); }
 
+    void reconfigure(const GpuSettings &settings) override;
     void start() override;
 
 private:
     bool resume(const xmrig::Job &job);
     int64_t interleaveAdjustDelay() const;
+    size_t targetIntensity() const;
     int64_t resumeDelay() const;
     void consumeJob();
+    void applyIntensity(size_t target, cl_uint *results);
+    void applySettings(cl_uint *results);
+    void drain(cl_uint *results);
     void save(const xmrig::Job &job);
     void setJob();
+    void submit(const cl_uint *results);
     void storeStats(int64_t t);
 
     const size_t m_id;
     const size_t m_threads;
+    std::atomic<bool> m_disabled;
     GpuContext *m_ctx;
+    GpuSettings m_settings;
+    size_t m_appliedTarget;
+    std::atomic<int> m_reconfigure;
+    std::atomic<size_t> m_intensity;
+    std::atomic<size_t> m_targetIntensity;
+    std::atomic<size_t> m_thermalIntensity;
+    std::atomic<uint64_t> m_gap;
     std::atomic<uint64_t> m_hashCount;
+    std::atomic<uint64_t> m_latency;
     std::atomic<uint64_t> m_timestamp;
+    double m_averageLatency;
     uint32_t m_pausedNonce;
     uint64_t m_count;
+    uint64_t m_epoch;
     uint64_t m_sequence;
     uint8_t m_blob[xmrig::Job::kMaxBlobSize];
+    const JobSnapshot *m_pausedSnapshot;
+    const JobSnapshot *m_snapshot;
     xmrig::Job m_job;
     xmrig::Job m_pausedJob;
     
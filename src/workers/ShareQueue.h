@@ -0,0 +1,122 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_SHAREQUEUE_H
+#define XMRIG_SHAREQUEUE_H
+
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+
+class JobSnapshot;
+
+
+/* Bounded multi-producer single-consumer ring of found shares, all cells are preallocated */
+class ShareQueue
+{
+public:
+    enum {
+        kCapacity = 1024
+    };
+
+    struct Share
+    {
+        const JobSnapshot *snapshot;
+        uint32_t nonce;
+        uint32_t threadId;
+    };
+
+    inline ShareQueue() : m_head(0), m_tail(0)
+    {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+
+    // Safe to call from any GPU thread, returns false if the ring is full
+    inline bool push(const Share &share)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &m_cells[pos & (kCapacity - 1)];
+
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff   = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->share = share;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+
+    // Must only be called from the consumer (main loop) thread
+    inline bool pop(Share &share)
+    {
+        Cell &cell = m_cells[m_head & (kCapacity - 1)];
+
+        if (cell.sequence.load(std::memory_order_acquire) != m_head + 1) {
+            return false;
+        }
+
+        share = cell.share;
+        cell.sequence.store(m_head + kCapacity, std::memory_order_release);
+        m_head++;
+
+        return true;
+    }
+
+private:
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "ShareQueue capacity must be a power of 2");
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Share share;
+    };
+
+    Cell m_cells[kCapacity];
+    alignas(64) size_t m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+
+#endif /* XMRIG_SHAREQUEUE_H */
@@ -0,0 +1,128 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+
+
+#include "amd/GpuContext.h"
+#include "amd/GpuSensors.h"
+#include "common/log/Log.h"
+#include "interfaces/IWorker.h"
+#include "workers/Handle.h"
+#include "workers/Thermal.h"
+#include "workers/Workers.h"
+
+
+static const int64_t kInterval = 1000;
+static const double kMinScale  = 0.25;
+
+
+Thermal::Thermal(const std::vector<Handle *> &workers)
+{
+    for (Handle *handle : workers) {
+        auto it = std::find_if(m_cards.begin(), m_cards.end(), [handle](const Card *card) { return card->device == handle->ctx()->deviceIdx; });
+        if (it != m_cards.end()) {
+            (*it)->handles.push_back(handle);
+            continue;
+        }
+
+        Card *card      = new Card();
+        card->device    = handle->ctx()->deviceIdx;
+        card->sampled   = 0;
+        card->updated   = 0;
+        card->throttled = false;
+        card->handles.push_back(handle);
+
+        m_cards.push_back(card);
+    }
+}
+
+
+Thermal::~Thermal()
+{
+    for (Card *card : m_cards) {
+        delete card;
+    }
+}
+
+
+void Thermal::tick(int64_t now)
+{
+    for (Card *card : m_cards) {
+        if (now - card->updated >= kInterval) {
+            update(*card, now);
+        }
+    }
+}
+
+
+// Down to a quarter of the configured intensity the batches only get smaller, below that short gaps between batches take over
+void Thermal::apply(const Card &card, double duty) const
+{
+    for (const Handle *handle : card.handles) {
+        IWorker *worker = handle->worker();
+        if (!worker) {
+            continue;
+        }
+
+        if (duty >= 1.0) {
+            worker->setThermalLimit(0, 0);
+            continue;
+        }
+
+        const double scale     = std::max(duty, kMinScale);
+        const size_t intensity = std::max<size_t>(1, static_cast<size_t>(handle->ctx()->configuredIntensity() * scale));
+        const uint64_t gap     = duty < kMinScale ? static_cast<uint64_t>(worker->latency() * (kMinScale / duty - 1.0)) : 0;
+
+        worker->setThermalLimit(intensity, gap);
+    }
+}
+
+
+// Runs on every new sensor sample of the card, the sensor service does the I/O and drives the fan
+void Thermal::update(Card &card, int64_t now)
+{
+    GpuSensors::Sample sample;
+    if (!GpuSensors::read(card.device, sample) || sample.timestamp == card.sampled) {
+        return;
+    }
+
+    const double dt   = card.sampled > 0 ? (sample.timestamp - card.sampled) / 1000.0 : 0.0;
+    const double duty = card.controller.update(sample.temperature, Workers::maxtemp(), dt);
+
+    card.sampled = sample.timestamp;
+    card.updated = now;
+
+    if (duty < 1.0 && !card.throttled) {
+        LOG_INFO(YELLOW("GPU #%zu temperature %i is close to %i, reduced mining to %.0f%%"), card.device, sample.temperature, Workers::maxtemp(), duty * 100.0);
+    }
+    else if (duty >= 1.0 && card.throttled) {
+        LOG_INFO(YELLOW("GPU #%zu temperature %i is below %i, do full mining"), card.device, sample.temperature, Workers::maxtemp());
+    }
+
+    card.throttled = duty < 1.0;
+
+    apply(card, duty);
+}
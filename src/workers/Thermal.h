@@ -0,0 +1,66 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XMRIG_THERMAL_H
+#define XMRIG_THERMAL_H
+
+
+#include <stdint.h>
+#include <vector>
+
+
+#include "workers/ThermalController.h"
+
+
+class Handle;
+
+
+/* One thermal controller per physical card, all threads of the card share its duty cycle */
+class Thermal
+{
+public:
+    Thermal(const std::vector<Handle *> &workers);
+    ~Thermal();
+
+    void tick(int64_t now);
+
+private:
+    struct Card
+    {
+        size_t device;
+        std::vector<Handle *> handles;
+        ThermalController controller;
+        int64_t sampled;
+        int64_t updated;
+        bool throttled;
+    };
+
+    void apply(const Card &card, double duty) const;
+    void update(Card &card, int64_t now);
+
+    std::vector<Card *> m_cards;
+};
+
+
+#endif /* XMRIG_THERMAL_H */
@@ -0,0 +1,82 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+
+
+#include "workers/ThermalController.h"
+
+
+// Gains are per degree, tuned on a first order model (30-60s time constant, 1C sensor resolution, 3s sensor lag),
+// bench/thermal.cpp runs that model
+static const double kProportional = 0.08;
+static const double kIntegral     = 0.002;
+static const double kDerivative   = 0.5;
+static const double kSmoothing    = 0.3;
+
+
+const double ThermalController::kMinDuty = 0.1;
+
+
+ThermalController::ThermalController()
+{
+    reset();
+}
+
+
+// Returns the share of full load the card can take, 1.0 as long as it stays below the target
+double ThermalController::update(double temperature, double target, double dt)
+{
+    if (dt <= 0.0) {
+        return m_duty;
+    }
+
+    // Sensors report whole degrees, smoothing keeps the derivative term from reacting to single steps
+    m_filtered = m_primed ? m_filtered + kSmoothing * (temperature - m_filtered) : temperature;
+
+    const double error      = m_filtered - target;
+    const double derivative = m_primed ? (m_filtered - m_previous) / dt : 0.0;
+
+    m_primed   = true;
+    m_previous = m_filtered;
+
+    // The integral only ever holds throttling, a cold card does not build up credit to overshoot later
+    m_integral = std::min(std::max(m_integral + kIntegral * error * dt, 0.0), 1.0 - kMinDuty);
+
+    const double throttle = kProportional * error + m_integral + kDerivative * derivative;
+    m_duty = std::min(std::max(1.0 - throttle, kMinDuty), 1.0);
+
+    return m_duty;
+}
+
+
+void ThermalController::reset()
+{
+    m_primed   = false;
+    m_duty     = 1.0;
+    m_filtered = 0.0;
+    m_integral = 0.0;
+    m_previous = 0.0;
+}
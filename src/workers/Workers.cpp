@@ -22,31 +22,43 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <inttypes.h>
 #include <thread>
 
 
+#include "amd/GpuSensors.h"
+#include "amd/OclCache.h"
+#include "amd/OclError.h"
 #include "amd/OclGPU.h"
 #include "amd/OclLib.h"
+#include "amd/OclProfiler.h"
 #include "api/Api.h"
 #include "common/log/Log.h"
+#include "common/utils/timestamp.h"
 #include "core/Config.h"
 #include "core/Controller.h"
 #include "crypto/CryptoNight.h"
 #include "interfaces/IJobResultListener.h"
 #include "interfaces/IThread.h"
 #include "rapidjson/document.h"
+#include "workers/Autotune.h"
 #include "workers/Handle.h"
 #include "workers/Hashrate.h"
+#include "workers/JobSnapshot.h"
 #include "workers/OclThread.h"
 #include "workers/OclWorker.h"
+#include "workers/Thermal.h"
 #include "workers/Workers.h"
 #include "Mem.h"
 
-#include "amd/AdlUtils.h"
 
 
+Autotune *Workers::m_autotune = nullptr;
 bool Workers::m_active = false;
+bool Workers::m_autotuned = false;
+std::atomic<bool> Workers::m_autotuneRequested(false);
 bool Workers::m_enabled = true;
 
 int Workers::m_maxtemp = 75;
@@ -55,28 +67,46 @@ int Workers::m_fanlevel = 0;
 
 cl_context Workers::m_opencl_ctx;
 
+ContextPool Workers::m_contexts;
+std::vector<JobBaton*> Workers::m_batons;
 Hashrate *Workers::m_hashrate = nullptr;
 size_t Workers::m_threadsCount = 0;
+size_t Workers::m_verifyThreads = 0;
+std::atomic<size_t> Workers::m_failed;
+std::atomic<size_t> Workers::m_initialized;
+int64_t Workers::m_initTime = 0;
+int64_t Workers::m_jobTimestamp = 0;
+uint64_t Workers::m_jobLatency = 0;
+uint64_t Workers::m_jobReceived = 0;
 std::atomic<int> Workers::m_paused;
+size_t Workers::m_switchThreads = 0;
+uint64_t Workers::m_switchEpoch = UINT64_MAX;
+uint64_t Workers::m_switchTime = 0;
 std::atomic<uint64_t> Workers::m_sequence;
-std::list<xmrig::Job> Workers::m_queue;
+ShareQueue Workers::m_shares;
+Thermal *Workers::m_thermal = nullptr;
 std::vector<Handle*> Workers::m_workers;
 uint64_t Workers::m_ticks = 0;
+uint64_t Workers::m_verifyCount = 0;
+uint64_t Workers::m_verifyTime = 0;
 uv_async_t Workers::m_async;
-uv_mutex_t Workers::m_mutex;
+uv_mutex_t Workers::m_switchMutex;
 uv_rwlock_t Workers::m_rwlock;
 uv_timer_t Workers::m_timer;
 xmrig::Controller *Workers::m_controller = nullptr;
 xmrig::IJobResultListener *Workers::m_listener = nullptr;
-xmrig::Job Workers::m_job;
+std::atomic<const JobSnapshot *> Workers::m_snapshot;
+std::atomic<int> Workers::m_snapshotReaders;
+uint64_t Workers::m_epoch = 0;
 
 
 struct JobBaton
 {
     uv_work_t request;
-    std::vector<xmrig::Job> jobs;
-    std::vector<xmrig::JobResult> results;
-    int errors = 0;
+    ShareQueue::Share share;
+    xmrig::JobResult result;
+    bool valid = false;
+    uint64_t elapsed = 0;
 
     JobBaton() {
         request.data = this;
@@ -84,6 +114,31 @@ struct JobBaton
 };
 
 
+// The libuv threadpool has 4 threads unless UV_THREADPOOL_SIZE says otherwise, one of them is left for DNS and file requests
+static size_t verifyThreads(int configured)
+{
+    char buf[16];
+    size_t size = sizeof(buf);
+
+    const int poolSize  = uv_os_getenv("UV_THREADPOOL_SIZE", buf, &size) == 0 ? std::max(atoi(buf), 1) : 4;
+    const int available = std::max(poolSize - 1, 1);
+
+    if (configured <= 0) {
+        const size_t cores = std::thread::hardware_concurrency();
+
+        return std::max<size_t>(1, std::min<size_t>(cores / 2, static_cast<size_t>(available)));
+    }
+
+    if (configured > available) {
+        LOG_WARN("verify-threads %d does not fit the libuv threadpool of %d threads, using %d", configured, poolSize, available);
+
+        return static_cast<size_t>(available);
+    }
+
+    return static_cast<size_t>(configured);
+}
+
+
 static size_t threadsCountByGPU(size_t index, const std::vector<xmrig::IThread *> &threads)
 {
     size_t count = 0;
@@ -98,13 +153,31 @@ static size_t threadsCountByGPU(size_t index, const std::vector<xmrig::IThread *
 }
 
 
-xmrig::Job Workers::job()
+// Returns the current job snapshot with an extra reference, the caller must release() it
+const JobSnapshot *Workers::snapshot()
 {
-    uv_rwlock_rdlock(&m_rwlock);
-    xmrig::Job job = m_job;
-    uv_rwlock_rdunlock(&m_rwlock);
+    m_snapshotReaders.fetch_add(1);
+    const JobSnapshot *snapshot = m_snapshot.load();
+    snapshot->retain();
+    m_snapshotReaders.fetch_sub(1);
+
+    return snapshot;
+}
+
+
+// Safe to call from any thread, the worker applies the new NDRange size before its next batch
+bool Workers::setIntensity(size_t threadId, size_t intensity)
+{
+    for (Handle *handle : m_workers) {
+        IWorker *worker = handle->worker();
+
+        if (handle->threadId() == threadId && worker) {
+            worker->setIntensity(intensity);
+            return true;
+        }
+    }
 
-    return job;
+    return false;
 }
 
 
@@ -114,12 +187,59 @@ size_t Workers::hugePages()
 }
 
 
+size_t Workers::intensity(size_t threadId)
+{
+    for (Handle *handle : m_workers) {
+        IWorker *worker = handle->worker();
+
+        if (handle->threadId() == threadId && worker) {
+            return worker->intensity();
+        }
+    }
+
+    return 0;
+}
+
+
+// libuv sizes its threadpool once, on the first request, so this must run before anything uses it (the log file does)
+void Workers::initThreadpool(int configured)
+{
+    char buf[16];
+    size_t size = sizeof(buf);
+
+    if (configured > 3 && uv_os_getenv("UV_THREADPOOL_SIZE", buf, &size) == UV_ENOENT) {
+        snprintf(buf, sizeof(buf), "%d", configured + 1);
+        uv_os_setenv("UV_THREADPOOL_SIZE", buf);
+    }
+}
+
+
+// Called by a worker thread once it runs the first job after a switch, epoch is the sequence of the snapshot it took
+void Workers::addSwitchTime(uint64_t epoch, int64_t us)
+{
+    uv_mutex_lock(&m_switchMutex);
+
+    if (epoch >= m_switchEpoch) {
+        m_switchTime += static_cast<uint64_t>(us);
+        m_switchThreads++;
+    }
+
+    uv_mutex_unlock(&m_switchMutex);
+}
+
+
 size_t Workers::threads()
 {
     return m_threadsCount;
 }
 
 
+xmrig::Config *Workers::config()
+{
+    return m_controller->config();
+}
+
+
 void Workers::printHashrate(bool detail)
 {
     assert(m_controller != nullptr);
@@ -133,38 +253,45 @@ void Workers::printHashrate(bool detail)
         char num2[8] = { 0 };
         char num3[8] = { 0 };
 
-        LOG_INFO(" THREAD | GPU |     PCI    | 10s H/s | 60s H/s | 15m H/s | TEMP |  FAN |", isColors ? "\x1B[1;37m" : "");
+        LOG_INFO("%s THREAD | GPU |     PCI    | 10s H/s | 60s H/s | 15m H/s | TEMP |  FAN | BATCH ms (%s dispatch)", isColors ? "\x1B[1;37m" : "",
+                 m_controller->config()->isOclDeviceDispatch() ? "device" : "host");
         
 
         size_t i = 0;
         for (const xmrig::IThread *t : m_controller->config()->threads()) {
             auto thread = static_cast<const xmrig::OclThread *>(t);
-            CoolingContext *cool = thread->cool();
-                
-                //LOG_DEBUG("Cool=%i", cool);
 
-                AdlUtils::GetMaxFanRpm(cool);
-                AdlUtils::Temperature(cool);                
-                AdlUtils::GetFanPercent(cool, NULL);
-
-                //LOG_INFO("DEBUG printHashrate Speed %i", percent);
+                GpuSensors::Sample sample = {};
+                GpuSensors::read(thread->index(), sample);
 
                 //Log::i()->text("| %6zu | %3zu | " YELLOW("%04x:%02x:%02x") " | %3u  | %7s | %7s | %7s | %3.1i%%%  |",
-                LOG_INFO(" %6zu | %3zu | " YELLOW("%04x:%02x:%02x") " | %7s | %7s | %7s | %3u  | %3.li%% |",
-                    i, thread->cardId(),
+                const IWorker *worker = i < m_workers.size() ? m_workers[i]->worker() : nullptr;
+
+                LOG_INFO(" %6zu | %3zu | " YELLOW("%04x:%02x:%02x") " | %7s | %7s | %7s | %3u  | %3.li%% | %8.1f |",
+                    i, thread->index(),
                     thread->pciDomainID(),
                     thread->pciBusID(),
                     thread->pciDeviceID(),                    
                     Hashrate::format(m_hashrate->calc(i, Hashrate::ShortInterval), num1, sizeof num1),
                     Hashrate::format(m_hashrate->calc(i, Hashrate::MediumInterval), num2, sizeof num2),
                     Hashrate::format(m_hashrate->calc(i, Hashrate::LargeInterval), num3, sizeof num3),
-                    cool->CurrentTemp,
-                    cool->CurrentFanLevel
+                    sample.temperature,
+                    sample.fan,
+                    worker ? worker->latency() / 1000.0 : 0.0
                 );
 
                 i++;
             }
-         
+
+            if (m_verifyCount > 0) {
+                LOG_INFO(isColors ? "CPU verification " WHITE_BOLD("%.2f ms") " per share, " WHITE_BOLD("%" PRIu64) " shares, " WHITE_BOLD("%zu") " scratchpads, up to " WHITE_BOLD("%zu") " at once" :
+                                    "CPU verification %.2f ms per share, %" PRIu64 " shares, %zu scratchpads, up to %zu at once",
+                         m_verifyTime / 1e6 / m_verifyCount, m_verifyCount, m_contexts.size(), m_verifyThreads);
+            }
+
+            if (m_controller->config()->isOclProfiling()) {
+                OclProfiler::print();
+            }
         }
 
 
@@ -226,45 +353,17 @@ void Workers::printHealth()
 
 
 
-        size_t it = 0;
         matchcount = 0;
-        CoolingContext coollocal;
-        for (xmrig::IThread *t : m_controller->config()->threads()) {
-            auto thread = static_cast<const xmrig::OclThread *>(t);
-            CoolingContext *cool = thread->cool();
-                
-                //LOG_DEBUG("Cool=%i", cool);
-
-                // Check if this thread belongs to this card
-                if (ctx.device_pciBusID == cool->PciBus)
-                {
-                    matchcount++;
-
-                    AdlUtils::GetMaxFanRpm(cool);
-                    AdlUtils::Temperature(cool);                
-                    AdlUtils::GetFanPercent(cool, NULL);
-                    AdlUtils::Get_GPU_Power(cool, thread);
-                    AdlUtils::Get_GPU_Busy(cool, thread);
-
-                    if (matchcount == 1)
-                    {
-                        coollocal.GPUIndex = cool->GPUIndex;
-                        //LOG_INFO("GPUIndex=%i", coollocal.GPUIndex);
-                        coollocal.Busy = cool->Busy;
-                        coollocal.Power = cool->Busy;
-                    }
-                    else
-                    {
-                        coollocal.GPUIndex = cool->GPUIndex;
-                        //LOG_INFO("GPUIndex=%i", coollocal.GPUIndex);
-                        coollocal.Busy = (coollocal.Busy + cool->Busy) / 2;
-                        coollocal.Power = (coollocal.Power + cool->Power) / 2;
-                    }
-                    it++;
-                }    
-                
+        for (const xmrig::IThread *t : m_controller->config()->threads()) {
+            // Check if this thread belongs to this card
+            if (static_cast<const xmrig::OclThread *>(t)->pciBusID() == ctx.device_pciBusID) {
+                matchcount++;
             }
-         
+        }
+
+        GpuSensors::Sample sample = {};
+        GpuSensors::read(ctx.deviceIdx, sample);
+
             if (matchcount > 0)
             {
                 //LOG_INFO("DEBUG printHashrate Speed %i", percent);
@@ -279,7 +378,7 @@ void Workers::printHealth()
                                                             : "GPU #%i: | PCI:%04x:%02x:%02x | %u MHz | %i PWR | %i%% BUSY ",
                         ctx.deviceIdx,  //CardID,
                         ctx.device_pciDomainID, ctx.device_pciBusID, ctx.device_pciDeviceID,
-                        max_clock_freq, coollocal.Power, coollocal.Busy
+                        max_clock_freq, sample.power, sample.busy
                         );
             }         
         
@@ -328,6 +427,13 @@ void Workers::printHashrate(bool detail)
 }
 */
 
+// Safe to call from the API thread, the tuning itself starts on the next tick of the main loop
+void Workers::requestAutotune()
+{
+    m_autotuneRequested = true;
+}
+
+
 void Workers::setEnabled(bool enabled)
 {
     if (m_enabled == enabled) {
@@ -360,13 +466,27 @@ void Workers::setFanlevel(int fanlevel)
 
 void Workers::setJob(const xmrig::Job &job, bool donate)
 {
-    uv_rwlock_wrlock(&m_rwlock);
-    m_job = job;
+    // A switch between the user and the donation pool starts a new measurement, reports of an older one no longer count
+    const xmrig::Job &previous = m_snapshot.load()->job();
+    if (previous.isValid() && (previous.poolId() == -1) != donate) {
+        uv_mutex_lock(&m_switchMutex);
+        m_switchEpoch   = m_epoch + 1;
+        m_switchThreads = 0;
+        m_switchTime    = 0;
+        uv_mutex_unlock(&m_switchMutex);
+    }
+
+    publish(new JobSnapshot(job, ++m_epoch, donate));
+    m_contexts.setAlgo(job.algorithm().algo());
+    m_jobTimestamp = xmrig::steadyTimestamp();
+
+    // A job that is handed over again after a pool or donation switch was already counted when it first arrived
+    if (job.received() > m_jobReceived) {
+        m_jobReceived = job.received();
+        m_jobLatency  = uv_hrtime() - m_jobReceived;
 
-    if (donate) {
-        m_job.setPoolId(-1);
+        LOG_DEBUG("job switch %.3f ms after the socket read", m_jobLatency / 1e6);
     }
-    uv_rwlock_wrunlock(&m_rwlock);
 
     m_active = true;
     if (!m_enabled) {
@@ -399,14 +519,22 @@ bool Workers::start(xmrig::Controller *controller)
     m_threadsCount = threads.size();
     m_hashrate = new Hashrate(m_threadsCount, controller);
 
-    uv_mutex_init(&m_mutex);
     uv_rwlock_init(&m_rwlock);
+    uv_mutex_init(&m_switchMutex);
 
     m_sequence = 1;
     m_paused   = 1;
 
+    m_snapshotReaders = 0;
+    m_snapshot        = new JobSnapshot(xmrig::Job(), m_epoch, false);
+
     uv_async_init(uv_default_loop(), &m_async, Workers::onResult);
 
+    m_verifyThreads = verifyThreads(controller->config()->verifyThreads());
+    for (size_t i = m_batons.size(); i < m_verifyThreads; ++i) {
+        m_batons.push_back(new JobBaton());
+    }
+
     std::vector<GpuContext *> contexts(m_threadsCount);
 
     const bool isCNv2 = controller->config()->isCNv2();
@@ -423,6 +551,10 @@ bool Workers::start(xmrig::Controller *controller)
         contexts[i] = thread->ctx();
     }
 
+    m_failed      = 0;
+    m_initialized = 0;
+    m_initTime    = xmrig::steadyTimestamp();
+
     if (InitOpenCL(contexts, controller->config(), &m_opencl_ctx) != 0) {
         return false;
     }
@@ -432,6 +564,9 @@ bool Workers::start(xmrig::Controller *controller)
 
     uint32_t offset = 0;
 
+    // The API may look up workers from its own thread, the list must never reallocate
+    m_workers.reserve(m_threadsCount);
+
     size_t i = 0;
     for (xmrig::IThread *t: threads) {
         Handle *handle = new Handle(i, t, contexts[i], offset, ways);
@@ -455,6 +590,16 @@ bool Workers::start(xmrig::Controller *controller)
         handle->start(Workers::onReady);
     }
 
+    std::vector<GpuContext *> cards;
+    for (GpuContext *ctx : contexts) {
+        if (std::find_if(cards.begin(), cards.end(), [ctx](const GpuContext *card) { return card->deviceIdx == ctx->deviceIdx; }) == cards.end()) {
+            cards.push_back(ctx);
+        }
+    }
+
+    GpuSensors::start(cards, controller->config()->sysfsRoot());
+    m_thermal = new Thermal(m_workers);
+
     controller->save();
 
     return true;
@@ -464,6 +609,14 @@ bool Workers::start(xmrig::Controller *controller)
 void Workers::stop()
 {
     uv_timer_stop(&m_timer);
+
+    delete m_autotune;
+    m_autotune = nullptr;
+
+    delete m_thermal;
+    m_thermal = nullptr;
+
+    GpuSensors::stop();
     m_hashrate->stop();
 
     uv_close(reinterpret_cast<uv_handle_t*>(&m_async), nullptr);
@@ -475,15 +628,51 @@ void Workers::stop()
         ReleaseOpenCl(m_workers[i]->ctx());
     }
 
+    OclCache::release();
     ReleaseOpenClContext(m_opencl_ctx);
+
+    ShareQueue::Share share;
+    while (m_shares.pop(share)) {
+        share.snapshot->release();
+    }
+
+    m_contexts.release();
+
+    publish(nullptr);
 }
 
 
-void Workers::submit(const xmrig::Job &result)
+// Readers between loading the pointer and retaining the snapshot are counted, the previous snapshot
+// can only be released once none of them is left, so readers never block and never see a freed job
+void Workers::publish(const JobSnapshot *snapshot)
 {
-    uv_mutex_lock(&m_mutex);
-    m_queue.push_back(result);
-    uv_mutex_unlock(&m_mutex);
+    const JobSnapshot *previous = m_snapshot.exchange(snapshot);
+
+    while (m_snapshotReaders.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    if (previous) {
+        previous->release();
+    }
+}
+
+
+void Workers::submit(const JobSnapshot *snapshot, uint32_t nonce, size_t threadId)
+{
+    const ShareQueue::Share share = { snapshot, nonce, static_cast<uint32_t>(threadId) };
+    snapshot->retain();
+
+    // The ring only fills up if the main loop stalls, wait for it rather than drop the share
+    while (!m_shares.push(share)) {
+        if (sequence() == 0) {
+            snapshot->release();
+            return;
+        }
+
+        uv_async_send(&m_async);
+        std::this_thread::yield();
+    }
 
     uv_async_send(&m_async);
 }
@@ -509,10 +698,40 @@ void Workers::threadsSummary(rapidjson::Document &doc)
 #endif
 
 
+void Workers::onDeviceReady(bool ready)
+{
+    if (!ready) {
+        m_failed++;
+    }
+
+    if (++m_initialized != m_threadsCount) {
+        return;
+    }
+
+    const bool isColors = m_controller->config()->isColors();
+
+    LOG_INFO(isColors ? WHITE_BOLD("%zu") " of " WHITE_BOLD("%zu") " GPU threads ready, elapsed time " WHITE_BOLD("%.3fs") :
+                        "%zu of %zu GPU threads ready, elapsed time %.3fs", m_threadsCount - m_failed.load(), m_threadsCount, (xmrig::steadyTimestamp() - m_initTime) / 1000.0);
+
+    if (OclCache::sharedCount() > 0) {
+        LOG_INFO(isColors ? WHITE_BOLD("%zu") " of " WHITE_BOLD("%zu") " programs shared, startup time saved " WHITE_BOLD("%.3fs") :
+                            "%zu of %zu programs shared, startup time saved %.3fs", OclCache::sharedCount(), m_threadsCount, OclCache::savedTime() / 1000.0);
+    }
+}
+
+
 void Workers::onReady(void *arg)
 {
     auto handle = static_cast<Handle*>(arg);
 
+    if (InitOpenCLDevice(handle->ctx(), m_controller->config()) != OCL_ERR_SUCCESS) {
+        LOG_ERR("GPU #%zu initialization failed, thread #%zu disabled", handle->ctx()->deviceIdx, handle->threadId());
+        onDeviceReady(false);
+        return;
+    }
+
+    onDeviceReady(true);
+
     IWorker *worker = new OclWorker(handle);
     handle->setWorker(worker);
 
@@ -520,70 +739,141 @@ void Workers::onReady(void *arg)
 }
 
 
+// Hands queued shares to idle verification slots, each share is submitted as soon as its own check is done
+void Workers::verify()
+{
+    while (!m_batons.empty()) {
+        JobBaton *baton = m_batons.back();
+        if (!m_shares.pop(baton->share)) {
+            return;
+        }
+
+        m_batons.pop_back();
+        baton->valid = false;
+
+        uv_queue_work(uv_default_loop(), &baton->request, Workers::onVerify, Workers::onVerified);
+    }
+}
+
+
 void Workers::onResult(uv_async_t *handle)
 {
-    JobBaton *baton = new JobBaton();
+    verify();
+}
+
+
+// Runs on a threadpool thread, every in-flight share has its own scratchpad from the pool
+void Workers::onVerify(uv_work_t *req)
+{
+    JobBaton *baton      = static_cast<JobBaton*>(req->data);
+    const uint64_t start = uv_hrtime();
+
+    xmrig::Job job(baton->share.snapshot->job());
+    *job.nonce() = baton->share.nonce;
+    job.setThreadId(static_cast<int>(baton->share.threadId));
 
-    uv_mutex_lock(&m_mutex);
-    while (!m_queue.empty()) {
-        baton->jobs.push_back(std::move(m_queue.front()));
-        m_queue.pop_front();
+    ContextPool::Entry *entry = m_contexts.checkout(job.algorithm().algo());
+
+    xmrig::JobResult result(job);
+    if (CryptoNight::hash(job, result, entry->ctx)) {
+        baton->result = result;
+        baton->valid  = true;
     }
-    uv_mutex_unlock(&m_mutex);
 
-    uv_queue_work(uv_default_loop(), &baton->request,
-        [](uv_work_t* req) {
-            JobBaton *baton = static_cast<JobBaton*>(req->data);
-            if (baton->jobs.empty()) {
-                return;
-            }
+    m_contexts.checkin(entry);
 
-            cryptonight_ctx *ctx;
-            MemInfo info = Mem::create(&ctx, baton->jobs[0].algorithm().algo(), 1);
+    baton->elapsed = uv_hrtime() - start;
+}
 
-            for (const xmrig::Job &job : baton->jobs) {
-                xmrig::JobResult result(job);
 
-                if (CryptoNight::hash(job, result, ctx)) {
-                    baton->results.push_back(result);
-                }
-                else {
-                    baton->errors++;
-                }
-            }
+void Workers::onVerified(uv_work_t *req, int status)
+{
+    JobBaton *baton = static_cast<JobBaton*>(req->data);
 
-            Mem::release(&ctx, 1, info);
-        },
-        [](uv_work_t* req, int status) {
-            JobBaton *baton = static_cast<JobBaton*>(req->data);
+    m_verifyCount++;
+    m_verifyTime += baton->elapsed;
 
-            for (const xmrig::JobResult &result : baton->results) {
-                m_listener->onJobResult(result);
-            }
+    if (baton->valid) {
+        m_listener->onJobResult(baton->result);
+    }
+    else if (status == 0) {
+        LOG_ERR("THREAD #%u COMPUTE ERROR", baton->share.threadId);
+    }
 
-            if (baton->errors > 0 && !baton->jobs.empty()) {
-                LOG_ERR("THREAD #%d COMPUTE ERROR", baton->jobs[0].threadId());
-            }
+    baton->share.snapshot->release();
+    m_batons.push_back(baton);
 
-            delete baton;
-        }
-    );
+    verify();
 }
 
 
 void Workers::onTick(uv_timer_t *handle)
 {
+    size_t running = 0;
+
     for (Handle *handle : m_workers) {
-        if (!handle->worker()) {
-            return;
+        IWorker *worker = handle->worker();
+        if (!worker) {
+            continue;
         }
 
-        m_hashrate->add(handle->threadId(), handle->worker()->hashCount(), handle->worker()->timestamp());
+        m_hashrate->add(handle->threadId(), worker->hashCount(), worker->timestamp());
+
+        if (!worker->isDisabled()) {
+            running++;
+        }
     }
 
     if ((m_ticks++ & 0xF) == 0)  {
         m_hashrate->updateHighest();
     }
+
+    m_thermal->tick(xmrig::steadyTimestamp());
+
+    // Reported once every running thread has moved over, the time is what each GPU spent between the two jobs
+    uv_mutex_lock(&m_switchMutex);
+
+    const size_t switched = m_switchThreads;
+    const uint64_t us     = m_switchTime;
+    const bool complete   = switched > 0 && switched >= running;
+
+    if (complete) {
+        m_switchEpoch   = UINT64_MAX;
+        m_switchThreads = 0;
+        m_switchTime    = 0;
+    }
+
+    uv_mutex_unlock(&m_switchMutex);
+
+    if (complete) {
+        const JobSnapshot *snapshot = Workers::snapshot();
+
+        LOG_INFO("switch to %s lost %.2f ms of hashing per GPU thread, %.2f ms in total",
+                 snapshot->job().poolId() == -1 ? "dev donate" : "user pool", us / 1000.0 / switched, us / 1000.0);
+
+        snapshot->release();
+    }
+
+    if (m_autotune) {
+        if (m_autotune->tick(isPaused() || !m_enabled)) {
+            delete m_autotune;
+            m_autotune = nullptr;
+        }
+
+        return;
+    }
+
+    if (!m_autotuneRequested && (m_autotuned || !m_controller->config()->isOclAutotune())) {
+        return;
+    }
+
+    if (m_initialized != m_threadsCount || m_failed == m_threadsCount || !m_active || isPaused()) {
+        return;
+    }
+
+    m_autotuneRequested = false;
+    m_autotuned         = true;
+    m_autotune          = new Autotune(m_controller, m_hashrate, m_workers);
 }
 
 
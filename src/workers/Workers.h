@@ -27,7 +27,6 @@
 
 
 #include <atomic>
-#include <list>
 #include <uv.h>
 #include <vector>
 
@@ -40,14 +39,21 @@
 #include "common/net/Job.h"
 #include "net/JobResult.h"
 #include "rapidjson/fwd.h"
+#include "workers/ContextPool.h"
+#include "workers/ShareQueue.h"
 
 
+class Autotune;
 class Handle;
+class Thermal;
 class Hashrate;
 class IWorker;
+class JobSnapshot;
+struct JobBaton;
 
 
 namespace xmrig {
+    class Config;
     class Controller;
     class IJobResultListener;
 }
@@ -56,17 +62,22 @@ namespace xmrig {
 class Workers
 {
 public:
-    static xmrig::Job job();
+    static const JobSnapshot *snapshot();
+    static bool setIntensity(size_t threadId, size_t intensity);
     static size_t hugePages();
+    static size_t intensity(size_t threadId);
     static size_t threads();
+    static void addSwitchTime(uint64_t epoch, int64_t us);
+    static void initThreadpool(int verifyThreads);
     static void printHashrate(bool detail);
     static void printHealth();
+    static void requestAutotune();
     static void setEnabled(bool enabled);
     static void setJob(const xmrig::Job &job, bool donate);
     static bool start(xmrig::Controller *controller);
     static void stop();
 
-    static void submit(const xmrig::Job &result);
+    static void submit(const JobSnapshot *snapshot, uint32_t nonce, size_t threadId);
   
     static void setMaxtemp(int maxtemp);
     static void setFalloff(int falloff);
@@ -75,10 +86,14 @@ public:
     static inline int falloff() { return m_falloff; }
     static inline int fanlevel() { return m_fanlevel; }
 
+    static xmrig::Config *config();
+
     static inline bool isEnabled()                                      { return m_enabled; }
     static inline bool isOutdated(uint64_t sequence)                    { return m_sequence.load(std::memory_order_relaxed) != sequence; }
     static inline bool isPaused()                                       { return m_paused.load(std::memory_order_relaxed) == 1; }
     static inline Hashrate *hashrate()                                  { return m_hashrate; }
+    static inline int64_t jobTimestamp()                                { return m_jobTimestamp; }
+    static inline uint64_t jobLatency()                                 { return m_jobLatency; }
     static inline uint64_t sequence()                                   { return m_sequence.load(std::memory_order_relaxed); }
     static inline void pause()                                          { m_active = false; m_paused = 1; m_sequence++; }
     static inline void setListener(xmrig::IJobResultListener *listener) { m_listener = listener; }
@@ -90,22 +105,45 @@ public:
 #   endif
 
 private:
+    static void onDeviceReady(bool ready);
+    static void publish(const JobSnapshot *snapshot);
     static void onReady(void *arg);
     static void onResult(uv_async_t *handle);
+    static void onVerified(uv_work_t *req, int status);
+    static void onVerify(uv_work_t *req);
     static void onTick(uv_timer_t *handle);
     static void start(IWorker *worker);
+    static void verify();
 
+    static Autotune *m_autotune;
     static bool m_active;
+    static bool m_autotuned;
+    static std::atomic<bool> m_autotuneRequested;
+    static ContextPool m_contexts;
     static bool m_enabled;
     static Hashrate *m_hashrate;
     static size_t m_threadsCount;
+    static size_t m_verifyThreads;
+    static std::atomic<size_t> m_failed;
+    static std::atomic<size_t> m_initialized;
+    static int64_t m_initTime;
+    static int64_t m_jobTimestamp;
+    static uint64_t m_jobLatency;
+    static uint64_t m_jobReceived;
     static std::atomic<int> m_paused;
+    static size_t m_switchThreads;
+    static uint64_t m_switchEpoch;
+    static uint64_t m_switchTime;
     static std::atomic<uint64_t> m_sequence;
-    static std::list<xmrig::Job> m_queue;
+    static ShareQueue m_shares;
+    static Thermal *m_thermal;
     static std::vector<Handle*> m_workers;
+    static std::vector<JobBaton*> m_batons;
     static uint64_t m_ticks;
+    static uint64_t m_verifyCount;
+    static uint64_t m_verifyTime;
     static uv_async_t m_async;
-    static uv_mutex_t m_mutex;
+    static uv_mutex_t m_switchMutex;
     static uv_rwlock_t m_rwlock;
     static uv_timer_t m_timer;
     static xmrig::Controller *m_controller;
@@ -115,7 +153,9 @@ private:
     static int m_fanlevel;
 
     static xmrig::IJobResultListener *m_listener;
-    static xmrig::Job m_job;
+    static std::atomic<const JobSnapshot *> m_snapshot;
+    static std::atomic<int> m_snapshotReaders;
+    static uint64_t m_epoch;
 };
 
 